@@ -1,26 +1,47 @@
 @echo off
 setlocal
 
+rem Pass nopause when running from a build step
+
 if not defined VULKAN_SDK (
     echo Error: VULKAN_SDK environment variable is not set.
     exit /b 1
 )
 
+set GENERATED_DIR=.\Tempus\src\Tempus\Renderer\Shaders\Generated
+
 if not exist ".\bin\shaders" (
     mkdir .\bin\shaders
 )
 
-"%VULKAN_SDK%\Bin\glslc.exe" .\Tempus\res\shaders\shader.vert -o .\bin\shaders\vert.spv
+if not exist "%GENERATED_DIR%" (
+    mkdir "%GENERATED_DIR%"
+)
+
+call :compile shader.vert vert "vertex shader" || exit /b 1
+call :compile shader.frag frag "fragment shader" || exit /b 1
+call :compile scene.vert scene_vert "scene vertex shader" || exit /b 1
+call :compile scene.frag scene_frag "scene fragment shader" || exit /b 1
+call :compile cull.comp cull_comp "culling compute shader" || exit /b 1
+call :compile batch.vert batch_vert "batch vertex shader" || exit /b 1
+call :compile batch.frag batch_frag "batch fragment shader" || exit /b 1
+
+echo Successfully compiled shaders.
+if /i not "%~1"=="nopause" PAUSE
+exit /b 0
+
+rem Compiles a shader to bin\shaders for hot reload and to a word list that is embedded in the engine
+:compile
+"%VULKAN_SDK%\Bin\glslc.exe" --target-env=vulkan1.3 .\Tempus\res\shaders\%1 -o .\bin\shaders\%2.spv
 if %errorlevel% neq 0 (
-    echo Error: Failed to compile vertex shader.
+    echo Error: Failed to compile %~3.
     exit /b 1
 )
 
-"%VULKAN_SDK%\Bin\glslc.exe" .\Tempus\res\shaders\shader.frag -o .\bin\shaders\frag.spv
+"%VULKAN_SDK%\Bin\glslc.exe" --target-env=vulkan1.3 -mfmt=num .\Tempus\res\shaders\%1 -o "%GENERATED_DIR%\%2.spv.inc"
 if %errorlevel% neq 0 (
-    echo Error: Failed to compile fragment shader.
+    echo Error: Failed to embed %~3.
     exit /b 1
 )
 
-echo Successfully compiled shaders.
-PAUSE
\ No newline at end of file
+exit /b 0
@@ -3,9 +3,23 @@ if [ -z "$VULKAN_SDK" ]; then
     exit 1
 fi
 
+GENERATED_DIR=./Tempus/src/Tempus/Renderer/Shaders/Generated
+
 mkdir -p ./bin/shaders
+mkdir -p "$GENERATED_DIR"
+
+# Compiles a shader to bin/shaders for hot reload and to a word list that is embedded in the engine
+compile() {
+    "$VULKAN_SDK/bin/glslc" --target-env=vulkan1.3 "./Tempus/res/shaders/$1" -o "./bin/shaders/$2.spv" || exit 1
+    "$VULKAN_SDK/bin/glslc" --target-env=vulkan1.3 -mfmt=num "./Tempus/res/shaders/$1" -o "$GENERATED_DIR/$2.spv.inc" || exit 1
+}
 
-"$VULKAN_SDK/bin/glslc" ./Tempus/res/shaders/shader.vert -o ./bin/shaders/vert.spv
-"$VULKAN_SDK/bin/glslc" ./Tempus/res/shaders/shader.frag -o ./bin/shaders/frag.spv
+compile shader.vert vert
+compile shader.frag frag
+compile scene.vert scene_vert
+compile scene.frag scene_frag
+compile cull.comp cull_comp
+compile batch.vert batch_vert
+compile batch.frag batch_frag
 
-echo "Successfully compiled shaders."
\ No newline at end of file
+echo "Successfully compiled shaders."
@@ -1,8 +1,127 @@
 // Copyright Levi Spevakow (C) 2025
 
 #include "Tempus.h"
+#include "Tempus/Renderer.h"
 
 #include <random>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+namespace {
+
+	// Column major a * b
+	void Multiply(const float a[16], const float b[16], float out[16])
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				out[c * 4 + r] = a[0 * 4 + r] * b[c * 4 + 0] + a[1 * 4 + r] * b[c * 4 + 1] + a[2 * 4 + r] * b[c * 4 + 2] + a[3 * 4 + r] * b[c * 4 + 3];
+			}
+		}
+	}
+
+	// Right handed perspective with Y flipped into Vulkan's clip space and a [0, 1] depth range
+	void Perspective(float fovY, float aspect, float zNear, float zFar, float out[16])
+	{
+		float f = 1.0f / std::tan(fovY * 0.5f);
+
+		for (int i = 0; i < 16; i++)
+		{
+			out[i] = 0.0f;
+		}
+
+		out[0] = f / aspect;
+		out[5] = -f;
+		out[10] = zFar / (zNear - zFar);
+		out[11] = -1.0f;
+		out[14] = (zNear * zFar) / (zNear - zFar);
+	}
+
+	void LookAt(const float eye[3], const float target[3], float out[16])
+	{
+		float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+		float length = std::sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+		for (float& v : forward) v /= length;
+
+		// Up is +Y
+		float right[3] = { -forward[2], 0.0f, forward[0] };
+		length = std::sqrt(right[0] * right[0] + right[2] * right[2]);
+		for (float& v : right) v /= length;
+
+		float up[3] = { right[1] * forward[2] - right[2] * forward[1], right[2] * forward[0] - right[0] * forward[2], right[0] * forward[1] - right[1] * forward[0] };
+
+		float view[16] =
+		{
+			right[0], up[0], -forward[0], 0.0f,
+			right[1], up[1], -forward[1], 0.0f,
+			right[2], up[2], -forward[2], 0.0f,
+			-(right[0] * eye[0] + right[1] * eye[1] + right[2] * eye[2]),
+			-(up[0] * eye[0] + up[1] * eye[1] + up[2] * eye[2]),
+			forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2],
+			1.0f
+		};
+
+		for (int i = 0; i < 16; i++)
+		{
+			out[i] = view[i];
+		}
+	}
+
+	// Works with anything that stores meshes the way GPUScene does, eg. the batch renderer
+	template<typename MeshStorage>
+	uint32_t AddCubeMesh(MeshStorage& storage)
+	{
+		// Per face normal, corners counter clockwise seen from outside
+		const float normals[6][3] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+
+		std::vector<Tempus::GPUVertex> vertices;
+		std::vector<uint32_t> indices;
+
+		for (const auto& n : normals)
+		{
+			// Two axes spanning the face, ordered so that u x v points along the normal
+			float u[3] = { n[1], n[2], n[0] };
+			float v[3] = { n[1] * u[2] - n[2] * u[1], n[2] * u[0] - n[0] * u[2], n[0] * u[1] - n[1] * u[0] };
+
+			uint32_t base = static_cast<uint32_t>(vertices.size());
+			const float corners[4][2] = { {-1,-1}, {1,-1}, {1,1}, {-1,1} };
+
+			for (const auto& corner : corners)
+			{
+				Tempus::GPUVertex vertex{};
+				for (int axis = 0; axis < 3; axis++)
+				{
+					vertex.Position[axis] = 0.5f * (n[axis] + corner[0] * u[axis] + corner[1] * v[axis]);
+					vertex.Normal[axis] = n[axis];
+				}
+				vertices.push_back(vertex);
+			}
+
+			indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+		}
+
+		return storage.AddMesh(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+
+	// Unit quad facing +Z, standing in for a sprite
+	uint32_t AddQuadMesh(Tempus::BatchRenderer& batches)
+	{
+		Tempus::GPUVertex vertices[4] =
+		{
+			{ { -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ {  0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ {  0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } },
+			{ { -0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f } }
+		};
+
+		uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+		return batches.AddMesh(vertices, 4, indices, 6);
+	}
+
+}
 
 class SandBox : public Tempus::Application
 {
@@ -10,19 +129,29 @@ public:
 
 	SandBox() 
 	{
+		GetEventDispatcher().Subscribe<Tempus::WindowResizeEvent, &SandBox::OnWindowResize>(this);
 	}
 
 	~SandBox() 
 	{
 	}
 
-	virtual void Update() override
+	virtual void FixedUpdate(double timeStep) override
 	{
-		SDL_Event event = GetCurrentEvent();
+		m_PreviousStressAngle = m_StressAngle;
+		m_StressAngle += STRESS_ANGULAR_SPEED * static_cast<float>(timeStep);
+	}
 
-		if (event.type == SDL_KEYDOWN)
+	virtual void Update() override
+	{
+		for (const Tempus::InputEvent& event : GetInputEvents())
 		{
-			if (event.key.keysym.scancode == SDL_SCANCODE_A)
+			if (event.Type != Tempus::InputEventType::KeyPressed)
+			{
+				continue;
+			}
+
+			if (event.Key.Scancode == SDL_SCANCODE_A)
 			{
 
 				TPS_WARN("Colour Change!");
@@ -34,9 +163,241 @@ public:
 				SetRenderColor(dis(gen), dis(gen), dis(gen), 255);
 
 			}
+			else if (event.Key.Scancode == SDL_SCANCODE_B)
+			{
+				RunRecordingBenchmark(100000);
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_K)
+			{
+				RunSortBenchmark(1000000);
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_G)
+			{
+				SpawnCubeGrid();
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_S)
+			{
+				CycleBatchStress();
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_I)
+			{
+				RunInputLatencyBenchmark(256);
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_E)
+			{
+				RunEventBenchmark(1000000);
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_J)
+			{
+				RunJobBenchmark(1000000, 10000000);
+			}
+			else if (event.Key.Scancode == SDL_SCANCODE_M)
+			{
+				RunAllocatorBenchmark(500000);
+			}
+		}
+
+		if (m_StressCount > 0)
+		{
+			SubmitBatchStress();
+		}
+	}
+
+private:
+
+	void OnWindowResize(const Tempus::WindowResizeEvent& event)
+	{
+		TPS_INFO("Window resized to {0}x{1}", event.Width, event.Height);
+	}
+
+	// Cycles the GPU driven cube grid through 0, 1k, 100k and 1M instances
+	void SpawnCubeGrid()
+	{
+		static const uint32_t counts[] = { 0, 1000, 100000, 1000000 };
+		m_GridStep = (m_GridStep + 1) % 4;
+		uint32_t count = counts[m_GridStep];
+
+		// The scene belongs to the render thread while it runs
+		GetRenderer().FlushRenderThread();
+		Tempus::GPUScene& scene = GetRenderer().GetScene();
+
+		if (m_CubeMesh == Tempus::GPUScene::INVALID_INDEX)
+		{
+			m_CubeMesh = AddCubeMesh(scene);
+		}
+
+		scene.ClearInstances();
+
+		uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(count))));
+		float offset = (side - 1) * SPACING * 0.5f;
+
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<float> colour(0.2f, 1.0f);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			Tempus::GPUInstance instance;
+			instance.Position[0] = (i % side) * SPACING - offset;
+			instance.Position[1] = ((i / side) % side) * SPACING - offset;
+			instance.Position[2] = (i / (side * side)) * SPACING - offset;
+			instance.Colour[0] = colour(gen);
+			instance.Colour[1] = colour(gen);
+			instance.Colour[2] = colour(gen);
+			instance.Mesh = m_CubeMesh;
+			scene.AddInstance(instance);
+		}
+
+		// Looking into the grid from one corner, so most of it lies outside the frustum
+		float eye[3] = { offset + 10.0f, offset * 0.5f + 5.0f, offset + 10.0f };
+		float target[3] = { 0.0f, 0.0f, 0.0f };
+		float view[16], projection[16], viewProjection[16];
+		LookAt(eye, target, view);
+		Perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f, projection);
+		Multiply(projection, view, viewProjection);
+		scene.SetViewProjection(viewProjection);
+
+		TPS_WARN("Cube grid: {0} instances", count);
+	}
+
+	// Cycles the batch renderer stress scene through 0, 10k, 100k and 1M instances
+	void CycleBatchStress()
+	{
+		static const uint32_t counts[] = { 0, 10000, 100000, 1000000 };
+		m_StressStep = (m_StressStep + 1) % 4;
+		m_StressCount = counts[m_StressStep];
+
+		GetRenderer().FlushRenderThread();
+		Tempus::BatchRenderer& batches = GetRenderer().GetBatches();
+
+		if (m_StressMeshes[0] == Tempus::BatchRenderer::INVALID_INDEX)
+		{
+			m_StressMeshes[0] = AddCubeMesh(batches);
+			m_StressMeshes[1] = AddQuadMesh(batches);
+
+			// Two opaque materials and two blended ones, which are two sided so the quads show from behind
+			const float colours[4][4] = { { 0.9f, 0.3f, 0.2f, 1.0f }, { 0.2f, 0.8f, 0.3f, 1.0f }, { 0.3f, 0.5f, 1.0f, 0.5f }, { 1.0f, 0.8f, 0.2f, 0.6f } };
+			const Tempus::BlendMode blends[4] = { Tempus::BlendMode::Opaque, Tempus::BlendMode::Opaque, Tempus::BlendMode::Alpha, Tempus::BlendMode::Additive };
+
+			for (int i = 0; i < 4; i++)
+			{
+				Tempus::BatchMaterial material;
+				std::copy(colours[i], colours[i] + 4, material.Colour);
+				material.Blend = blends[i];
+				material.bTwoSided = blends[i] != Tempus::BlendMode::Opaque;
+				m_StressMaterials[i] = batches.AddMaterial(material);
+			}
 		}
+
+		uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(m_StressCount))));
+		float offset = (side - 1) * STRESS_SPACING * 0.5f;
+
+		float eye[3] = { offset * 1.5f + 5.0f, offset + 5.0f, offset * 1.5f + 5.0f };
+		float target[3] = { 0.0f, 0.0f, 0.0f };
+		float view[16], projection[16], viewProjection[16];
+		LookAt(eye, target, view);
+		Perspective(1.0f, 16.0f / 9.0f, 0.1f, 1000.0f, projection);
+		Multiply(projection, view, viewProjection);
+		GetRenderer().SetViewProjection(viewProjection);
+
+		m_StressFrames = 0;
+		m_StressSubmitTime = 0.0;
+		m_StressFrameTime = 0.0;
+		m_LastStressFrame = {};
+
+		TPS_WARN("Batch stress: {0} instances", m_StressCount);
 	}
 
+	// Resubmits every instance with this frame's rotation, then logs draw calls and CPU times about once a second
+	void SubmitBatchStress()
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		Tempus::Renderer& renderer = GetRenderer();
+
+		uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(m_StressCount))));
+		float offset = (side - 1) * STRESS_SPACING * 0.5f;
+
+		// Consecutive ranges of the grid share a mesh and material, one group per pair
+		uint32_t groupSize = (m_StressCount + STRESS_GROUPS - 1) / STRESS_GROUPS;
+
+		// Drawn between the last two ticks, so the spin is smooth at any frame rate
+		float alpha = static_cast<float>(GetFrameClock().GetInterpolationAlpha());
+		float baseAngle = m_PreviousStressAngle + (m_StressAngle - m_PreviousStressAngle) * alpha;
+
+		for (uint32_t group = 0; group < STRESS_GROUPS; group++)
+		{
+			uint32_t mesh = m_StressMeshes[group % 2];
+			uint32_t material = m_StressMaterials[group / 2];
+
+			// Spinning around Y, each group at its own phase
+			float angle = baseAngle + group * 0.4f;
+			Tempus::BatchTransform transform;
+			transform.Rows[0][0] = std::cos(angle);
+			transform.Rows[0][2] = std::sin(angle);
+			transform.Rows[2][0] = -std::sin(angle);
+			transform.Rows[2][2] = std::cos(angle);
+
+			uint32_t end = std::min(m_StressCount, (group + 1) * groupSize);
+
+			for (uint32_t i = group * groupSize; i < end; i++)
+			{
+				transform.Rows[0][3] = (i % side) * STRESS_SPACING - offset;
+				transform.Rows[1][3] = ((i / side) % side) * STRESS_SPACING - offset;
+				transform.Rows[2][3] = (i / (side * side)) * STRESS_SPACING - offset;
+				renderer.Submit(mesh, material, transform);
+			}
+		}
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		// Start to start of consecutive submissions, which covers the whole CPU frame
+		if (m_LastStressFrame.time_since_epoch().count() != 0)
+		{
+			m_StressSubmitTime += std::chrono::duration<double, std::milli>(end - start).count();
+			m_StressFrameTime += std::chrono::duration<double, std::milli>(start - m_LastStressFrame).count();
+			m_StressFrames++;
+		}
+
+		m_LastStressFrame = start;
+
+		if (m_StressFrameTime >= 1000.0)
+		{
+			// The stats are the render thread's, a stall once a second is fine for logging
+			renderer.FlushRenderThread();
+			const Tempus::BatchStats& stats = renderer.GetBatches().GetStats();
+			const Tempus::RenderQueueStats& queueStats = renderer.GetBatches().GetQueueStats();
+
+			TPS_INFO("Batch stress: {0} instances in {1} draw calls, submit {2:.3f} ms, frame {3:.3f} ms", stats.InstanceCount,
+				stats.DrawCount, m_StressSubmitTime / m_StressFrames, m_StressFrameTime / m_StressFrames);
+			TPS_INFO("\tPipeline binds {0} ({1} avoided), material binds {2} ({3} avoided), sort {4:.3f} ms", queueStats.PipelineBinds,
+				queueStats.PipelineBindsAvoided, queueStats.MaterialBinds, queueStats.MaterialBindsAvoided, queueStats.SortMilliseconds);
+
+			m_StressFrames = 0;
+			m_StressSubmitTime = 0.0;
+			m_StressFrameTime = 0.0;
+		}
+	}
+
+	static constexpr float SPACING = 3.0f;
+	uint32_t m_CubeMesh = Tempus::GPUScene::INVALID_INDEX;
+	uint32_t m_GridStep = 0;
+
+	static constexpr float STRESS_SPACING = 1.5f;
+	static constexpr uint32_t STRESS_GROUPS = 8;
+	// Radians per second, what 0.02 a frame was at 60 FPS
+	static constexpr float STRESS_ANGULAR_SPEED = 1.2f;
+	uint32_t m_StressMeshes[2] = { Tempus::BatchRenderer::INVALID_INDEX, Tempus::BatchRenderer::INVALID_INDEX };
+	uint32_t m_StressMaterials[4] = {};
+	uint32_t m_StressStep = 0;
+	uint32_t m_StressCount = 0;
+	float m_StressAngle = 0.0f;
+	float m_PreviousStressAngle = 0.0f;
+
+	uint32_t m_StressFrames = 0;
+	double m_StressSubmitTime = 0.0;
+	double m_StressFrameTime = 0.0;
+	std::chrono::high_resolution_clock::time_point m_LastStressFrame;
+
 };
 
 Tempus::Application* Tempus::CreateApplication()
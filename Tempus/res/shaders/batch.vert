@@ -0,0 +1,38 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+// Rows of a 3x4 affine transform, matches BatchTransform
+struct Instance {
+    vec4 row0;
+    vec4 row1;
+    vec4 row2;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
+    vec4 colour;
+    InstanceBuffer instanceBuffer;
+} pc;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    // firstInstance of each batch's draw points at its first instance
+    Instance instance = pc.instanceBuffer.instances[gl_InstanceIndex];
+    mat4x3 model = transpose(mat3x4(instance.row0, instance.row1, instance.row2));
+
+    vec3 worldPosition = model * vec4(inPosition, 1.0);
+    gl_Position = pc.viewProjection * vec4(worldPosition, 1.0);
+
+    // Assumes uniform scale
+    vec3 worldNormal = normalize(mat3(model) * inNormal);
+    float diffuse = abs(dot(worldNormal, normalize(vec3(0.4, 0.8, 0.3))));
+    fragColor = vec4(pc.colour.rgb * (0.3 + 0.7 * diffuse), pc.colour.a);
+}
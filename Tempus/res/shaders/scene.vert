@@ -0,0 +1,35 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+
+struct Instance {
+    vec4 positionScale;
+    vec4 colour;
+    uint mesh;
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
+    InstanceBuffer instanceBuffer;
+} pc;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    Instance instance = pc.instanceBuffer.instances[gl_InstanceIndex];
+
+    vec3 worldPosition = inPosition * instance.positionScale.w + instance.positionScale.xyz;
+    gl_Position = pc.viewProjection * vec4(worldPosition, 1.0);
+
+    float diffuse = max(dot(normalize(inNormal), normalize(vec3(0.4, 0.8, 0.3))), 0.0);
+    fragColor = instance.colour.rgb * (0.3 + 0.7 * diffuse);
+}
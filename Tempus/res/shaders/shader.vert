@@ -2,6 +2,12 @@
 
 layout(location = 0) out vec3 fragColor;
 
+// Written each frame through the uniform allocator, matches FrameConstants of Renderer.h
+layout(set = 0, binding = 0) uniform FrameConstants {
+    vec2 scale;
+    vec2 offset;
+} frame;
+
 vec2 positions[3] = vec2[](
     vec2(0.0, -0.5),
     vec2(0.5, 0.5),
@@ -15,6 +21,6 @@ vec3 colors[3] = vec3[](
 );
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
+    gl_Position = vec4(positions[gl_VertexIndex] * frame.scale + frame.offset, 0.0, 1.0);
     fragColor = colors[gl_VertexIndex];
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 // Copyright Levi Spevakow (C) 2025
 
 #include "Application.h"
-#include <thread>
 #include "Log.h"
 #include <random>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
 
 #include "Window.h"
 #include "Renderer.h"
@@ -13,7 +16,7 @@
 
 namespace Tempus {
 
-	Application::Application() : CurrentEvent(SDL_Event())
+	Application::Application()
 	{
 		m_Window = new Window();
 		m_Renderer = new Renderer();
@@ -33,6 +36,9 @@ namespace Tempus {
 		FileUtils::SetWorkingDirectory(FileUtils::GetExecutablePath());
 		FileUtils::SetWorkingDirectory("../../../");
 
+		m_Jobs.Init();
+		TPS_CORE_INFO("Job system running on {0} threads", m_Jobs.GetThreadCount());
+
 		// SDL Initialization
 		if (!InitSDL()) 
 		{
@@ -40,7 +46,7 @@ namespace Tempus {
 		}
 
 		// Window creation
-		if (!InitWindow()) 
+		if (!m_Renderer->IsHeadless() && !InitWindow()) 
 		{
 			return;
 		}
@@ -51,6 +57,11 @@ namespace Tempus {
 			return;
 		}
 
+		if (m_Renderer->IsHeadless())
+		{
+			RunHeadless();
+		}
+
 		while (!bShouldQuit) 
 		{
 			CoreUpdate();
@@ -63,7 +74,7 @@ namespace Tempus {
 	bool Application::InitWindow()
 	{
 		// Window creation
-		if (!m_Window || !m_Window->Init("Sandbox", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 480, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI))
+		if (!m_Window || !m_Window->Init("Sandbox", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 480, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI))
 		{
 			TPS_CORE_CRITICAL("Failed to initialize window!");
 			return false;
@@ -79,7 +90,7 @@ namespace Tempus {
 	{
 
 		// Renderer creation
-		if (!m_Renderer || !m_Renderer->Init(m_Window))
+		if (!m_Renderer || !m_Renderer->Init(m_Renderer->IsHeadless() ? nullptr : m_Window))
 		{
 			TPS_CORE_CRITICAL("Failed to initialize renderer!");
 			return false;
@@ -96,7 +107,10 @@ namespace Tempus {
 	{
 		SDL_SetMainReady();
 
-		if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0)
+		bool bHeadless = m_Renderer->IsHeadless();
+
+		// Headless machines may not have a video driver at all
+		if (SDL_Init(bHeadless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0)
 		{
 			TPS_CORE_CRITICAL("Failed to initialize SDL: {0}", SDL_GetError());
 			return false;
@@ -108,7 +122,7 @@ namespace Tempus {
 		SDL_GetVersion(&version);
 		TPS_CORE_INFO("Initialized SDL version {0}.{1}.{2}", version.major, version.minor, version.patch);
 
-		if (SDL_Vulkan_LoadLibrary(nullptr)) 
+		if (!bHeadless && SDL_Vulkan_LoadLibrary(nullptr)) 
 		{
 			TPS_CORE_CRITICAL("Failed to load Vulkan library: {0}", SDL_GetError());
 			return false;
@@ -127,17 +141,195 @@ namespace Tempus {
 	void Application::CoreUpdate()
 	{
 
-		SDL_PollEvent(&CurrentEvent);
+		m_Input.BeginFrame();
+
+		SDL_Event event;
 
-		if (CurrentEvent.type == SDL_QUIT)
+		// There is nothing to present to while minimized, so block on the event queue instead of spinning
+		if (m_Window->IsMinimized() && SDL_WaitEvent(&event))
+		{
+			HandleEvent(event);
+		}
+
+		// Everything pending goes into this frame, a burst of events doesn't trickle in one per frame
+		while (SDL_PollEvent(&event))
+		{
+			HandleEvent(event);
+		}
+
+		if (m_InputBurstSize > 0)
+		{
+			MeasureInputBurst();
+		}
+
+		DispatchInputEvents();
+		m_EventDispatcher.DispatchQueued();
+
+		if (bShouldQuit || m_Window->IsMinimized())
 		{
-			bShouldQuit = true;
 			return;
 		}
 
+		// Measured after any blocking wait while minimized, which MAX_FRAME_DELTA would clamp anyway
+		m_Clock.BeginFrame();
+		RunFixedUpdates();
+
 		Update();
 		m_Renderer->Update();
 
+		m_Clock.WaitForNextFrame();
+
+	}
+
+	void Application::RunFixedUpdates()
+	{
+		for (uint32_t tick = 0; tick < m_Clock.GetFrameTickCount() && !bShouldQuit; tick++)
+		{
+			FixedUpdate(m_Clock.GetTimeStep());
+		}
+	}
+
+	void Application::RunHeadless()
+	{
+		const HeadlessConfig& config = m_Renderer->GetHeadlessConfig();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// No window means no events to poll. Frames are rendered back to back as fast as the device allows
+		for (uint32_t frame = 0; frame < config.FrameCount && !bShouldQuit; frame++)
+		{
+			if (frame + 1 == config.FrameCount && !config.CapturePath.empty())
+			{
+				m_Renderer->RequestCapture(config.CapturePath);
+			}
+
+			m_EventDispatcher.DispatchQueued();
+
+			// One tick per frame, so a run simulates the same amount of time however fast the device renders
+			m_Clock.BeginFixedFrame();
+			RunFixedUpdates();
+
+			Update();
+			m_Renderer->Update();
+		}
+
+		// The last frames may still be on the render thread, which also owns the profiler
+		m_Renderer->FlushRenderThread();
+
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		double frameTime = config.FrameCount > 0 ? elapsed / config.FrameCount : 0.0;
+
+		TPS_CORE_INFO("Headless run: {0} frames in {1:.2f} ms, {2:.3f} ms per frame ({3:.1f} FPS)", config.FrameCount, elapsed,
+			frameTime, frameTime > 0.0 ? 1000.0 / frameTime : 0.0);
+
+		for (const GPUScopeTiming& timing : m_Renderer->GetProfiler().GetTimings())
+		{
+			TPS_CORE_INFO("\tGPU {0}: {1:.3f} ms", timing.Name, timing.AverageMilliseconds);
+		}
+
+		bShouldQuit = true;
+	}
+
+	void Application::HandleEvent(const SDL_Event& event)
+	{
+		if (event.type == SDL_QUIT)
+		{
+			bShouldQuit = true;
+		}
+		else if (event.type == SDL_WINDOWEVENT)
+		{
+			OnWindowEvent(event.window);
+		}
+
+		m_Input.Push(event);
+	}
+
+	void Application::MeasureInputBurst()
+	{
+		m_InputBurstFrames++;
+		uint64_t now = SDL_GetPerformanceCounter();
+
+		for (const InputEvent& input : m_Input.GetEvents())
+		{
+			if (input.Type != InputEventType::User || input.User.Code != INPUT_BURST_CODE)
+			{
+				continue;
+			}
+
+			double latency = InputQueue::TicksToMilliseconds(now - m_InputBurstStart);
+			m_InputBurstLatency += latency;
+			m_InputBurstMaxLatency = std::max(m_InputBurstMaxLatency, latency);
+			m_InputBurstReceived++;
+		}
+
+		if (m_InputBurstReceived < m_InputBurstSize)
+		{
+			return;
+		}
+
+		TPS_CORE_INFO("Input burst: {0} events reached Update() over {1} frame(s), latency {2:.3f} ms avg, {3:.3f} ms max", m_InputBurstSize,
+			m_InputBurstFrames, m_InputBurstLatency / m_InputBurstSize, m_InputBurstMaxLatency);
+		TPS_CORE_INFO("\tPolling one event per frame would have taken {0} frames, about {1:.1f} ms at {2:.3f} ms per frame", m_InputBurstSize,
+			m_InputBurstSize * m_Renderer->GetAverageFrameTime(), m_Renderer->GetAverageFrameTime());
+
+		m_InputBurstSize = 0;
+	}
+
+	void Application::DispatchInputEvents()
+	{
+		for (const InputEvent& input : m_Input.GetEvents())
+		{
+			switch (input.Type)
+			{
+			case InputEventType::KeyPressed:
+				m_EventDispatcher.Dispatch(KeyPressedEvent{ input.Key.Keycode, input.Key.Scancode, input.Key.bRepeat });
+				break;
+			case InputEventType::KeyReleased:
+				m_EventDispatcher.Dispatch(KeyReleasedEvent{ input.Key.Keycode, input.Key.Scancode });
+				break;
+			case InputEventType::MouseMoved:
+				m_EventDispatcher.Dispatch(MouseMovedEvent{ input.MouseMove.X, input.MouseMove.Y, input.MouseMove.DeltaX, input.MouseMove.DeltaY });
+				break;
+			case InputEventType::MouseButtonPressed:
+				m_EventDispatcher.Dispatch(MouseButtonPressedEvent{ input.MouseButton.X, input.MouseButton.Y, input.MouseButton.Button });
+				break;
+			case InputEventType::MouseButtonReleased:
+				m_EventDispatcher.Dispatch(MouseButtonReleasedEvent{ input.MouseButton.X, input.MouseButton.Y, input.MouseButton.Button });
+				break;
+			case InputEventType::MouseScrolled:
+				m_EventDispatcher.Dispatch(MouseScrolledEvent{ input.MouseScroll.X, input.MouseScroll.Y });
+				break;
+			case InputEventType::WindowResized:
+				m_EventDispatcher.Dispatch(WindowResizeEvent{ input.Window.Width, input.Window.Height });
+				break;
+			case InputEventType::WindowFocusGained:
+			case InputEventType::WindowFocusLost:
+				m_EventDispatcher.Dispatch(WindowFocusEvent{ input.Type == InputEventType::WindowFocusGained });
+				break;
+			case InputEventType::Quit:
+				m_EventDispatcher.Dispatch(WindowCloseEvent{});
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	void Application::OnWindowEvent(const SDL_WindowEvent& event)
+	{
+		switch (event.event)
+		{
+		case SDL_WINDOWEVENT_SIZE_CHANGED:
+		case SDL_WINDOWEVENT_RESTORED:
+			m_Renderer->OnWindowResized();
+			break;
+		default:
+			break;
+		}
+	}
+
+	void Application::FixedUpdate(double timeStep)
+	{
 	}
 
 	void Application::Update()
@@ -146,6 +338,7 @@ namespace Tempus {
 
 	void Application::Cleanup()
 	{
+		bool bHeadless = m_Renderer && m_Renderer->IsHeadless();
 
 		if (m_Window) 
 		{
@@ -157,9 +350,15 @@ namespace Tempus {
 			delete m_Renderer;
 		}
 
-		SDL_Vulkan_UnloadLibrary();
+		if (!bHeadless)
+		{
+			SDL_Vulkan_UnloadLibrary();
+		}
+
 		SDL_Quit();
 
+		m_Jobs.Shutdown();
+
 		TPS_CORE_INFO("Application Cleaned");
 	}
 
@@ -167,4 +366,119 @@ namespace Tempus {
 	{
 		m_Renderer->SetRenderDrawColor(r, g, b, a);
 	}
+
+	void Application::SetFramesInFlight(uint32_t count)
+	{
+		m_Renderer->SetFramesInFlight(count);
+	}
+
+	void Application::SetRenderThread(bool bEnabled)
+	{
+		m_Renderer->SetRenderThread(bEnabled);
+	}
+
+	void Application::RunRecordingBenchmark(uint32_t drawCount)
+	{
+		m_Renderer->RunRecordingBenchmark(drawCount);
+	}
+
+	void Application::RunSortBenchmark(uint32_t keyCount)
+	{
+		RenderQueue::RunSortBenchmark(keyCount);
+	}
+
+	void Application::RunInputLatencyBenchmark(uint32_t burstSize)
+	{
+		if (m_InputBurstSize > 0 || burstSize == 0)
+		{
+			return;
+		}
+
+		// Events past the queue's capacity would be dropped and the burst never completes
+		burstSize = std::min(burstSize, InputQueue::CAPACITY);
+
+		SDL_Event event{};
+		event.type = SDL_USEREVENT;
+		event.user.code = INPUT_BURST_CODE;
+
+		m_InputBurstStart = SDL_GetPerformanceCounter();
+		m_InputBurstReceived = 0;
+		m_InputBurstFrames = 0;
+		m_InputBurstLatency = 0.0;
+		m_InputBurstMaxLatency = 0.0;
+
+		for (uint32_t i = 0; i < burstSize; i++)
+		{
+			if (SDL_PushEvent(&event) != 1)
+			{
+				TPS_CORE_WARN("SDL event queue is full after {0} synthetic events", i);
+				burstSize = i;
+				break;
+			}
+		}
+
+		m_InputBurstSize = burstSize;
+	}
+
+	void Application::RunEventBenchmark(uint32_t eventCount)
+	{
+		EventDispatcher::RunBenchmark(eventCount);
+	}
+
+	void Application::RunJobBenchmark(uint32_t jobCount, uint32_t elementCount)
+	{
+		JobSystem::RunBenchmark(jobCount, elementCount);
+	}
+
+	void Application::RunAllocatorBenchmark(uint32_t operationCount)
+	{
+		// Thread safe, but the render thread's own allocations would skew the timings
+		m_Renderer->FlushRenderThread();
+		m_Renderer->GetAllocator().RunBenchmark(operationCount);
+	}
+
+	void Application::SetHeadless(const HeadlessConfig& config)
+	{
+		m_Renderer->SetHeadless(config);
+	}
+
+	void Application::SetCommandLine(int argc, char** argv)
+	{
+		HeadlessConfig config;
+		bool bHeadless = false;
+
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool bHasValue = i + 1 < argc;
+
+			if (arg == "--headless")
+			{
+				bHeadless = true;
+			}
+			else if (arg == "--frames" && bHasValue)
+			{
+				config.FrameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--size" && bHasValue)
+			{
+				char* end = nullptr;
+				config.Width = static_cast<uint32_t>(std::strtoul(argv[++i], &end, 10));
+				config.Height = (end && *end == 'x') ? static_cast<uint32_t>(std::strtoul(end + 1, nullptr, 10)) : config.Height;
+			}
+			else if (arg == "--capture" && bHasValue)
+			{
+				config.CapturePath = argv[++i];
+			}
+			else if (arg == "--render-thread")
+			{
+				SetRenderThread(true);
+			}
+		}
+
+		if (bHeadless)
+		{
+			SetHeadless(config);
+		}
+	}
 }
\ No newline at end of file
@@ -3,6 +3,13 @@
 #pragma once
 
 #include "Core.h"
+#include "FrameClock.h"
+#include "Jobs/JobSystem.h"
+#include "Events/InputQueue.h"
+#include "Events/EventDispatcher.h"
+#include "Events/ApplicationEvent.h"
+#include "Events/KeyEvent.h"
+#include "Events/MouseEvent.h"
 
 #include "vulkan/vulkan.h"
 #define SDL_MAIN_HANDLED
@@ -10,6 +17,8 @@
 
 namespace Tempus {
 
+	struct HeadlessConfig;
+
 	class TEMPUS_API Application
 	{
 	public:
@@ -18,15 +27,52 @@ namespace Tempus {
 		virtual ~Application();
 		void Run();
 
+		// Understands --headless, --frames <count>, --size <width>x<height>, --capture <path.ppm> and --render-thread
+		void SetCommandLine(int argc, char** argv);
+
 	protected:
 
+		// Runs GetFrameClock().GetFrameTickCount() times a frame before Update(), each advancing the simulation by timeStep
+		virtual void FixedUpdate(double timeStep);
+		// Once per frame, blend simulation state with GetFrameClock().GetInterpolationAlpha() when drawing it
 		virtual void Update();
 		virtual void Cleanup();
 
-		SDL_Event GetCurrentEvent() const { return CurrentEvent; }
+		// Time step, catch-up limit and frame rate cap, along with this frame's delta and tick count
+		FrameClock& GetFrameClock() { return m_Clock; }
+		// One thread per hardware thread, the main thread is thread 0 and helps whenever it waits
+		JobSystem& GetJobSystem() { return m_Jobs; }
+
+		// Every input event received since the last frame, oldest first
+		std::span<const InputEvent> GetInputEvents() const { return m_Input.GetEvents(); }
+		// Window, key and mouse events are dispatched through it before Update(), queued events right after them
+		EventDispatcher& GetEventDispatcher() { return m_EventDispatcher; }
 
 		void SetRenderColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 
+		class Renderer& GetRenderer() const { return *m_Renderer; }
+
+		// Only takes effect when called before Run(), eg. from the application constructor
+		void SetFramesInFlight(uint32_t count);
+		// Only takes effect when called before Run(). Update() then runs while the render thread draws the previous frame
+		void SetRenderThread(bool bEnabled);
+
+		// Logs how long recording drawCount draws takes with 1 to N recording threads
+		void RunRecordingBenchmark(uint32_t drawCount = 100000);
+		// Logs how long sorting keyCount render keys takes with the render queue's radix sort and with std::sort
+		void RunSortBenchmark(uint32_t keyCount = 1000000);
+		// Pushes burstSize synthetic SDL events at once and logs how long they take to reach Update()
+		void RunInputLatencyBenchmark(uint32_t burstSize = 256);
+		// Logs event dispatch throughput against virtual event listeners
+		void RunEventBenchmark(uint32_t eventCount = 1000000);
+		// Logs empty job throughput and ParallelFor time over elementCount floats with 1 to N threads
+		void RunJobBenchmark(uint32_t jobCount = 1000000, uint32_t elementCount = 10000000);
+		// Logs free and allocate churn through the GPU allocator against raw vkAllocateMemory and vkFreeMemory
+		void RunAllocatorBenchmark(uint32_t operationCount = 500000);
+
+		// Only takes effect when called before Run(). Renders config.FrameCount frames offscreen without a window, then quits
+		void SetHeadless(const HeadlessConfig& config);
+
 	private:
 
 		bool InitWindow();
@@ -34,6 +80,12 @@ namespace Tempus {
 		bool InitSDL();
 
 		void CoreUpdate();
+		void RunFixedUpdates();
+		void HandleEvent(const SDL_Event& event);
+		void MeasureInputBurst();
+		void DispatchInputEvents();
+		void RunHeadless();
+		void OnWindowEvent(const SDL_WindowEvent& event);
 
 	private:
 
@@ -43,7 +95,19 @@ namespace Tempus {
 
 		bool bShouldQuit = false;
 
-		SDL_Event CurrentEvent;
+		FrameClock m_Clock;
+		JobSystem m_Jobs;
+		InputQueue m_Input;
+		EventDispatcher m_EventDispatcher;
+
+		// Synthetic burst pushed by RunInputLatencyBenchmark, identified by its user event code
+		static constexpr int32_t INPUT_BURST_CODE = 0x54505342;
+		uint64_t m_InputBurstStart = 0;
+		uint32_t m_InputBurstSize = 0;
+		uint32_t m_InputBurstReceived = 0;
+		uint32_t m_InputBurstFrames = 0;
+		double m_InputBurstLatency = 0.0;
+		double m_InputBurstMaxLatency = 0.0;
 
 	};
 
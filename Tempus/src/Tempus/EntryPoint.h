@@ -9,6 +9,7 @@ extern Tempus::Application* Tempus::CreateApplication();
 int main(int argc, char** argv)
 {
 	auto app = Tempus::CreateApplication();
+	app->SetCommandLine(argc, argv);
 	app->Run();
 	delete app;
 
@@ -23,6 +24,7 @@ extern Tempus::Application* Tempus::CreateApplication();
 int main(int argc, char** argv)
 {
 	auto app = Tempus::CreateApplication();
+	app->SetCommandLine(argc, argv);
 	app->Run();
 	delete app;
 
@@ -0,0 +1,25 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Event.h"
+
+namespace Tempus {
+
+	struct WindowCloseEvent
+	{
+	};
+
+	// Window size in screen coordinates, the drawable may be larger on high DPI displays
+	struct WindowResizeEvent
+	{
+		int32_t Width = 0;
+		int32_t Height = 0;
+	};
+
+	struct WindowFocusEvent
+	{
+		bool bFocused = false;
+	};
+
+}
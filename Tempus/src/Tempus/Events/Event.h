@@ -1,57 +1,50 @@
-#pragma once
+// Copyright Levi Spevakow (C) 2025
 
-#include "Tempus/Core.h"
+#pragma once
 
-#include <string>
-#include <functional>
+#include "Core.h"
 
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
 
 namespace Tempus {
 
-	enum class EventType 
-	{
-		None = 0,
-		WindowClose, WindowResize, WindowFocus, WindowLostFocus, WindowMoved,
-		AppTick, AppUpdate, AppRender,
-		KeyPressed, KeyReleased,
-		MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled
-	};
-
-	enum EventCategory
-	{
-		None = 0,
-		EventCategoryApplication     = BIT(0),
-		EventCategoryInput           = BIT(1),
-		EventCategoryKeyboard        = BIT(2),
-		EventCategoryMouse           = BIT(3),
-		EventCategoryMouseButton     = BIT(4)
-	};
-
-
-	class TEMPUS_API Event
-	{
-
-	public:
-
-		virtual EventType GetEventType() const = 0;
-		virtual const char* GetName() const = 0;
-		virtual int GetCategoryFlags() const = 0;
-		virtual std::string ToString() const { return GetName(); }
-
-		inline bool IsInCategory(EventCategory category) 
+	using EventTypeID = uint64_t;
+
+	namespace EventDetail {
+
+		constexpr EventTypeID HashName(std::string_view name)
 		{
-			return GetCategoryFlags() & category;
+			// FNV-1a
+			EventTypeID hash = 14695981039346656037ull;
+			for (char c : name)
+			{
+				hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+			}
+			return hash;
 		}
 
-	protected:
-
-		bool m_Handled = false;
+		// The compiler's signature of this function, which spells out T
+		template<typename T>
+		constexpr std::string_view GetTypeSignature()
+		{
+#ifdef _MSC_VER
+			return __FUNCSIG__;
+#else
+			return __PRETTY_FUNCTION__;
+#endif
+		}
 
-	};
+	}
 
-	class EventDispatcher
-	{
+	// Events are plain structs. Queues copy them as bytes and never run a destructor
+	template<typename T>
+	concept EventStruct = std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T> && !std::is_pointer_v<T>;
 
-	};
+	// Computed from the type's name at compile time, so the engine and the application agree on an event's ID without
+	// registering it and across the DLL boundary
+	template<EventStruct T>
+	inline constexpr EventTypeID EventTypeIDOf = EventDetail::HashName(EventDetail::GetTypeSignature<std::remove_cv_t<T>>());
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,604 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "EventDispatcher.h"
+
+#include "Log.h"
+#include "ApplicationEvent.h"
+#include "KeyEvent.h"
+#include "MouseEvent.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace Tempus {
+
+	namespace {
+
+		constexpr uint32_t AlignEventSize(uint32_t size)
+		{
+			return (size + EventDispatcher::MAX_EVENT_ALIGNMENT - 1) & ~(EventDispatcher::MAX_EVENT_ALIGNMENT - 1);
+		}
+
+		constexpr uint32_t QUEUED_HEADER_SIZE = 16;
+
+	}
+
+	EventDispatcher::EventDispatcher(uint32_t queueBytes, uint32_t threadQueueSize)
+	{
+		// new[] aligns to at least 16 bytes, records are padded to keep every event aligned
+		m_ArenaSize = AlignEventSize(queueBytes);
+		m_Arenas[0] = std::make_unique<std::byte[]>(m_ArenaSize);
+		m_Arenas[1] = std::make_unique<std::byte[]>(m_ArenaSize);
+
+		uint64_t cellCount = std::bit_ceil(std::max<uint64_t>(threadQueueSize, 2));
+		m_ThreadCells = std::make_unique<ThreadCell[]>(cellCount);
+		m_ThreadMask = cellCount - 1;
+
+		for (uint64_t i = 0; i < cellCount; i++)
+		{
+			m_ThreadCells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+
+		// A power of two keeps probing a mask, 16 slots cover the engine's events before the first growth
+		m_Slots.resize(16);
+	}
+
+	void EventDispatcher::Unsubscribe(EventListenerHandle& handle)
+	{
+		uint32_t channelIndex = handle.IsValid() ? FindChannel(handle.Type) : UINT32_MAX;
+		if (channelIndex == UINT32_MAX)
+		{
+			handle = EventListenerHandle();
+			return;
+		}
+
+		std::vector<Listener>& listeners = m_Channels[channelIndex].Listeners;
+
+		for (Listener& listener : listeners)
+		{
+			if (listener.ID == handle.ID)
+			{
+				// A dispatch in progress may be iterating the array, so the slot is only cleared until it finishes
+				listener.Fn = nullptr;
+				m_bHasRemovedListeners = true;
+				break;
+			}
+		}
+
+		if (m_DispatchDepth == 0)
+		{
+			CompactListeners();
+		}
+
+		handle = EventListenerHandle();
+	}
+
+	uint32_t EventDispatcher::GetListenerCount(EventTypeID type) const
+	{
+		uint32_t channelIndex = FindChannel(type);
+		if (channelIndex == UINT32_MAX)
+		{
+			return 0;
+		}
+
+		const std::vector<Listener>& listeners = m_Channels[channelIndex].Listeners;
+		return static_cast<uint32_t>(std::count_if(listeners.begin(), listeners.end(), [](const Listener& listener) { return listener.Fn != nullptr; }));
+	}
+
+	EventListenerHandle EventDispatcher::Subscribe(EventTypeID type, ListenerFn fn, void* user)
+	{
+		uint32_t channelIndex = FindChannel(type);
+		if (channelIndex == UINT32_MAX)
+		{
+			channelIndex = AddChannel(type);
+		}
+
+		Listener listener;
+		listener.Fn = fn;
+		listener.User = user;
+		listener.ID = m_NextListenerID++;
+
+		m_Channels[channelIndex].Listeners.push_back(listener);
+
+		EventListenerHandle handle;
+		handle.Type = type;
+		handle.ID = listener.ID;
+		return handle;
+	}
+
+	bool EventDispatcher::Dispatch(EventTypeID type, const void* event)
+	{
+		uint32_t channelIndex = FindChannel(type);
+		if (channelIndex == UINT32_MAX)
+		{
+			return false;
+		}
+
+		m_DispatchDepth++;
+
+		// Indexed rather than iterated, listeners subscribed from a listener may grow the arrays. They are called too
+		bool bHandled = false;
+		for (size_t i = 0; i < m_Channels[channelIndex].Listeners.size() && !bHandled; i++)
+		{
+			const Listener listener = m_Channels[channelIndex].Listeners[i];
+			if (listener.Fn != nullptr)
+			{
+				bHandled = listener.Fn(listener.User, event);
+			}
+		}
+
+		m_DispatchDepth--;
+
+		if (m_DispatchDepth == 0 && m_bHasRemovedListeners)
+		{
+			CompactListeners();
+		}
+
+		return bHandled;
+	}
+
+	bool EventDispatcher::Post(EventTypeID type, const void* event, uint32_t size)
+	{
+		uint32_t recordSize = QUEUED_HEADER_SIZE + AlignEventSize(size);
+		uint32_t& used = m_ArenaUsed[m_ArenaIndex];
+
+		if (used + recordSize > m_ArenaSize)
+		{
+			m_DroppedCount++;
+			return false;
+		}
+
+		std::byte* record = m_Arenas[m_ArenaIndex].get() + used;
+
+		QueuedEvent header;
+		header.Type = type;
+		header.Size = size;
+		std::memcpy(record, &header, sizeof(header));
+		std::memcpy(record + QUEUED_HEADER_SIZE, event, size);
+
+		used += recordSize;
+		return true;
+	}
+
+	bool EventDispatcher::PostFromThread(EventTypeID type, const void* event, uint32_t size)
+	{
+		if (!EnqueueFromThread(type, event, size))
+		{
+			m_ThreadDroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool EventDispatcher::EnqueueFromThread(EventTypeID type, const void* event, uint32_t size)
+	{
+		uint64_t position = m_ThreadEnqueue.load(std::memory_order_relaxed);
+		ThreadCell* cell = nullptr;
+
+		while (true)
+		{
+			cell = &m_ThreadCells[position & m_ThreadMask];
+			uint64_t sequence = cell->Sequence.load(std::memory_order_acquire);
+			int64_t difference = static_cast<int64_t>(sequence - position);
+
+			if (difference == 0)
+			{
+				// The cell is free for this position, claim it
+				if (m_ThreadEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (difference < 0)
+			{
+				// The consumer hasn't freed the cell from the previous lap yet
+				return false;
+			}
+			else
+			{
+				position = m_ThreadEnqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->Type = type;
+		cell->Size = size;
+		std::memcpy(cell->Data, event, size);
+		cell->Sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	void EventDispatcher::DispatchQueued()
+	{
+		// Worker events first, only the ones already complete. A producer still writing its cell is picked up next time
+		while (true)
+		{
+			ThreadCell& cell = m_ThreadCells[m_ThreadDequeue & m_ThreadMask];
+			if (cell.Sequence.load(std::memory_order_acquire) != m_ThreadDequeue + 1)
+			{
+				break;
+			}
+
+			// Copied out so the cell can be freed before listeners run, they may post from threads themselves
+			alignas(MAX_EVENT_ALIGNMENT) std::byte data[MAX_THREAD_EVENT_SIZE];
+			EventTypeID type = cell.Type;
+			std::memcpy(data, cell.Data, cell.Size);
+			cell.Sequence.store(m_ThreadDequeue + m_ThreadMask + 1, std::memory_order_release);
+			m_ThreadDequeue++;
+
+			Dispatch(type, data);
+		}
+
+		uint32_t threadDropped = m_ThreadDroppedCount.exchange(0, std::memory_order_relaxed);
+		if (threadDropped > 0 || m_DroppedCount > 0)
+		{
+			TPS_CORE_WARN("{0} events were dropped since the last dispatch, the queues are full", threadDropped + m_DroppedCount);
+			m_DroppedCount = 0;
+		}
+
+		// Posts made by listeners land in the other arena
+		uint32_t arenaIndex = m_ArenaIndex;
+		m_ArenaIndex ^= 1;
+		m_ArenaUsed[m_ArenaIndex] = 0;
+
+		const std::byte* arena = m_Arenas[arenaIndex].get();
+		uint32_t used = m_ArenaUsed[arenaIndex];
+
+		for (uint32_t offset = 0; offset < used;)
+		{
+			QueuedEvent header;
+			std::memcpy(&header, arena + offset, sizeof(header));
+
+			Dispatch(header.Type, arena + offset + QUEUED_HEADER_SIZE);
+			offset += QUEUED_HEADER_SIZE + AlignEventSize(header.Size);
+		}
+
+		m_ArenaUsed[arenaIndex] = 0;
+	}
+
+	uint32_t EventDispatcher::FindChannel(EventTypeID type) const
+	{
+		uint64_t mask = m_Slots.size() - 1;
+
+		for (uint64_t slot = type & mask;; slot = (slot + 1) & mask)
+		{
+			if (m_Slots[slot].Type == type)
+			{
+				return m_Slots[slot].Channel;
+			}
+
+			if (m_Slots[slot].Type == 0)
+			{
+				return UINT32_MAX;
+			}
+		}
+	}
+
+	uint32_t EventDispatcher::AddChannel(EventTypeID type)
+	{
+		Channel channel;
+		channel.Type = type;
+		m_Channels.push_back(std::move(channel));
+
+		// Kept at most half full so probes stay short and always reach an empty slot
+		if (m_Channels.size() * 2 > m_Slots.size())
+		{
+			m_Slots.assign(m_Slots.size() * 2, ChannelSlot());
+
+			for (uint32_t i = 0; i < m_Channels.size(); i++)
+			{
+				uint64_t mask = m_Slots.size() - 1;
+				uint64_t slot = m_Channels[i].Type & mask;
+
+				while (m_Slots[slot].Type != 0)
+				{
+					slot = (slot + 1) & mask;
+				}
+
+				m_Slots[slot].Type = m_Channels[i].Type;
+				m_Slots[slot].Channel = i;
+			}
+
+			return static_cast<uint32_t>(m_Channels.size() - 1);
+		}
+
+		uint64_t mask = m_Slots.size() - 1;
+		uint64_t slot = type & mask;
+
+		while (m_Slots[slot].Type != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		m_Slots[slot].Type = type;
+		m_Slots[slot].Channel = static_cast<uint32_t>(m_Channels.size() - 1);
+
+		return m_Slots[slot].Channel;
+	}
+
+	void EventDispatcher::CompactListeners()
+	{
+		for (Channel& channel : m_Channels)
+		{
+			std::erase_if(channel.Listeners, [](const Listener& listener) { return listener.Fn == nullptr; });
+		}
+
+		m_bHasRemovedListeners = false;
+	}
+
+	namespace {
+
+		// The previous design: events derive from a virtual base and every listener's virtual OnEvent sees every event,
+		// checking its type before handling it
+		class LegacyEvent
+		{
+		public:
+
+			virtual ~LegacyEvent() = default;
+			virtual int GetEventType() const = 0;
+
+			bool m_Handled = false;
+		};
+
+		class LegacyMouseMovedEvent : public LegacyEvent
+		{
+		public:
+
+			explicit LegacyMouseMovedEvent(int32_t x) : m_X(x) {}
+			int GetEventType() const override { return 0; }
+
+			int32_t m_X;
+		};
+
+		class LegacyKeyPressedEvent : public LegacyEvent
+		{
+		public:
+
+			explicit LegacyKeyPressedEvent(int32_t keyCode) : m_KeyCode(keyCode) {}
+			int GetEventType() const override { return 1; }
+
+			int32_t m_KeyCode;
+		};
+
+		class LegacyListener
+		{
+		public:
+
+			virtual ~LegacyListener() = default;
+			virtual void OnEvent(LegacyEvent& event) = 0;
+		};
+
+		class LegacyMouseListener : public LegacyListener
+		{
+		public:
+
+			void OnEvent(LegacyEvent& event) override
+			{
+				if (event.GetEventType() == 0)
+				{
+					Sum += static_cast<LegacyMouseMovedEvent&>(event).m_X;
+				}
+			}
+
+			uint64_t Sum = 0;
+		};
+
+		class LegacyKeyListener : public LegacyListener
+		{
+		public:
+
+			void OnEvent(LegacyEvent& event) override
+			{
+				if (event.GetEventType() == 1)
+				{
+					Sum += static_cast<LegacyKeyPressedEvent&>(event).m_KeyCode;
+				}
+			}
+
+			uint64_t Sum = 0;
+		};
+
+		struct BenchmarkListener
+		{
+			void OnMouseMoved(const MouseMovedEvent& event) { Sum += event.X; }
+			void OnKeyPressed(const KeyPressedEvent& event) { Sum += event.KeyCode; }
+
+			uint64_t Sum = 0;
+		};
+
+		constexpr uint32_t BENCHMARK_LISTENERS_PER_TYPE = 4;
+		// Events posted between two DispatchQueued() calls, standing in for a frame
+		constexpr uint32_t BENCHMARK_EVENTS_PER_FRAME = 1024;
+		constexpr uint32_t BENCHMARK_THREADS = 4;
+
+		double ElapsedMilliseconds(std::chrono::high_resolution_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+	}
+
+	void EventDispatcher::RunBenchmark(uint32_t eventCount)
+	{
+		eventCount = std::max(eventCount, BENCHMARK_EVENTS_PER_FRAME);
+
+		// Half mouse moves, half key presses
+		std::vector<LegacyMouseListener> legacyMouse(BENCHMARK_LISTENERS_PER_TYPE);
+		std::vector<LegacyKeyListener> legacyKeys(BENCHMARK_LISTENERS_PER_TYPE);
+		std::vector<LegacyListener*> legacyListeners;
+
+		for (uint32_t i = 0; i < BENCHMARK_LISTENERS_PER_TYPE; i++)
+		{
+			legacyListeners.push_back(&legacyMouse[i]);
+			legacyListeners.push_back(&legacyKeys[i]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < eventCount; i++)
+		{
+			if (i & 1)
+			{
+				LegacyKeyPressedEvent event(static_cast<int32_t>(i));
+				for (LegacyListener* listener : legacyListeners)
+				{
+					listener->OnEvent(event);
+				}
+			}
+			else
+			{
+				LegacyMouseMovedEvent event(static_cast<int32_t>(i));
+				for (LegacyListener* listener : legacyListeners)
+				{
+					listener->OnEvent(event);
+				}
+			}
+		}
+
+		double legacyTime = ElapsedMilliseconds(start);
+
+		uint64_t expected = 0;
+		for (const LegacyMouseListener& listener : legacyMouse)
+		{
+			expected += listener.Sum;
+		}
+		for (const LegacyKeyListener& listener : legacyKeys)
+		{
+			expected += listener.Sum;
+		}
+
+		EventDispatcher dispatcher(BENCHMARK_EVENTS_PER_FRAME * 32, BENCHMARK_EVENTS_PER_FRAME * 4);
+		std::vector<BenchmarkListener> listeners(BENCHMARK_LISTENERS_PER_TYPE);
+
+		for (BenchmarkListener& listener : listeners)
+		{
+			dispatcher.Subscribe<MouseMovedEvent, &BenchmarkListener::OnMouseMoved>(&listener);
+			dispatcher.Subscribe<KeyPressedEvent, &BenchmarkListener::OnKeyPressed>(&listener);
+		}
+
+		auto sum = [&listeners]()
+		{
+			uint64_t total = 0;
+			for (BenchmarkListener& listener : listeners)
+			{
+				total += listener.Sum;
+				listener.Sum = 0;
+			}
+			return total;
+		};
+
+		start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < eventCount; i++)
+		{
+			if (i & 1)
+			{
+				KeyPressedEvent event;
+				event.KeyCode = static_cast<int32_t>(i);
+				dispatcher.Dispatch(event);
+			}
+			else
+			{
+				MouseMovedEvent event;
+				event.X = static_cast<int32_t>(i);
+				dispatcher.Dispatch(event);
+			}
+		}
+
+		double dispatchTime = ElapsedMilliseconds(start);
+		bool bDispatchMatches = sum() == expected;
+
+		start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < eventCount; i++)
+		{
+			if (i & 1)
+			{
+				KeyPressedEvent event;
+				event.KeyCode = static_cast<int32_t>(i);
+				dispatcher.Post(event);
+			}
+			else
+			{
+				MouseMovedEvent event;
+				event.X = static_cast<int32_t>(i);
+				dispatcher.Post(event);
+			}
+
+			if ((i + 1) % BENCHMARK_EVENTS_PER_FRAME == 0)
+			{
+				dispatcher.DispatchQueued();
+			}
+		}
+
+		dispatcher.DispatchQueued();
+
+		double postTime = ElapsedMilliseconds(start);
+		bool bPostMatches = sum() == expected;
+
+		// Producers split the events and retry while the queue is full without counting drops, the calling thread drains like a frame loop would
+		std::atomic<uint32_t> finishedThreads = 0;
+		std::vector<std::thread> threads;
+
+		start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t thread = 0; thread < BENCHMARK_THREADS; thread++)
+		{
+			threads.emplace_back([&dispatcher, &finishedThreads, thread, eventCount]()
+			{
+				for (uint32_t i = thread; i < eventCount; i += BENCHMARK_THREADS)
+				{
+					if (i & 1)
+					{
+						KeyPressedEvent event;
+						event.KeyCode = static_cast<int32_t>(i);
+						while (!dispatcher.EnqueueFromThread(EventTypeIDOf<KeyPressedEvent>, &event, sizeof(event)))
+						{
+							std::this_thread::yield();
+						}
+					}
+					else
+					{
+						MouseMovedEvent event;
+						event.X = static_cast<int32_t>(i);
+						while (!dispatcher.EnqueueFromThread(EventTypeIDOf<MouseMovedEvent>, &event, sizeof(event)))
+						{
+							std::this_thread::yield();
+						}
+					}
+				}
+
+				finishedThreads.fetch_add(1, std::memory_order_release);
+			});
+		}
+
+		while (finishedThreads.load(std::memory_order_acquire) < BENCHMARK_THREADS)
+		{
+			dispatcher.DispatchQueued();
+		}
+
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		dispatcher.DispatchQueued();
+
+		double threadTime = ElapsedMilliseconds(start);
+		bool bThreadMatches = sum() == expected;
+
+		auto rate = [eventCount](double milliseconds) { return milliseconds > 0.0 ? eventCount / (milliseconds * 1000.0) : 0.0; };
+
+		TPS_CORE_INFO("Event benchmark, {0} events over 2 types with {1} listeners each:", eventCount, BENCHMARK_LISTENERS_PER_TYPE);
+		TPS_CORE_INFO("\tVirtual OnEvent:  {0:.3f} ms ({1:.1f} M events/s)", legacyTime, rate(legacyTime));
+		TPS_CORE_INFO("\tDispatch:         {0:.3f} ms ({1:.1f} M events/s){2}", dispatchTime, rate(dispatchTime),
+			bDispatchMatches ? "" : " MISMATCH");
+		TPS_CORE_INFO("\tPost:             {0:.3f} ms ({1:.1f} M events/s){2}", postTime, rate(postTime), bPostMatches ? "" : " MISMATCH");
+		TPS_CORE_INFO("\tPostFromThread x{0}: {1:.3f} ms ({2:.1f} M events/s){3}", BENCHMARK_THREADS, threadTime, rate(threadTime),
+			bThreadMatches ? "" : " MISMATCH");
+	}
+
+}
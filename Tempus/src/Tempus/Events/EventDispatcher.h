@@ -0,0 +1,192 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "Event.h"
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstddef>
+
+namespace Tempus {
+
+	struct EventListenerHandle
+	{
+		EventTypeID Type = 0;
+		uint32_t ID = 0;
+
+		bool IsValid() const { return ID != 0; }
+	};
+
+	// Event bus without virtual calls or allocations per event. Listeners are a function pointer and a user pointer,
+	// kept in a flat array per event type and found through the type's compile time ID.
+	//
+	// Dispatch() calls the listeners right away. Post() copies the event into the frame's arena and PostFromThread()
+	// into a bounded lock free queue, both are dispatched by the next DispatchQueued(). Everything except
+	// PostFromThread() belongs to the main thread
+	class TEMPUS_API EventDispatcher
+	{
+	public:
+
+		static constexpr uint32_t DEFAULT_QUEUE_BYTES = 64 * 1024;
+		static constexpr uint32_t DEFAULT_THREAD_QUEUE_SIZE = 4096;
+		// Largest event PostFromThread() takes, a queue cell is two cache lines
+		static constexpr uint32_t MAX_THREAD_EVENT_SIZE = 96;
+		static constexpr uint32_t MAX_EVENT_ALIGNMENT = 16;
+
+		// Returns true when the listener handled the event, which skips the listeners after it
+		using ListenerFn = bool (*)(void* user, const void* event);
+
+		// queueBytes is the size of each of the two frame arenas, threadQueueSize is rounded up to a power of two
+		EventDispatcher(uint32_t queueBytes = DEFAULT_QUEUE_BYTES, uint32_t threadQueueSize = DEFAULT_THREAD_QUEUE_SIZE);
+		~EventDispatcher() = default;
+
+		EventDispatcher(const EventDispatcher&) = delete;
+		EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+		// Method is `bool (C::*)(const E&)` or `void (C::*)(const E&)`, eg. Subscribe<WindowResizeEvent, &Game::OnResize>(this)
+		template<EventStruct E, auto Method, typename C>
+		EventListenerHandle Subscribe(C* instance)
+		{
+			return Subscribe(EventTypeIDOf<E>, [](void* user, const void* event) -> bool
+			{
+				if constexpr (std::is_same_v<decltype((static_cast<C*>(user)->*Method)(*static_cast<const E*>(event))), bool>)
+				{
+					return (static_cast<C*>(user)->*Method)(*static_cast<const E*>(event));
+				}
+				else
+				{
+					(static_cast<C*>(user)->*Method)(*static_cast<const E*>(event));
+					return false;
+				}
+			}, instance);
+		}
+
+		// Function is `bool (*)(const E&)` or `void (*)(const E&)`
+		template<EventStruct E, auto Function>
+		EventListenerHandle Subscribe()
+		{
+			return Subscribe(EventTypeIDOf<E>, [](void*, const void* event) -> bool
+			{
+				if constexpr (std::is_same_v<decltype(Function(*static_cast<const E*>(event))), bool>)
+				{
+					return Function(*static_cast<const E*>(event));
+				}
+				else
+				{
+					Function(*static_cast<const E*>(event));
+					return false;
+				}
+			}, nullptr);
+		}
+
+		// Safe to call from a listener, the listener isn't called again
+		void Unsubscribe(EventListenerHandle& handle);
+
+		// Returns true when a listener handled the event
+		template<EventStruct E>
+		bool Dispatch(const E& event)
+		{
+			return Dispatch(EventTypeIDOf<E>, &event);
+		}
+
+		// Fails when the frame's arena is full
+		template<EventStruct E>
+		bool Post(const E& event)
+		{
+			static_assert(alignof(E) <= MAX_EVENT_ALIGNMENT, "Event alignment is too large to queue");
+			return Post(EventTypeIDOf<E>, &event, sizeof(E));
+		}
+
+		// Thread safe and lock free. Fails when the queue is full
+		template<EventStruct E>
+		bool PostFromThread(const E& event)
+		{
+			static_assert(sizeof(E) <= MAX_THREAD_EVENT_SIZE && alignof(E) <= MAX_EVENT_ALIGNMENT, "Event is too large to post from a thread");
+			return PostFromThread(EventTypeIDOf<E>, &event, sizeof(E));
+		}
+
+		// Once per frame. Dispatches the events worker threads posted, then the ones posted on the main thread since the
+		// last call. Events posted while dispatching go out with the next call
+		void DispatchQueued();
+
+		uint32_t GetListenerCount(EventTypeID type) const;
+
+		// Logs dispatch throughput of the previous design, virtual events handed to every listener's virtual OnEvent,
+		// next to Dispatch(), Post() and PostFromThread()
+		static void RunBenchmark(uint32_t eventCount = 1000000);
+
+	private:
+
+		struct Listener
+		{
+			ListenerFn Fn = nullptr;
+			void* User = nullptr;
+			uint32_t ID = 0;
+		};
+
+		struct Channel
+		{
+			EventTypeID Type = 0;
+			std::vector<Listener> Listeners;
+		};
+
+		// Open addressed table from type to channel index, Type 0 marks an empty slot
+		struct ChannelSlot
+		{
+			EventTypeID Type = 0;
+			uint32_t Channel = 0;
+		};
+
+		// Followed by the event, padded to MAX_EVENT_ALIGNMENT
+		struct QueuedEvent
+		{
+			EventTypeID Type = 0;
+			uint32_t Size = 0;
+		};
+
+		// Bounded MPSC queue cell. Sequence equals the enqueue position it is free for, and that position + 1 once filled
+		struct alignas(64) ThreadCell
+		{
+			std::atomic<uint64_t> Sequence = 0;
+			EventTypeID Type = 0;
+			uint32_t Size = 0;
+			alignas(MAX_EVENT_ALIGNMENT) std::byte Data[MAX_THREAD_EVENT_SIZE];
+		};
+
+		EventListenerHandle Subscribe(EventTypeID type, ListenerFn fn, void* user);
+		bool Dispatch(EventTypeID type, const void* event);
+		bool Post(EventTypeID type, const void* event, uint32_t size);
+		bool PostFromThread(EventTypeID type, const void* event, uint32_t size);
+		bool EnqueueFromThread(EventTypeID type, const void* event, uint32_t size);
+
+		uint32_t FindChannel(EventTypeID type) const;
+		uint32_t AddChannel(EventTypeID type);
+		void CompactListeners();
+
+	private:
+
+		std::vector<Channel> m_Channels;
+		std::vector<ChannelSlot> m_Slots;
+		uint32_t m_NextListenerID = 1;
+		uint32_t m_DispatchDepth = 0;
+		bool m_bHasRemovedListeners = false;
+
+		// Post() fills one arena while DispatchQueued() walks the other
+		std::unique_ptr<std::byte[]> m_Arenas[2];
+		uint32_t m_ArenaSize = 0;
+		uint32_t m_ArenaUsed[2] = {};
+		uint32_t m_ArenaIndex = 0;
+		uint32_t m_DroppedCount = 0;
+
+		std::unique_ptr<ThreadCell[]> m_ThreadCells;
+		uint64_t m_ThreadMask = 0;
+		alignas(64) std::atomic<uint64_t> m_ThreadEnqueue = 0;
+		alignas(64) uint64_t m_ThreadDequeue = 0;
+		std::atomic<uint32_t> m_ThreadDroppedCount = 0;
+
+	};
+
+}
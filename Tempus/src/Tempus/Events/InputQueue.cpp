@@ -0,0 +1,120 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "InputQueue.h"
+
+#include "Log.h"
+#include "sdl/SDL_timer.h"
+
+namespace Tempus {
+
+	void InputQueue::BeginFrame()
+	{
+		if (m_DroppedCount > 0)
+		{
+			TPS_CORE_WARN("{0} input events were dropped last frame, a frame holds {1}", m_DroppedCount, CAPACITY);
+		}
+
+		m_Count = 0;
+		m_DroppedCount = 0;
+	}
+
+	void InputQueue::Push(const SDL_Event& event)
+	{
+		InputEvent input;
+
+		switch (event.type)
+		{
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			input.Type = event.type == SDL_KEYDOWN ? InputEventType::KeyPressed : InputEventType::KeyReleased;
+			input.Key.Scancode = event.key.keysym.scancode;
+			input.Key.Keycode = event.key.keysym.sym;
+			input.Key.Modifiers = event.key.keysym.mod;
+			input.Key.bRepeat = event.key.repeat != 0;
+			break;
+		case SDL_MOUSEMOTION:
+			input.Type = InputEventType::MouseMoved;
+			input.MouseMove.X = event.motion.x;
+			input.MouseMove.Y = event.motion.y;
+			input.MouseMove.DeltaX = event.motion.xrel;
+			input.MouseMove.DeltaY = event.motion.yrel;
+			input.MouseMove.Buttons = event.motion.state;
+			break;
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+			input.Type = event.type == SDL_MOUSEBUTTONDOWN ? InputEventType::MouseButtonPressed : InputEventType::MouseButtonReleased;
+			input.MouseButton.X = event.button.x;
+			input.MouseButton.Y = event.button.y;
+			input.MouseButton.Button = event.button.button;
+			input.MouseButton.Clicks = event.button.clicks;
+			break;
+		case SDL_MOUSEWHEEL:
+			input.Type = InputEventType::MouseScrolled;
+			input.MouseScroll.X = event.wheel.preciseX;
+			input.MouseScroll.Y = event.wheel.preciseY;
+			break;
+		case SDL_WINDOWEVENT:
+			if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+			{
+				input.Type = InputEventType::WindowResized;
+				input.Window.Width = event.window.data1;
+				input.Window.Height = event.window.data2;
+			}
+			else if (event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED || event.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+			{
+				input.Type = event.window.event == SDL_WINDOWEVENT_FOCUS_GAINED ? InputEventType::WindowFocusGained : InputEventType::WindowFocusLost;
+			}
+			break;
+		case SDL_QUIT:
+			input.Type = InputEventType::Quit;
+			break;
+		default:
+			if (event.type >= SDL_USEREVENT && event.type < SDL_LASTEVENT)
+			{
+				input.Type = InputEventType::User;
+				input.User.Type = event.user.type;
+				input.User.Code = event.user.code;
+				input.User.Data1 = event.user.data1;
+				input.User.Data2 = event.user.data2;
+			}
+			break;
+		}
+
+		if (input.Type == InputEventType::None)
+		{
+			return;
+		}
+
+		// SDL only stamps events in milliseconds. Backdating the current counter by the event's age puts the timestamp
+		// on the same clock as frame times
+		uint32_t age = SDL_GetTicks() - event.common.timestamp;
+		input.Timestamp = SDL_GetPerformanceCounter() - age * SDL_GetPerformanceFrequency() / 1000;
+
+		if (m_Count < CAPACITY)
+		{
+			m_Events[m_Count++] = input;
+			return;
+		}
+
+		InputEvent& last = m_Events[m_Count - 1];
+
+		if (input.Type == InputEventType::MouseMoved && last.Type == InputEventType::MouseMoved)
+		{
+			last.MouseMove.X = input.MouseMove.X;
+			last.MouseMove.Y = input.MouseMove.Y;
+			last.MouseMove.DeltaX += input.MouseMove.DeltaX;
+			last.MouseMove.DeltaY += input.MouseMove.DeltaY;
+			last.MouseMove.Buttons = input.MouseMove.Buttons;
+			last.Timestamp = input.Timestamp;
+			return;
+		}
+
+		m_DroppedCount++;
+	}
+
+	double InputQueue::TicksToMilliseconds(uint64_t ticks)
+	{
+		return static_cast<double>(ticks) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+	}
+
+}
@@ -0,0 +1,115 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "sdl/SDL_events.h"
+#include <array>
+#include <span>
+#include <cstdint>
+
+namespace Tempus {
+
+	enum class InputEventType : uint8_t
+	{
+		None = 0,
+		KeyPressed, KeyReleased,
+		MouseMoved, MouseButtonPressed, MouseButtonReleased, MouseScrolled,
+		WindowResized, WindowFocusGained, WindowFocusLost,
+		Quit,
+		// SDL_USEREVENT and above, eg. events pushed by the application itself
+		User
+	};
+
+	struct KeyInput
+	{
+		SDL_Scancode Scancode;
+		SDL_Keycode Keycode;
+		uint16_t Modifiers;
+		bool bRepeat;
+	};
+
+	struct MouseMoveInput
+	{
+		int32_t X, Y;
+		int32_t DeltaX, DeltaY;
+		uint32_t Buttons;
+	};
+
+	struct MouseButtonInput
+	{
+		int32_t X, Y;
+		uint8_t Button;
+		uint8_t Clicks;
+	};
+
+	struct MouseScrollInput
+	{
+		float X, Y;
+	};
+
+	struct WindowResizeInput
+	{
+		int32_t Width, Height;
+	};
+
+	struct UserInput
+	{
+		uint32_t Type;
+		int32_t Code;
+		void* Data1;
+		void* Data2;
+	};
+
+	// Plain data, the payload matching Type is valid
+	struct InputEvent
+	{
+		InputEventType Type = InputEventType::None;
+		// Performance counter ticks of when SDL queued the event, see InputQueue::TicksToMilliseconds
+		uint64_t Timestamp = 0;
+
+		union
+		{
+			KeyInput Key;
+			MouseMoveInput MouseMove;
+			MouseButtonInput MouseButton;
+			MouseScrollInput MouseScroll;
+			WindowResizeInput Window;
+			UserInput User;
+		};
+
+		InputEvent() : User() {}
+	};
+
+	// The input of one frame. The application drains every pending SDL event into it before Update(), so a burst of
+	// events arrives in one frame instead of one per frame. Storage is a fixed array rewound every frame, nothing is
+	// allocated
+	class TEMPUS_API InputQueue
+	{
+	public:
+
+		static constexpr uint32_t CAPACITY = 512;
+
+		// Drops the previous frame's events
+		void BeginFrame();
+
+		// Translates and appends an SDL event, events without a Tempus equivalent are skipped. When the queue is full
+		// mouse motion is merged into the last motion event and anything else is dropped
+		void Push(const SDL_Event& event);
+
+		// In the order SDL received them
+		std::span<const InputEvent> GetEvents() const { return std::span<const InputEvent>(m_Events.data(), m_Count); }
+		uint32_t GetDroppedCount() const { return m_DroppedCount; }
+
+		static double TicksToMilliseconds(uint64_t ticks);
+
+	private:
+
+		std::array<InputEvent, CAPACITY> m_Events;
+		uint32_t m_Count = 0;
+		uint32_t m_DroppedCount = 0;
+
+	};
+
+}
@@ -1,28 +1,23 @@
+// Copyright Levi Spevakow (C) 2025
+
 #pragma once
 
 #include "Event.h"
 
-#include <sstream>
-
 namespace Tempus {
 
-	class TEMPUS_API KeyEvent : public Event
+	// KeyCode is an SDL_Keycode, ScanCode an SDL_Scancode
+	struct KeyPressedEvent
 	{
-
-	public:
-
-		inline int GetKeyCode() const { return m_KeyCode; }
-
-	protected:
-
-		int m_KeyCode;
-
+		int32_t KeyCode = 0;
+		int32_t ScanCode = 0;
+		bool bRepeat = false;
 	};
 
+	struct KeyReleasedEvent
+	{
+		int32_t KeyCode = 0;
+		int32_t ScanCode = 0;
+	};
 
-
-
-
-
-
-}
\ No newline at end of file
+}
@@ -0,0 +1,39 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Event.h"
+
+namespace Tempus {
+
+	// Positions are in window coordinates
+	struct MouseMovedEvent
+	{
+		int32_t X = 0;
+		int32_t Y = 0;
+		int32_t DeltaX = 0;
+		int32_t DeltaY = 0;
+	};
+
+	// Button is an SDL_BUTTON_* index
+	struct MouseButtonPressedEvent
+	{
+		int32_t X = 0;
+		int32_t Y = 0;
+		uint8_t Button = 0;
+	};
+
+	struct MouseButtonReleasedEvent
+	{
+		int32_t X = 0;
+		int32_t Y = 0;
+		uint8_t Button = 0;
+	};
+
+	struct MouseScrolledEvent
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+	};
+
+}
@@ -0,0 +1,103 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "FrameClock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Tempus {
+
+	FrameClock::FrameClock()
+	{
+	}
+
+	void FrameClock::BeginFrame()
+	{
+		Clock::time_point now = Clock::now();
+
+		// The first frame has nothing to measure and runs no ticks
+		m_DeltaTime = m_bStarted ? std::min(std::chrono::duration<double>(now - m_FrameStart).count(), MAX_FRAME_DELTA) : 0.0;
+		m_FrameStart = now;
+		m_bStarted = true;
+
+		m_Accumulator += m_DeltaTime;
+		m_FrameTicks = 0;
+
+		while (m_Accumulator >= m_TimeStep && m_FrameTicks < m_MaxCatchUpTicks)
+		{
+			m_Accumulator -= m_TimeStep;
+			m_FrameTicks++;
+		}
+
+		// Whole steps past the catch-up limit are dropped, the fraction is kept so the alpha stays continuous
+		if (m_Accumulator >= m_TimeStep)
+		{
+			double dropped = m_Accumulator - std::fmod(m_Accumulator, m_TimeStep);
+			m_Accumulator -= dropped;
+			m_DroppedTime += dropped;
+		}
+
+		m_TickCount += m_FrameTicks;
+		m_FrameCount++;
+	}
+
+	void FrameClock::BeginFixedFrame()
+	{
+		m_FrameStart = Clock::now();
+		m_bStarted = true;
+
+		m_DeltaTime = m_TimeStep;
+		m_Accumulator = 0.0;
+		m_FrameTicks = 1;
+
+		m_TickCount++;
+		m_FrameCount++;
+	}
+
+	void FrameClock::WaitForNextFrame()
+	{
+		if (m_FrameRateCap <= 0.0)
+		{
+			return;
+		}
+
+		Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_FrameRateCap));
+		Clock::time_point now = Clock::now();
+
+		// Deadlines advance by whole periods, so a frame that wakes late is made up by the next one. After a hitch of
+		// more than a period the schedule restarts instead of rushing frames out back to back
+		m_NextFrame += period;
+
+		if (now - m_NextFrame > period)
+		{
+			m_NextFrame = now;
+			return;
+		}
+
+		Clock::duration margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(SPIN_MARGIN));
+
+		if (m_NextFrame - now > margin)
+		{
+			std::this_thread::sleep_for(m_NextFrame - now - margin);
+		}
+
+		while (Clock::now() < m_NextFrame)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void FrameClock::SetTimeStep(double seconds)
+	{
+		m_TimeStep = seconds > 0.0 ? seconds : DEFAULT_TIME_STEP;
+		m_Accumulator = std::fmod(m_Accumulator, m_TimeStep);
+	}
+
+	void FrameClock::SetFrameRateCap(double framesPerSecond)
+	{
+		m_FrameRateCap = std::max(framesPerSecond, 0.0);
+		m_NextFrame = Clock::time_point();
+	}
+
+}
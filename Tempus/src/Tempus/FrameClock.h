@@ -0,0 +1,75 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace Tempus {
+
+	// Paces the main loop. Simulation advances in fixed ticks fed by an accumulator of real time, rendering runs once per
+	// frame and blends the last two simulation states with GetInterpolationAlpha(). When a frame runs long, at most
+	// MaxCatchUpTicks ticks run and the rest of the backlog is dropped, so a slow frame can't snowball into slower ones.
+	// An optional frame rate cap sleeps most of the remaining frame time and spins the rest for precise pacing
+	class TEMPUS_API FrameClock
+	{
+	public:
+
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr double DEFAULT_TIME_STEP = 1.0 / 60.0;
+		static constexpr uint32_t DEFAULT_MAX_CATCH_UP_TICKS = 5;
+		// Longer frames, eg. after a breakpoint or while minimized, count as this long
+		static constexpr double MAX_FRAME_DELTA = 0.25;
+		// Sleeps overshoot by up to a scheduler quantum, the last stretch before the deadline is spun instead
+		static constexpr double SPIN_MARGIN = 0.002;
+
+		FrameClock();
+
+		// Measures the frame that just ended and works out how many ticks this one runs
+		void BeginFrame();
+		// Headless and benchmark runs: exactly one tick per frame regardless of real time, so results are repeatable
+		void BeginFixedFrame();
+		// Blocks until the frame rate cap's next frame is due, returns right away without a cap
+		void WaitForNextFrame();
+
+		void SetTimeStep(double seconds);
+		void SetMaxCatchUpTicks(uint32_t ticks) { m_MaxCatchUpTicks = ticks > 0 ? ticks : 1; }
+		// 0 disables the cap
+		void SetFrameRateCap(double framesPerSecond);
+
+		double GetTimeStep() const { return m_TimeStep; }
+		double GetFrameRateCap() const { return m_FrameRateCap; }
+		// Seconds between the start of the previous frame and this one, clamped to MAX_FRAME_DELTA
+		double GetDeltaTime() const { return m_DeltaTime; }
+		// Fixed ticks this frame runs
+		uint32_t GetFrameTickCount() const { return m_FrameTicks; }
+		uint64_t GetTickCount() const { return m_TickCount; }
+		uint64_t GetFrameCount() const { return m_FrameCount; }
+		// How far real time is between the last tick and the next one, in [0, 1)
+		double GetInterpolationAlpha() const { return m_Accumulator / m_TimeStep; }
+		// Simulation time given up to the catch-up limit so far, in seconds
+		double GetDroppedTime() const { return m_DroppedTime; }
+
+	private:
+
+		double m_TimeStep = DEFAULT_TIME_STEP;
+		uint32_t m_MaxCatchUpTicks = DEFAULT_MAX_CATCH_UP_TICKS;
+		double m_FrameRateCap = 0.0;
+
+		Clock::time_point m_FrameStart;
+		Clock::time_point m_NextFrame;
+		bool m_bStarted = false;
+
+		double m_DeltaTime = 0.0;
+		double m_Accumulator = 0.0;
+		double m_DroppedTime = 0.0;
+		uint32_t m_FrameTicks = 0;
+		uint64_t m_TickCount = 0;
+		uint64_t m_FrameCount = 0;
+
+	};
+
+}
@@ -0,0 +1,514 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "JobSystem.h"
+
+#include "Log.h"
+#include <cmath>
+#include <chrono>
+#include <limits>
+#include <cstring>
+
+namespace Tempus {
+
+	namespace {
+
+		thread_local JobSystem* t_System = nullptr;
+		thread_local uint32_t t_ThreadIndex = ~0u;
+
+		// Failed lookups yield between tries, a worker that finds nothing this many times in a row goes to sleep
+		constexpr uint32_t IDLE_SPINS = 64;
+
+	}
+
+	bool JobSystem::WorkDeque::Push(Job* job)
+	{
+		int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		int64_t top = m_Top.load(std::memory_order_acquire);
+
+		if (bottom - top >= static_cast<int64_t>(JOB_POOL_SIZE))
+		{
+			return false;
+		}
+
+		m_Jobs[bottom & (JOB_POOL_SIZE - 1)].store(job, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	Job* JobSystem::WorkDeque::Pop()
+	{
+		int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Job* job = m_Jobs[bottom & (JOB_POOL_SIZE - 1)].load(std::memory_order_relaxed);
+
+		// The last job, a thief may be after it too
+		if (top == bottom)
+		{
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				job = nullptr;
+			}
+
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	Job* JobSystem::WorkDeque::Steal()
+	{
+		int64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+		{
+			return nullptr;
+		}
+
+		Job* job = m_Jobs[top & (JOB_POOL_SIZE - 1)].load(std::memory_order_relaxed);
+
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			return nullptr;
+		}
+
+		return job;
+	}
+
+	JobSystem::~JobSystem()
+	{
+		Shutdown();
+	}
+
+	bool JobSystem::Init(uint32_t threadCount)
+	{
+		if (m_ThreadCount > 0)
+		{
+			TPS_CORE_WARN("Job system is already initialized!");
+			return false;
+		}
+
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		m_ThreadCount = std::clamp(threadCount, 1u, MAX_THREADS);
+		m_Threads = std::make_unique<ThreadState[]>(m_ThreadCount);
+
+		for (uint32_t i = 0; i < m_ThreadCount; i++)
+		{
+			m_Threads[i].Jobs = std::make_unique<Job[]>(JOB_POOL_SIZE);
+			m_Threads[i].StealSeed = i * 0x9E3779B9u + 1;
+		}
+
+		m_bStopping = false;
+
+		// The calling thread is thread 0
+		m_PreviousSystem = t_System;
+		m_PreviousThreadIndex = t_ThreadIndex;
+		t_System = this;
+		t_ThreadIndex = 0;
+
+		for (uint32_t i = 1; i < m_ThreadCount; i++)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+
+		return true;
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (m_ThreadCount == 0)
+		{
+			return;
+		}
+
+		// Whatever is still queued is abandoned, callers wait on their counters before shutting down
+		m_bStopping.store(true);
+		m_WakeEpoch.fetch_add(1);
+		m_WakeEpoch.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+
+		m_Workers.clear();
+
+		if (t_System == this)
+		{
+			t_System = m_PreviousSystem;
+			t_ThreadIndex = m_PreviousThreadIndex;
+		}
+
+		m_Threads.reset();
+		m_ThreadCount = 0;
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		uint32_t threadIndex = GetThreadIndex();
+
+		while (!counter.IsDone())
+		{
+			Job* job = threadIndex != INVALID_THREAD ? FindJob(threadIndex) : nullptr;
+
+			if (job)
+			{
+				Execute(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	Job* JobSystem::AllocateJob()
+	{
+		uint32_t threadIndex = GetThreadIndex();
+
+		if (threadIndex == INVALID_THREAD)
+		{
+			return nullptr;
+		}
+
+		ThreadState& thread = m_Threads[threadIndex];
+		Job* job = &thread.Jobs[thread.NextJob & (JOB_POOL_SIZE - 1)];
+
+		// The pool wrapped onto a job that hasn't finished yet. Helping finishes it, usually after very few jobs
+		while (job->bInUse.load(std::memory_order_acquire))
+		{
+			if (Job* other = FindJob(threadIndex))
+			{
+				Execute(other);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		thread.NextJob++;
+		job->bInUse.store(1, std::memory_order_relaxed);
+		job->Next = nullptr;
+
+		return job;
+	}
+
+	void JobSystem::Submit(Job* job, JobCounter* counter, JobCounter* dependency)
+	{
+		job->Counter = counter;
+
+		if (counter)
+		{
+			counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (dependency)
+		{
+			uint32_t value = dependency->m_Value.load(std::memory_order_acquire);
+
+			while (true)
+			{
+				if (value & JobCounter::LOCK_BIT)
+				{
+					value = dependency->m_Value.load(std::memory_order_acquire);
+					continue;
+				}
+
+				// Already done, the job can go right away
+				if ((value & JobCounter::COUNT_MASK) == 0)
+				{
+					break;
+				}
+
+				if (dependency->m_Value.compare_exchange_weak(value, value | JobCounter::LOCK_BIT, std::memory_order_acquire))
+				{
+					job->Next = dependency->m_Dependents;
+					dependency->m_Dependents = job;
+					dependency->m_Value.fetch_and(~JobCounter::LOCK_BIT, std::memory_order_release);
+					return;
+				}
+			}
+		}
+
+		Push(job);
+	}
+
+	void JobSystem::Push(Job* job)
+	{
+		if (!m_Threads[GetThreadIndex()].Deque.Push(job))
+		{
+			// Only when dependents released onto this thread overflow it
+			Execute(job);
+			return;
+		}
+
+		WakeWorkers();
+	}
+
+	void JobSystem::Execute(Job* job)
+	{
+		job->Fn(job->Data);
+
+		JobCounter* counter = job->Counter;
+		job->bInUse.store(0, std::memory_order_release);
+
+		if (counter)
+		{
+			Release(counter);
+		}
+	}
+
+	void JobSystem::Release(JobCounter* counter)
+	{
+		uint32_t value = counter->m_Value.load(std::memory_order_relaxed);
+
+		while (true)
+		{
+			if (value & JobCounter::LOCK_BIT)
+			{
+				value = counter->m_Value.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			if ((value & JobCounter::COUNT_MASK) > 1)
+			{
+				if (counter->m_Value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel))
+				{
+					return;
+				}
+
+				continue;
+			}
+
+			// The last job. Locking keeps the count at one while the dependents are taken, waiters can't see zero yet
+			if (counter->m_Value.compare_exchange_weak(value, value | JobCounter::LOCK_BIT, std::memory_order_acq_rel))
+			{
+				break;
+			}
+		}
+
+		Job* dependents = counter->m_Dependents;
+		counter->m_Dependents = nullptr;
+
+		// The counter may be gone from here on
+		counter->m_Value.fetch_sub(1 | JobCounter::LOCK_BIT, std::memory_order_acq_rel);
+
+		while (dependents)
+		{
+			Job* next = dependents->Next;
+			Push(dependents);
+			dependents = next;
+		}
+	}
+
+	Job* JobSystem::FindJob(uint32_t threadIndex)
+	{
+		ThreadState& thread = m_Threads[threadIndex];
+
+		if (Job* job = thread.Deque.Pop())
+		{
+			return job;
+		}
+
+		if (m_ThreadCount == 1)
+		{
+			return nullptr;
+		}
+
+		// Xorshift picks where to start so thieves spread over the victims
+		thread.StealSeed ^= thread.StealSeed << 13;
+		thread.StealSeed ^= thread.StealSeed >> 17;
+		thread.StealSeed ^= thread.StealSeed << 5;
+
+		uint32_t start = thread.StealSeed % m_ThreadCount;
+
+		for (uint32_t i = 0; i < m_ThreadCount; i++)
+		{
+			uint32_t victim = (start + i) % m_ThreadCount;
+
+			if (victim == threadIndex)
+			{
+				continue;
+			}
+
+			if (Job* job = m_Threads[victim].Deque.Steal())
+			{
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::WakeWorkers()
+	{
+		// Pairs with the sleeping count going up before a worker's last look for work
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (m_SleepingCount.load(std::memory_order_relaxed) > 0)
+		{
+			m_WakeEpoch.fetch_add(1, std::memory_order_release);
+			m_WakeEpoch.notify_one();
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t threadIndex)
+	{
+		t_System = this;
+		t_ThreadIndex = threadIndex;
+
+		uint32_t idleCount = 0;
+
+		while (!m_bStopping.load(std::memory_order_relaxed))
+		{
+			if (Job* job = FindJob(threadIndex))
+			{
+				Execute(job);
+				idleCount = 0;
+				continue;
+			}
+
+			if (++idleCount < IDLE_SPINS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			idleCount = 0;
+
+			// A push after the epoch is read bumps it, so the wait below returns right away instead of missing it
+			m_SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+			uint32_t epoch = m_WakeEpoch.load(std::memory_order_acquire);
+
+			if (Job* job = FindJob(threadIndex))
+			{
+				m_SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+				Execute(job);
+				continue;
+			}
+
+			if (!m_bStopping.load(std::memory_order_relaxed))
+			{
+				m_WakeEpoch.wait(epoch, std::memory_order_acquire);
+			}
+
+			m_SleepingCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		t_System = nullptr;
+		t_ThreadIndex = INVALID_THREAD;
+	}
+
+	uint32_t JobSystem::GetThreadIndex() const
+	{
+		return t_System == this ? t_ThreadIndex : INVALID_THREAD;
+	}
+
+	void JobSystem::RunBenchmark(uint32_t jobCount, uint32_t elementCount)
+	{
+		constexpr uint32_t ITERATIONS = 3;
+
+		uint32_t maxThreads = std::clamp(std::thread::hardware_concurrency(), 1u, MAX_THREADS);
+
+		std::vector<float> input(elementCount);
+		std::vector<float> expected(elementCount);
+		std::vector<float> output(elementCount);
+
+		for (uint32_t i = 0; i < elementCount; i++)
+		{
+			input[i] = static_cast<float>(i % 1000) * 0.01f;
+		}
+
+		auto kernel = [&input](float* out, uint32_t first, uint32_t count)
+		{
+			for (uint32_t i = first; i < first + count; i++)
+			{
+				out[i] = std::sqrt(input[i] * input[i] + 1.0f) * 0.5f;
+			}
+		};
+
+		auto elapsed = [](std::chrono::high_resolution_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		// Plain loop without the job system for reference
+		double serialTime = std::numeric_limits<double>::max();
+
+		for (uint32_t i = 0; i < ITERATIONS; i++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			kernel(expected.data(), 0, elementCount);
+			serialTime = std::min(serialTime, elapsed(start));
+		}
+
+		TPS_CORE_INFO("Job benchmark: {0} empty jobs and ParallelFor over {1} floats, best of {2} runs", jobCount, elementCount, ITERATIONS);
+		TPS_CORE_INFO("\tSerial loop: {0:.3f} ms", serialTime);
+
+		double singleThreadJobTime = 0.0;
+		double singleThreadForTime = 0.0;
+
+		for (uint32_t threads = 1; threads <= maxThreads; threads++)
+		{
+			JobSystem jobs;
+			jobs.Init(threads);
+
+			double jobTime = std::numeric_limits<double>::max();
+			double forTime = std::numeric_limits<double>::max();
+			bool bMatches = true;
+
+			for (uint32_t i = 0; i < ITERATIONS; i++)
+			{
+				JobCounter counter;
+
+				auto start = std::chrono::high_resolution_clock::now();
+
+				for (uint32_t job = 0; job < jobCount; job++)
+				{
+					jobs.Run([]() {}, &counter);
+				}
+
+				jobs.Wait(counter);
+				jobTime = std::min(jobTime, elapsed(start));
+
+				std::fill(output.begin(), output.end(), 0.0f);
+
+				start = std::chrono::high_resolution_clock::now();
+				jobs.ParallelFor(elementCount, [&kernel, &output](uint32_t first, uint32_t count) { kernel(output.data(), first, count); });
+				forTime = std::min(forTime, elapsed(start));
+
+				bMatches &= std::memcmp(output.data(), expected.data(), elementCount * sizeof(float)) == 0;
+			}
+
+			jobs.Shutdown();
+
+			if (threads == 1)
+			{
+				singleThreadJobTime = jobTime;
+				singleThreadForTime = forTime;
+			}
+
+			TPS_CORE_INFO("\t{0} threads: {1:.2f} M jobs/s ({2:.2f}x), ParallelFor {3:.3f} ms ({4:.2f}x){5}", threads,
+				jobTime > 0.0 ? jobCount / (jobTime * 1000.0) : 0.0, singleThreadJobTime / jobTime, forTime, singleThreadForTime / forTime,
+				bMatches ? "" : " MISMATCH");
+		}
+	}
+
+}
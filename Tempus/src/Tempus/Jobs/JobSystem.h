@@ -0,0 +1,222 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+
+namespace Tempus {
+
+	class JobCounter;
+
+	// Two cache lines with the captured data inline, so running a job never allocates
+	struct alignas(64) Job
+	{
+		static constexpr uint32_t MAX_DATA_SIZE = 96;
+
+		void (*Fn)(void* data) = nullptr;
+		JobCounter* Counter = nullptr;
+		// Next job waiting on the same dependency
+		Job* Next = nullptr;
+		std::atomic<uint32_t> bInUse = 0;
+		alignas(16) std::byte Data[MAX_DATA_SIZE];
+	};
+
+	// Counts a group of unfinished jobs. Run() adds one per job and the job takes it off once it has returned. Wait() on it
+	// to join the group, or pass it to Run() as a dependency to hold a job back until the count drops to zero. It must
+	// outlive its jobs and the jobs depending on it
+	class TEMPUS_API JobCounter
+	{
+	public:
+
+		JobCounter() = default;
+
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		uint32_t GetCount() const { return m_Value.load(std::memory_order_acquire) & COUNT_MASK; }
+		bool IsDone() const { return GetCount() == 0; }
+
+	private:
+
+		friend class JobSystem;
+
+		// Guards m_Dependents, so the count dropping to zero and the dependents being taken are one step
+		static constexpr uint32_t LOCK_BIT = 1u << 31;
+		static constexpr uint32_t COUNT_MASK = LOCK_BIT - 1;
+
+		std::atomic<uint32_t> m_Value = 0;
+		Job* m_Dependents = nullptr;
+
+	};
+
+	// Work stealing job system with one thread per hardware thread, the calling thread included. Every thread owns a
+	// Chase-Lev deque: it pushes and pops its own jobs at the bottom, idle threads steal from the top of the others.
+	// Jobs are lambdas of trivially copyable captures run from a per thread pool of JOB_POOL_SIZE slots.
+	//
+	// Run(), Wait() and ParallelFor() belong to the thread that called Init() and to jobs. Waiting runs other jobs
+	// instead of blocking, so jobs may fork and join freely. Other threads' Run() calls the job right away
+	class TEMPUS_API JobSystem
+	{
+	public:
+
+		static constexpr uint32_t MAX_THREADS = 64;
+		// Also the capacity of every deque, both must be powers of two
+		static constexpr uint32_t JOB_POOL_SIZE = 4096;
+		// ParallelFor() splits into about this many ranges per thread, enough for stealing to even out uneven ranges
+		static constexpr uint32_t RANGES_PER_THREAD = 4;
+
+		JobSystem() = default;
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// threadCount includes the calling thread. 0 picks one per hardware thread
+		bool Init(uint32_t threadCount = 0);
+		void Shutdown();
+
+		// func is called with no arguments. counter, when given, counts the job until it returns. dependency, when given,
+		// holds the job back until its count is zero
+		template<typename F>
+		void Run(F&& func, JobCounter* counter = nullptr, JobCounter* dependency = nullptr)
+		{
+			using Func = std::decay_t<F>;
+			static_assert(sizeof(Func) <= Job::MAX_DATA_SIZE && alignof(Func) <= 16, "Job captures too much, capture a pointer to the data instead");
+			static_assert(std::is_trivially_copyable_v<Func> && std::is_trivially_destructible_v<Func>, "Jobs are never destroyed, their captures must be trivially copyable");
+
+			Job* job = AllocateJob();
+
+			if (!job)
+			{
+				// Not one of our threads, there is no deque to push to
+				if (dependency)
+				{
+					Wait(*dependency);
+				}
+
+				func();
+				return;
+			}
+
+			new (job->Data) Func(std::forward<F>(func));
+			job->Fn = [](void* data) { (*std::launder(reinterpret_cast<Func*>(data)))(); };
+
+			Submit(job, counter, dependency);
+		}
+
+		// Runs other jobs until the count is zero
+		void Wait(const JobCounter& counter);
+
+		// Calls func(first, count) over ranges that together cover [0, count) and returns once all of them have. Ranges are
+		// split in halves as they are stolen, grainSize is the largest range a thread runs without splitting further.
+		// 0 sizes it from the thread count
+		template<typename F>
+		void ParallelFor(uint32_t count, const F& func, uint32_t grainSize = 0)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			if (grainSize == 0)
+			{
+				grainSize = GetGrainSize(count);
+			}
+
+			JobCounter counter;
+			SplitRange(this, &func, 0, count, grainSize, &counter);
+			Wait(counter);
+		}
+
+		uint32_t GetThreadCount() const { return m_ThreadCount; }
+		uint32_t GetGrainSize(uint32_t count) const { return std::max(1u, count / (m_ThreadCount * RANGES_PER_THREAD)); }
+
+		// Logs empty jobs per second and ParallelFor() time over elementCount floats with 1 to N threads
+		static void RunBenchmark(uint32_t jobCount = 1000000, uint32_t elementCount = 10000000);
+
+	private:
+
+		// Bounded Chase-Lev deque after Lê et al., "Correct and Efficient Work-Stealing for Weak Memory Models"
+		class WorkDeque
+		{
+		public:
+
+			bool Push(Job* job);
+			// Owner only, newest first
+			Job* Pop();
+			// Any thread, oldest first. Returns nullptr when empty or when it loses a race
+			Job* Steal();
+
+		private:
+
+			alignas(64) std::atomic<int64_t> m_Top = 0;
+			alignas(64) std::atomic<int64_t> m_Bottom = 0;
+			std::atomic<Job*> m_Jobs[JOB_POOL_SIZE] = {};
+
+		};
+
+		struct alignas(64) ThreadState
+		{
+			WorkDeque Deque;
+			std::unique_ptr<Job[]> Jobs;
+			uint32_t NextJob = 0;
+			uint32_t StealSeed = 0;
+		};
+
+		template<typename F>
+		static void SplitRange(JobSystem* system, const F* func, uint32_t first, uint32_t end, uint32_t grainSize, JobCounter* counter)
+		{
+			// The upper half goes up for grabs, this thread carries on with the lower one
+			while (end - first > grainSize)
+			{
+				uint32_t middle = first + (end - first) / 2;
+				system->Run([=]() { SplitRange(system, func, middle, end, grainSize, counter); }, counter);
+				end = middle;
+			}
+
+			(*func)(first, end - first);
+		}
+
+		Job* AllocateJob();
+		void Submit(Job* job, JobCounter* counter, JobCounter* dependency);
+		void Push(Job* job);
+		void Execute(Job* job);
+		void Release(JobCounter* counter);
+		Job* FindJob(uint32_t threadIndex);
+		void WakeWorkers();
+		void WorkerLoop(uint32_t threadIndex);
+
+		// Index of the calling thread, INVALID_THREAD when it isn't one of ours
+		uint32_t GetThreadIndex() const;
+
+		static constexpr uint32_t INVALID_THREAD = ~0u;
+
+	private:
+
+		uint32_t m_ThreadCount = 0;
+		std::unique_ptr<ThreadState[]> m_Threads;
+		std::vector<std::thread> m_Workers;
+
+		// Sleeping workers wait on the epoch, pushes bump it when anyone is asleep
+		alignas(64) std::atomic<uint32_t> m_WakeEpoch = 0;
+		std::atomic<uint32_t> m_SleepingCount = 0;
+		std::atomic<bool> m_bStopping = false;
+
+		// What the calling thread belonged to before Init(), restored by Shutdown()
+		JobSystem* m_PreviousSystem = nullptr;
+		uint32_t m_PreviousThreadIndex = INVALID_THREAD;
+
+	};
+
+}
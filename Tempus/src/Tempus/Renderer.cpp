@@ -5,15 +5,20 @@
 #include "Window.h"
 #include "Log.h"
 #include "Utils/FileUtils.h"
+#include "Renderer/Shaders/EmbeddedShaders.h"
 #include "sdl/SDL_vulkan.h"
 #include <iostream>
 #include <set>
 #include <sstream>
 #include <algorithm> 
+#include <cstring>
+#include <limits>
 
 
 Tempus::Renderer::Renderer()
 {
+	m_GamePacket = m_Packets.Acquire();
+	std::copy(m_ClearColour, m_ClearColour + 4, m_GamePacket->ClearColour);
 }
 
 Tempus::Renderer::~Renderer()
@@ -23,19 +28,143 @@ Tempus::Renderer::~Renderer()
 
 void Tempus::Renderer::Update()
 {
+	RethrowRenderThreadError();
+
+	QueryDrawableSize(*m_GamePacket);
+
+	if (!m_RenderThread.joinable())
+	{
+		RenderPacket(*m_GamePacket);
+		m_GamePacket->BeginFrom(*m_GamePacket);
+		return;
+	}
+
+	FramePacket* published = m_GamePacket;
+	m_Packets.Publish(published);
+
+	// Blocks while the render thread still holds the other packet, the game thread never runs more than a frame ahead
+	m_GamePacket = m_Packets.Acquire();
+	m_GamePacket->BeginFrom(*published);
+}
+
+void Tempus::Renderer::RenderPacket(const FramePacket& packet)
+{
+	std::copy(packet.ClearColour, packet.ClearColour + 4, m_ClearColour);
+	m_DrawableWidth = packet.DrawableWidth;
+	m_DrawableHeight = packet.DrawableHeight;
+
+	if (packet.bHasViewProjection)
+	{
+		m_Batches.SetViewProjection(packet.ViewProjection);
+	}
+
+	for (const BatchInstance& instance : packet.Instances)
+	{
+		m_Batches.Submit(instance.Mesh, instance.Material, instance.Transform);
+	}
+
+	m_PendingDraws.insert(m_PendingDraws.end(), packet.Draws.begin(), packet.Draws.end());
+
+	if (!packet.CapturePath.empty())
+	{
+		m_CapturePath = packet.CapturePath;
+	}
+
 	DrawFrame();
+
+	// Submissions only ever apply to the frame they were made for, including frames skipped for a resize
+	m_PendingDraws.clear();
+	m_Batches.EndFrame();
+}
+
+void Tempus::Renderer::QueryDrawableSize(FramePacket& packet) const
+{
+	if (!m_Window)
+	{
+		return;
+	}
+
+	// The drawable size (pixels) may differ from the window size (screen coordinates) on high DPI displays (Mac Retina)
+	int width = 0, height = 0;
+	SDL_Vulkan_GetDrawableSize(m_Window->GetNativeWindow(), &width, &height);
+
+	packet.DrawableWidth = static_cast<uint32_t>(std::max(width, 0));
+	packet.DrawableHeight = static_cast<uint32_t>(std::max(height, 0));
+}
+
+void Tempus::Renderer::RenderThreadLoop()
+{
+	while (FramePacket* packet = m_Packets.Pop())
+	{
+		// Nothing up this thread's stack could handle it, so it goes to the game thread
+		try
+		{
+			RenderPacket(*packet);
+		}
+		catch (...)
+		{
+			m_RenderThreadError = std::current_exception();
+			m_bRenderThreadFailed.store(true, std::memory_order_release);
+
+			// Frees the game thread if it's blocked on the queue, later packets are dropped
+			m_Packets.Release(packet);
+			m_Packets.Close();
+			return;
+		}
+
+		m_Packets.Release(packet);
+	}
+}
+
+void Tempus::Renderer::FlushRenderThread()
+{
+	if (m_RenderThread.joinable())
+	{
+		m_Packets.WaitIdle();
+	}
+
+	RethrowRenderThreadError();
+}
+
+void Tempus::Renderer::RethrowRenderThreadError()
+{
+	if (!m_bRenderThreadFailed.load(std::memory_order_acquire) || !m_RenderThreadError)
+	{
+		return;
+	}
+
+	std::exception_ptr error = m_RenderThreadError;
+	m_RenderThreadError = nullptr;
+	std::rethrow_exception(error);
+}
+
+void Tempus::Renderer::CheckRenderThreadIdle() const
+{
+#ifdef TPS_DEBUG
+	if (m_RenderThread.joinable() && std::this_thread::get_id() != m_RenderThread.get_id() && !m_Packets.IsIdle())
+	{
+		TPS_CORE_ERROR("Render thread subsystem used while frames are in flight, call FlushRenderThread() first!");
+	}
+#endif
 }
 
 bool Tempus::Renderer::Init(Tempus::Window* window)
 {
 
+	m_InitStartTime = std::chrono::high_resolution_clock::now();
+
 	m_Window = window;
 
-	if (!m_Window) 
+	if (!m_Window && !m_bHeadless) 
 	{
 		return false;
 	}
 
+	// The swap chain is first created here, on the game thread, before any packet has brought a size along
+	QueryDrawableSize(*m_GamePacket);
+	m_DrawableWidth = m_GamePacket->DrawableWidth;
+	m_DrawableHeight = m_GamePacket->DrawableHeight;
+
 	if (!CreateVulkanInstance())
 	{
 		return false;
@@ -46,7 +175,7 @@ bool Tempus::Renderer::Init(Tempus::Window* window)
 		return false;
 	}
 
-	if (!CreateSurface(m_Window))
+	if (!m_bHeadless && !CreateSurface(m_Window))
 	{
 		return false;
 	}
@@ -61,7 +190,43 @@ bool Tempus::Renderer::Init(Tempus::Window* window)
 		return false;
 	}
 
-	if (!CreateSwapChain()) 
+	if (!m_Allocator.Init(m_PhysicalDevice, m_Device, GPUAllocator::DEFAULT_BLOCK_SIZE, true))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize GPU allocator!");
+		return false;
+	}
+
+	QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
+
+	m_Deletions.Init(m_Device, &m_Allocator);
+
+	if (!m_Uploads.Init(m_Device, &m_Allocator, m_TransferQueue, indices.transferFamily.value(), m_GraphicsQueue, indices.graphicsFamily.value()))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize upload manager!");
+		return false;
+	}
+
+	if (!m_Uniforms.Init(m_PhysicalDevice, m_Device, &m_Allocator, m_FramesInFlight))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize uniform allocator!");
+		return false;
+	}
+
+	m_DescriptorLayouts.Init(m_Device);
+
+	if (!m_Bindless.Init(m_PhysicalDevice, m_Device, &m_Deletions, m_bBindless))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize bindless descriptors!");
+		return false;
+	}
+
+	// Programs declaring the bindless set get its layout, so the one set binds with every pipeline
+	if (m_Bindless.IsSupported())
+	{
+		m_DescriptorLayouts.ReserveSet(BindlessDescriptors::SET, m_Bindless.GetLayout());
+	}
+
+	if (m_bHeadless ? !CreateOffscreenTargets() : !CreateSwapChain()) 
 	{
 		return false;
 	}
@@ -71,7 +236,21 @@ bool Tempus::Renderer::Init(Tempus::Window* window)
 		return false;
 	}
 
-	if (!CreateRenderPass()) 
+	if (!m_RenderGraph.Init(m_Device, &m_Allocator, &m_Deletions))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize render graph!");
+		return false;
+	}
+
+	if (!m_Profiler.Init(m_PhysicalDevice, m_Device, indices.graphicsFamily.value(), m_FramesInFlight))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize GPU profiler!");
+		return false;
+	}
+
+	m_RenderGraph.SetProfiler(&m_Profiler);
+
+	if (!CreatePipelineCache())
 	{
 		return false;
 	}
@@ -81,18 +260,50 @@ bool Tempus::Renderer::Init(Tempus::Window* window)
 		return false;
 	}
 
-	if(!CreateFrameBuffers())
+	if (!m_Scene.Init(m_Device, &m_Allocator, &m_Uploads, &m_PipelineStates, m_PipelineCache, m_FramesInFlight))
 	{
+		TPS_CORE_CRITICAL("Failed to initialize GPU scene!");
 		return false;
 	}
 
+	if (!m_Batches.Init(m_Device, &m_Allocator, &m_Uploads, &m_PipelineStates, m_FramesInFlight))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize batch renderer!");
+		return false;
+	}
+
+	if (m_bEnableShaderHotReload && m_PipelineReloader.Init(m_Device, &m_Deletions))
+	{
+		m_PipelineReloader.RegisterReload("Main", {
+				{ "Tempus/res/shaders/shader.vert", "bin/shaders/vert.spv" },
+				{ "Tempus/res/shaders/shader.frag", "bin/shaders/frag.spv" }
+			},
+			[this](const std::vector<ShaderCode>& code) { return m_PipelineStates.ReloadProgram(m_MainProgram, code[0], code[1]); });
+
+		m_Scene.RegisterPipelines(m_PipelineReloader);
+		m_Batches.RegisterPrograms(m_PipelineReloader);
+	}
+
 	if (!CreateCommandPool()) 
 	{
 		return false;
 	}
 
-	if (!CreateCommandBuffer())
+	if (!CreateCommandBuffers())
+	{
+		return false;
+	}
+
+	if (!m_Recorder.Init(m_Device, indices.graphicsFamily.value(), m_FramesInFlight, m_RecordingThreadCount))
+	{
+		TPS_CORE_CRITICAL("Failed to initialize command recorder!");
+		return false;
+	}
+
+	// One allocator per recording thread, so it has to know how many there are
+	if (!m_FrameDescriptors.Init(m_Device, m_FramesInFlight, m_Recorder.GetThreadCount()))
 	{
+		TPS_CORE_CRITICAL("Failed to initialize frame descriptor allocator!");
 		return false;
 	}
 
@@ -101,6 +312,12 @@ bool Tempus::Renderer::Init(Tempus::Window* window)
 		return false;
 	}
 
+	if (m_bRenderThread)
+	{
+		m_RenderThread = std::thread(&Renderer::RenderThreadLoop, this);
+		TPS_CORE_INFO("Rendering on a dedicated thread");
+	}
+
 	return true;
 
 }
@@ -118,48 +335,229 @@ void Tempus::Renderer::RenderPresent()
 
 void Tempus::Renderer::SetRenderDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
 {
-	m_ClearColour[0] = r / 255.0f;
-	m_ClearColour[1] = g / 255.0f;
-	m_ClearColour[2] = b / 255.0f;
-	m_ClearColour[3] = a / 255.0f;
+	m_GamePacket->ClearColour[0] = r / 255.0f;
+	m_GamePacket->ClearColour[1] = g / 255.0f;
+	m_GamePacket->ClearColour[2] = b / 255.0f;
+	m_GamePacket->ClearColour[3] = a / 255.0f;
+}
+
+void Tempus::Renderer::SetViewProjection(const float viewProjection[16])
+{
+	std::copy(viewProjection, viewProjection + 16, m_GamePacket->ViewProjection);
+	m_GamePacket->bHasViewProjection = true;
+}
+
+void Tempus::Renderer::SetFramesInFlight(uint32_t count)
+{
+	if (m_Device != VK_NULL_HANDLE)
+	{
+		TPS_CORE_WARN("Frames in flight must be set before the renderer is initialized!");
+		return;
+	}
+
+	m_FramesInFlight = std::clamp(count, 1u, MAX_FRAMES_IN_FLIGHT);
+}
+
+void Tempus::Renderer::SetRecordingThreadCount(uint32_t count)
+{
+	if (m_Device != VK_NULL_HANDLE)
+	{
+		TPS_CORE_WARN("Recording thread count must be set before the renderer is initialized!");
+		return;
+	}
+
+	m_RecordingThreadCount = std::min(count, CommandRecorder::MAX_THREADS);
+}
+
+void Tempus::Renderer::SetRenderThread(bool bEnabled)
+{
+	if (m_Device != VK_NULL_HANDLE)
+	{
+		TPS_CORE_WARN("Render thread must be set before the renderer is initialized!");
+		return;
+	}
+
+	m_bRenderThread = bEnabled;
+}
+
+void Tempus::Renderer::SetHeadless(const HeadlessConfig& config)
+{
+	if (m_Device != VK_NULL_HANDLE)
+	{
+		TPS_CORE_WARN("Headless mode must be set before the renderer is initialized!");
+		return;
+	}
+
+	m_bHeadless = true;
+	m_HeadlessConfig = config;
+	m_HeadlessConfig.Width = std::max(config.Width, 1u);
+	m_HeadlessConfig.Height = std::max(config.Height, 1u);
+}
+
+void Tempus::Renderer::RunRecordingBenchmark(uint32_t drawCount)
+{
+	// Records on the render thread's frame slot and recorder
+	FlushRenderThread();
+
+	// Recording reuses the current frame slot's pools, which the GPU may still be reading from
+	vkDeviceWaitIdle(m_Device);
+
+	std::vector<DrawCommand> draws(drawCount, DrawCommand{ 3, 1, 0, 0 });
+
+	VkCommandBufferInheritanceRenderingInfo renderingInheritance = GetMainPassInheritance();
+
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.pNext = &renderingInheritance;
+
+	CommandRecorder::RecordFunc recordFunc = [this, &draws](VkCommandBuffer commandBuffer, uint32_t, uint32_t first, uint32_t count)
+		{
+			RecordDraws(commandBuffer, draws.data() + first, count);
+		};
+
+	constexpr uint32_t ITERATIONS = 10;
+	std::vector<VkCommandBuffer> commandBuffers;
+	double singleThreadTime = 0.0;
+
+	TPS_CORE_INFO("Recording benchmark: {0} draws, best of {1} runs", drawCount, ITERATIONS);
+
+	for (uint32_t threads = 1; threads <= m_Recorder.GetThreadCount(); threads++)
+	{
+		double bestTime = std::numeric_limits<double>::max();
+
+		for (uint32_t i = 0; i < ITERATIONS; i++)
+		{
+			m_Recorder.BeginFrame(m_CurrentFrame);
+			commandBuffers.clear();
+
+			auto start = std::chrono::high_resolution_clock::now();
+			bool bRecorded = m_Recorder.Record(inheritance, drawCount, recordFunc, commandBuffers, threads);
+			auto end = std::chrono::high_resolution_clock::now();
+
+			if (!bRecorded)
+			{
+				TPS_CORE_ERROR("Recording benchmark failed with {0} threads!", threads);
+				m_Recorder.BeginFrame(m_CurrentFrame);
+				return;
+			}
+
+			bestTime = std::min(bestTime, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+
+		if (threads == 1)
+		{
+			singleThreadTime = bestTime;
+		}
+
+		TPS_CORE_INFO("\t{0} threads: {1:.3f} ms ({2:.2f}x)", threads, bestTime, singleThreadTime / bestTime);
+	}
+
+	m_Recorder.BeginFrame(m_CurrentFrame);
 }
 
 void Tempus::Renderer::DrawFrame()
 {
-	// Wait for previous frame to finish drawing
-	vkWaitForFences(m_Device, 1, &m_InFlightFence, VK_TRUE, UINT64_MAX);
-	// Reset fence signal
-	vkResetFences(m_Device, 1, &m_InFlightFence);
+	FrameData& frame = m_Frames[m_CurrentFrame];
+
+	// Wait for the GPU to finish the last submission that used this frame's resources.
+	// With more than one frame in flight the CPU can record this frame while the GPU works on the previous ones
+	WaitForFrame(frame.FrameValue);
+
+	// Swaps in pipelines rebuilt since the last frame, nothing recorded from here on uses the old ones
+	if (m_bEnableShaderHotReload)
+	{
+		m_PipelineReloader.Update();
+	}
+
+	m_Deletions.Update(m_FrameValue, GetCompletedFrameValue());
+
+	uint32_t imageIndex = m_CurrentFrame;
+	VkResult result = VK_SUCCESS;
+
+	// Offscreen targets belong to a frame slot, so the wait above already made this one available
+	if (!m_bHeadless)
+	{
+		// Retrieve image from swap chain
+		result = vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, frame.ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
 
-	uint32_t imageIndex;
-	// Retrieve image from swap chain
-	vkAcquireNextImageKHR(m_Device, m_SwapChain, UINT64_MAX, m_ImageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+		// Swap chain no longer matches the surface and can't be presented to. Suboptimal images are still presentable
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			RecreateSwapChain();
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			throw std::runtime_error("Failed to acquire swap chain image!");
+		}
+	}
 
-	vkResetCommandBuffer(m_CommandBuffer, 0);
+	// Queue this frame's uploads for the transfer queue. Rendering waits on their timeline value
+	uint64_t uploadWaitValue = m_Uploads.Flush(m_SubmitBatch);
 
-	RecordCommandBuffer(m_CommandBuffer, imageIndex);
+	vkResetCommandBuffer(frame.CommandBuffer, 0);
+	// The frame wait also covers the secondary command buffers recorded for this frame slot
+	m_Recorder.BeginFrame(m_CurrentFrame);
+	m_Uniforms.BeginFrame(m_CurrentFrame);
+	m_FrameDescriptors.BeginFrame(m_CurrentFrame);
+	m_Scene.BeginFrame(m_CurrentFrame);
+	m_Batches.BeginFrame(m_CurrentFrame);
 
+	// The swap chain image is already acquired and the uploads are queued, a frame that failed to record can't be
+	// skipped without leaving both dangling
+	if (!RecordCommandBuffer(frame.CommandBuffer, imageIndex))
+	{
+		throw std::runtime_error("Failed to record draw command buffer!");
+	}
 
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	uint64_t frameValue = m_FrameValue + 1;
 
-	VkSemaphore waitSemaphores[] = { m_ImageAvailableSemaphore };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_CommandBuffer;
+	m_SubmitBatch.Begin(m_GraphicsQueue);
 
-	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphore };
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	if (!m_bHeadless)
+	{
+		m_SubmitBatch.AddWait(frame.ImageAvailableSemaphore, 0, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+	}
 
-	if (vkQueueSubmit(m_GraphicsQueue, 1, &submitInfo, m_InFlightFence) != VK_SUCCESS) 
+	if (uploadWaitValue > 0)
+	{
+		m_SubmitBatch.AddWait(m_Uploads.GetTimelineSemaphore(), uploadWaitValue, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+	}
+
+	m_SubmitBatch.AddCommandBuffer(frame.CommandBuffer)
+		.AddSignal(m_FrameTimeline, frameValue);
+
+	// Presentation can only wait on binary semaphores. Nothing is presented in headless mode
+	if (!m_bHeadless)
+	{
+		m_SubmitBatch.AddSignal(m_RenderFinishedSemaphores[imageIndex], 0);
+	}
+
+	// Uploads and rendering go out together, in a single call when they share a queue
+	if (!m_SubmitBatch.Flush())
 	{
 		throw std::runtime_error("Failed to submit draw command buffer!");
 	}
 
+	m_FrameValue = frameValue;
+	frame.FrameValue = frameValue;
+
+	if (m_bHeadless)
+	{
+		if (!m_CaptureInFlight.empty())
+		{
+			// Only captures stall, until this frame has completed
+			WaitForFrame(frameValue);
+			WriteCapture();
+		}
+
+		m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+		UpdateFrameStats();
+		return;
+	}
+
+	VkSemaphore signalSemaphores[] = { m_RenderFinishedSemaphores[imageIndex] };
+
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -172,8 +570,82 @@ void Tempus::Renderer::DrawFrame()
 	presentInfo.pImageIndices = &imageIndex;
 	presentInfo.pResults = nullptr; // Optional
 
-	vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+	result = vkQueuePresentKHR(m_PresentQueue, &presentInfo);
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_bFramebufferResized)
+	{
+		m_bFramebufferResized = false;
+		RecreateSwapChain();
+	}
+	else if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to present swap chain image!");
+	}
+
+	m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
+
+	if (!m_bFirstFramePresented)
+	{
+		m_bFirstFramePresented = true;
+
+		double timeToFirstFrame = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_InitStartTime).count();
+		TPS_CORE_INFO("Time to first frame: {0:.2f} ms ({1} pipeline cache)", timeToFirstFrame, m_bPipelineCacheWarm ? "warm" : "cold");
+	}
+
+	UpdateFrameStats();
+
+}
+
+uint64_t Tempus::Renderer::GetCompletedFrameValue() const
+{
+	uint64_t completed = 0;
+	vkGetSemaphoreCounterValue(m_Device, m_FrameTimeline, &completed);
+	return completed;
+}
+
+void Tempus::Renderer::WaitForFrame(uint64_t frameValue) const
+{
+	if (frameValue == 0)
+	{
+		return;
+	}
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_FrameTimeline;
+	waitInfo.pValues = &frameValue;
+
+	vkWaitSemaphores(m_Device, &waitInfo, UINT64_MAX);
+}
+
+void Tempus::Renderer::UpdateFrameStats()
+{
+	auto now = std::chrono::high_resolution_clock::now();
+
+	// First frame has nothing to measure against
+	if (m_LastFrameTime.time_since_epoch().count() != 0)
+	{
+		m_FrameTimeAccumulator += std::chrono::duration<double, std::milli>(now - m_LastFrameTime).count();
+		m_FrameTimeSamples++;
+	}
+
+	m_LastFrameTime = now;
+
+	if (m_FrameTimeSamples == FRAME_STATS_WINDOW)
+	{
+		double averageFrameTime = m_FrameTimeAccumulator / m_FrameTimeSamples;
+		m_AverageFrameTime.store(averageFrameTime, std::memory_order_relaxed);
+		TPS_CORE_TRACE("Frame time: {0:.3f} ms ({1} frames in flight)", averageFrameTime, m_FramesInFlight);
+
+		for (const GPUScopeTiming& timing : m_Profiler.GetTimings())
+		{
+			TPS_CORE_TRACE("\tGPU {0}: {1:.3f} ms", timing.Name, timing.AverageMilliseconds);
+		}
 
+		m_FrameTimeAccumulator = 0.0;
+		m_FrameTimeSamples = 0;
+	}
 }
 
 bool Tempus::Renderer::CreateVulkanInstance()
@@ -294,7 +766,7 @@ bool Tempus::Renderer::CreateLogicalDevice()
 
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 	// Set of all unique queue families
-	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+	std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value() };
 
 	float queuePriority = 1.0f;
 
@@ -311,14 +783,62 @@ bool Tempus::Renderer::CreateLogicalDevice()
 	}
 
 	VkPhysicalDeviceFeatures deviceFeatures{};
+	// GPU scene draws every visible instance from one indirect buffer
+	deviceFeatures.multiDrawIndirect = VK_TRUE;
+
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	// Upload completion tracking
+	features12.timelineSemaphore = VK_TRUE;
+	// GPU scene buffers are reached through push constant addresses and drawn with a GPU written count
+	features12.bufferDeviceAddress = VK_TRUE;
+	features12.drawIndirectCount = VK_TRUE;
+
+	// Optional. Textures, samplers and storage buffers are reached through handles into one bindless set
+	m_bBindless = CheckBindlessSupport(m_PhysicalDevice);
+
+	if (m_bBindless)
+	{
+		features12.runtimeDescriptorArray = VK_TRUE;
+		features12.descriptorBindingPartiallyBound = VK_TRUE;
+		features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+	}
+
+	VkPhysicalDeviceVulkan13Features features13{};
+	features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	// Render graph passes begin rendering without render pass objects and use vkCmdPipelineBarrier2
+	features13.dynamicRendering = VK_TRUE;
+	features13.synchronization2 = VK_TRUE;
+	features12.pNext = &features13;
+
+	std::vector<const char*> deviceExtensions = GetDeviceExtensions();
+
+	// Optional. Setting blending dynamically keeps blend modes from multiplying pipelines
+	m_bDynamicBlend = CheckDynamicBlendSupport(m_PhysicalDevice);
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3{};
+	dynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+	if (m_bDynamicBlend)
+	{
+		dynamicState3.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+		dynamicState3.extendedDynamicState3ColorBlendEquation = VK_TRUE;
+		features13.pNext = &dynamicState3;
+		deviceExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+	}
 	
 	VkDeviceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = &features12;
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 	createInfo.pEnabledFeatures = &deviceFeatures;
-	createInfo.enabledExtensionCount = static_cast<uint32_t>(m_DeviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
 	// Modern Vulkan makes no distinction between instance and device layers and therefore ignores this data,
 	// however it is still good to set these values for compatibility
@@ -341,11 +861,12 @@ bool Tempus::Renderer::CreateLogicalDevice()
 	// Retrieve reference to devices graphics queue, index 0 because we only have 1 queue
 	vkGetDeviceQueue(m_Device, indices.graphicsFamily.value(), 0, &m_GraphicsQueue);
 	vkGetDeviceQueue(m_Device, indices.presentFamily.value(), 0, &m_PresentQueue);
+	vkGetDeviceQueue(m_Device, indices.transferFamily.value(), 0, &m_TransferQueue);
 	
 	return true;
 }
 
-bool Tempus::Renderer::CreateSwapChain()
+bool Tempus::Renderer::CreateSwapChain(VkSwapchainKHR oldSwapChain)
 {
 	SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(m_PhysicalDevice);
 
@@ -382,7 +903,7 @@ bool Tempus::Renderer::CreateSwapChain()
 	// Would probably need to disable this if doing some sort of screen space rendering
 	createInfo.clipped = VK_TRUE;
 	// When a swap chain is invalidated or destroyed and a new one is created, the old one must be provided
-	createInfo.oldSwapchain = VK_NULL_HANDLE;
+	createInfo.oldSwapchain = oldSwapChain;
 
 
 	QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
@@ -424,6 +945,123 @@ bool Tempus::Renderer::CreateSwapChain()
 	return true;
 }
 
+bool Tempus::Renderer::RecreateSwapChain()
+{
+	// A minimized window has a zero sized drawable which can't back a swap chain. Keep the flag set and retry later
+	if (m_DrawableWidth == 0 || m_DrawableHeight == 0)
+	{
+		m_bFramebufferResized = true;
+		return false;
+	}
+
+	// Image views of the old swap chain may still be referenced by frames in flight
+	vkDeviceWaitIdle(m_Device);
+
+	VkSwapchainKHR oldSwapChain = m_SwapChain;
+	size_t oldImageCount = m_SwapChainImages.size();
+
+	// Only the extent dependent objects are rebuilt. Pipelines use dynamic viewport and scissor, and the cached ones
+	// are keyed on the colour format, so a surface format change picks up new ones on the next frame
+	DestroySwapChainResources();
+
+	if (!CreateSwapChain(oldSwapChain))
+	{
+		return false;
+	}
+
+	// The old swap chain is retired by the new one and can be destroyed once it is no longer in use
+	vkDestroySwapchainKHR(m_Device, oldSwapChain, nullptr);
+
+	if (!CreateImageViews())
+	{
+		return false;
+	}
+
+	// Render finished semaphores are indexed by swap chain image
+	if (m_SwapChainImages.size() != oldImageCount)
+	{
+		for (VkSemaphore semaphore : m_RenderFinishedSemaphores)
+		{
+			vkDestroySemaphore(m_Device, semaphore, nullptr);
+		}
+
+		if (!CreateRenderFinishedSemaphores())
+		{
+			return false;
+		}
+	}
+
+	TPS_CORE_INFO("Swap chain recreated at {0}x{1}", m_SwapChainExtent.width, m_SwapChainExtent.height);
+
+	return true;
+}
+
+void Tempus::Renderer::DestroySwapChainResources()
+{
+	for (auto imageView : m_SwapChainImageViews) 
+	{
+		vkDestroyImageView(m_Device, imageView, nullptr);
+	}
+
+	m_SwapChainImageViews.clear();
+}
+
+bool Tempus::Renderer::CreateOffscreenTargets()
+{
+	// RGBA8 is supported as a colour attachment everywhere and maps straight onto the PPM capture
+	m_SwapChainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	m_SwapChainExtent = { m_HeadlessConfig.Width, m_HeadlessConfig.Height };
+
+	m_SwapChainImages.resize(m_FramesInFlight, VK_NULL_HANDLE);
+	m_OffscreenAllocations.resize(m_FramesInFlight);
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = m_SwapChainImageFormat;
+	imageInfo.extent = { m_SwapChainExtent.width, m_SwapChainExtent.height, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		if (!m_Allocator.CreateImage(imageInfo, MemoryUsage::GPUOnly, m_SwapChainImages[i], m_OffscreenAllocations[i], true))
+		{
+			TPS_CORE_CRITICAL("Failed to create offscreen target!");
+			return false;
+		}
+	}
+
+	TPS_CORE_INFO("Rendering headless into {0} offscreen targets at {1}x{2}", m_FramesInFlight, m_SwapChainExtent.width, m_SwapChainExtent.height);
+
+	return true;
+}
+
+void Tempus::Renderer::DestroyOffscreenTargets()
+{
+	for (size_t i = 0; i < m_OffscreenAllocations.size(); i++)
+	{
+		if (m_SwapChainImages[i] != VK_NULL_HANDLE)
+		{
+			m_Allocator.DestroyImage(m_SwapChainImages[i], m_OffscreenAllocations[i]);
+		}
+	}
+
+	m_SwapChainImages.clear();
+	m_OffscreenAllocations.clear();
+
+	if (m_CaptureBuffer != VK_NULL_HANDLE)
+	{
+		m_Allocator.DestroyBuffer(m_CaptureBuffer, m_CaptureAllocation);
+		m_CaptureBuffer = VK_NULL_HANDLE;
+	}
+}
+
 bool Tempus::Renderer::CreateImageViews()
 {
 
@@ -459,234 +1097,120 @@ bool Tempus::Renderer::CreateImageViews()
 	return true;
 }
 
-bool Tempus::Renderer::CreateRenderPass()
-{
-	// Single colour attachment
-	VkAttachmentDescription colorAttachment{};
-	colorAttachment.format = m_SwapChainImageFormat;
-	// 1 sample because no multi sampling right now
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	// Currently not using stencil
-	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	// Final layout for presentation to swapchain
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	VkAttachmentReference colorAttachmentRef{};
-	colorAttachmentRef.attachment = 0;
-	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription subpass{};
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorAttachmentRef;
-
-	VkSubpassDependency dependency{};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	VkRenderPassCreateInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = 1;
-	renderPassInfo.pAttachments = &colorAttachment;
-	renderPassInfo.subpassCount = 1;
-	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
-
-	if (vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS) 
-	{
-		TPS_CORE_CRITICAL("Failed to create render pass!");
+bool Tempus::Renderer::CreatePipelineCache()
+{
+	std::vector<char> initialData;
+
+	if (FileUtils::FileExists(m_PipelineCachePath))
+	{
+		initialData = FileUtils::ReadFile(m_PipelineCachePath);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &deviceProperties);
+
+		// Drivers are meant to reject foreign caches themselves, but not all of them do so gracefully.
+		// A cache from another GPU or driver version is discarded rather than handed over
+		VkPipelineCacheHeaderVersionOne header{};
+		bool bValid = initialData.size() >= sizeof(header);
+
+		if (bValid)
+		{
+			std::memcpy(&header, initialData.data(), sizeof(header));
+
+			bValid = header.headerSize >= sizeof(header) &&
+				header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				header.vendorID == deviceProperties.vendorID &&
+				header.deviceID == deviceProperties.deviceID &&
+				std::memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+
+		if (!bValid)
+		{
+			TPS_CORE_WARN("Discarding pipeline cache {0}, it was created by a different device or driver", m_PipelineCachePath);
+			initialData.clear();
+		}
+	}
+
+	m_bPipelineCacheWarm = !initialData.empty();
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = initialData.size();
+	cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+	{
+		TPS_CORE_CRITICAL("Failed to create pipeline cache!");
 		return false;
 	}
 
+	TPS_CORE_INFO("Pipeline cache {0} ({1} bytes)", m_bPipelineCacheWarm ? "loaded" : "created empty", initialData.size());
+
 	return true;
 }
 
-bool Tempus::Renderer::CreateGraphicsPipeline()
+void Tempus::Renderer::SavePipelineCache()
 {
-
-	auto vertShaderCode = FileUtils::ReadFile("bin/shaders/vert.spv");
-	auto fragShaderCode = FileUtils::ReadFile("bin/shaders/frag.spv");
-
-	VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-	VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	vertShaderStageInfo.module = vertShaderModule;
-	vertShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-	fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	fragShaderStageInfo.module = fragShaderModule;
-	fragShaderStageInfo.pName = "main";
-
-	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	// Currently hard coding vertex data in shader so setting these to empty
-	vertexInputInfo.vertexBindingDescriptionCount = 0;
-	vertexInputInfo.pVertexBindingDescriptions = nullptr; // Optional
-	vertexInputInfo.vertexAttributeDescriptionCount = 0;
-	vertexInputInfo.pVertexAttributeDescriptions = nullptr; // Optional
-
-
-	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	// Indicates triangle from every 3 vertices without reuse
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-	// Dynamic states can be modified at drawtime without having to recreate the entire pipeline.
-	std::vector<VkDynamicState> dynamicStates =
-	{
-		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR
-	};
-
-	VkPipelineDynamicStateCreateInfo dynamicState{};
-	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-	dynamicState.pDynamicStates = dynamicStates.data();
-
-	VkPipelineViewportStateCreateInfo viewportState{};
-	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewportState.viewportCount = 1;
-	viewportState.scissorCount = 1;
-
-
-	VkPipelineRasterizationStateCreateInfo rasterizer{};
-	rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	// If this value is set to VK_TRUE, then fragments outside of near and far plane are clamped instead of discarded.
-	rasterizer.depthClampEnable = VK_FALSE;
-	// If this value is set to VK_TRUE then the rasterizers output is effectively disabled
-	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-	rasterizer.depthBiasEnable = VK_FALSE;
-	rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-	rasterizer.depthBiasClamp = 0.0f; // Optional
-	rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-	// Multi sampling disabled for now
-	VkPipelineMultisampleStateCreateInfo multisampling{};
-	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling.sampleShadingEnable = VK_FALSE;
-	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-	multisampling.minSampleShading = 1.0f; // Optional
-	multisampling.pSampleMask = nullptr; // Optional
-	multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-	multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
-	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD; // Optional
-	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE; // Optional
-	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO; // Optional
-	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD; // Optional
-
-	VkPipelineColorBlendStateCreateInfo colorBlending{};
-	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	colorBlending.logicOpEnable = VK_FALSE;
-	colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
-	colorBlending.blendConstants[0] = 0.0f; // Optional
-	colorBlending.blendConstants[1] = 0.0f; // Optional
-	colorBlending.blendConstants[2] = 0.0f; // Optional
-	colorBlending.blendConstants[3] = 0.0f; // Optional
-
-
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 0; // Optional
-	pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-	if (vkCreatePipelineLayout(m_Device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS) 
+	if (m_PipelineCache == VK_NULL_HANDLE)
 	{
-		TPS_CORE_CRITICAL("Failed to create pipeline layout!");
-		return false;
+		return;
 	}
 
-	// Pipeline creation
-	VkGraphicsPipelineCreateInfo pipelineInfo{};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipelineInfo.stageCount = 2;
-	pipelineInfo.pStages = shaderStages;
-	pipelineInfo.pVertexInputState = &vertexInputInfo;
-	pipelineInfo.pInputAssemblyState = &inputAssembly;
-	pipelineInfo.pViewportState = &viewportState;
-	pipelineInfo.pRasterizationState = &rasterizer;
-	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = nullptr; // Optional
-	pipelineInfo.pColorBlendState = &colorBlending;
-	pipelineInfo.pDynamicState = &dynamicState;
-	pipelineInfo.layout = m_PipelineLayout;
-	pipelineInfo.renderPass = m_RenderPass;
-	pipelineInfo.subpass = 0;
-	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-	pipelineInfo.basePipelineIndex = -1; // Optional
-
-	if (vkCreateGraphicsPipelines(m_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS) 
+	size_t dataSize = 0;
+	vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr);
+
+	std::vector<char> data(dataSize);
+
+	if (dataSize == 0 || vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS)
 	{
-		TPS_CORE_CRITICAL("Failed to create graphics pipeline!");
-		return false;
+		TPS_CORE_WARN("Failed to retrieve pipeline cache data!");
+		return;
 	}
 
-	vkDestroyShaderModule(m_Device, vertShaderModule, nullptr);
-	vkDestroyShaderModule(m_Device, fragShaderModule, nullptr);
-
-	return true;
+	if (FileUtils::WriteFileAtomic(m_PipelineCachePath, data.data(), dataSize))
+	{
+		TPS_CORE_INFO("Saved pipeline cache ({0} bytes)", dataSize);
+	}
 }
 
-bool Tempus::Renderer::CreateFrameBuffers()
+bool Tempus::Renderer::CreateGraphicsPipeline()
 {
-	m_SwapChainFramebuffers.resize(m_SwapChainImageViews.size());
+	if (!m_PipelineStates.Init(m_Device, m_PipelineCache, &m_Deletions, m_bDynamicBlend, &m_DescriptorLayouts))
+	{
+		return false;
+	}
 
-	for (size_t i = 0; i < m_SwapChainImageViews.size(); i++) 
+	m_MainProgram = m_PipelineStates.RegisterProgram("Main", MakeShaderCode(EmbeddedShaders::ShaderVert),
+		MakeShaderCode(EmbeddedShaders::ShaderFrag));
+
+	if (m_MainProgram == PipelineStateCache::INVALID_PROGRAM)
 	{
+		TPS_CORE_CRITICAL("Failed to create pipeline layout!");
+		return false;
+	}
 
-		VkImageView attachments[] = 
-		{
-			m_SwapChainImageViews[i]
-		};
+	m_MainUniformSet = m_Uniforms.GetDescriptorSet(m_PipelineStates.GetSetLayout(m_MainProgram, 0));
 
-		VkFramebufferCreateInfo framebufferInfo{};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = m_RenderPass;
-		framebufferInfo.attachmentCount = 1;
-		framebufferInfo.pAttachments = attachments;
-		framebufferInfo.width = m_SwapChainExtent.width;
-		framebufferInfo.height = m_SwapChainExtent.height;
-		framebufferInfo.layers = 1;
+	if (m_MainUniformSet == VK_NULL_HANDLE)
+	{
+		TPS_CORE_CRITICAL("Failed to create the main uniform descriptor set!");
+		return false;
+	}
 
-		if (vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_SwapChainFramebuffers[i]) != VK_SUCCESS) 
-		{
-			TPS_CORE_CRITICAL("Failed to create framebuffer!");
-			return false;
-		}
+	// Vertices are hard coded in the shader, wound clockwise
+	m_MainPipelineKey.Program = m_MainProgram;
+	m_MainPipelineKey.ColorFormat = m_SwapChainImageFormat;
+	m_MainPipelineKey.CullMode = VK_CULL_MODE_BACK_BIT;
+	m_MainPipelineKey.FrontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	// Created now rather than on the first frame
+	if (m_PipelineStates.GetPipeline(m_MainPipelineKey) == VK_NULL_HANDLE)
+	{
+		TPS_CORE_CRITICAL("Failed to create graphics pipeline!");
+		return false;
 	}
 
-    return true;
+	return true;
 }
 
 bool Tempus::Renderer::CreateCommandPool()
@@ -707,20 +1231,29 @@ bool Tempus::Renderer::CreateCommandPool()
 	return true;
 }
 
-bool Tempus::Renderer::CreateCommandBuffer()
+bool Tempus::Renderer::CreateCommandBuffers()
 {
+	m_Frames.resize(m_FramesInFlight);
+
+	std::vector<VkCommandBuffer> commandBuffers(m_FramesInFlight);
+
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool = m_CommandPool;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = 1;
+	allocInfo.commandBufferCount = m_FramesInFlight;
 
-	if (vkAllocateCommandBuffers(m_Device, &allocInfo, &m_CommandBuffer) != VK_SUCCESS) 
+	if (vkAllocateCommandBuffers(m_Device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) 
 	{
 		TPS_CORE_CRITICAL("Failed to allocate command buffers!");
 		return false;
 	}
 
+	for (uint32_t i = 0; i < m_FramesInFlight; i++)
+	{
+		m_Frames[i].CommandBuffer = commandBuffers[i];
+	}
+
 	return true;
 }
 
@@ -728,19 +1261,59 @@ bool Tempus::Renderer::CreateSyncObjects()
 {
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	// Setting fence to be signalled on creation for first call of DrawFrame()
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphore) != VK_SUCCESS ||
-		vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphore) != VK_SUCCESS ||
-		vkCreateFence(m_Device, &fenceInfo, nullptr, &m_InFlightFence) != VK_SUCCESS) 
+	for (FrameData& frame : m_Frames)
+	{
+		if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &frame.ImageAvailableSemaphore) != VK_SUCCESS) 
+		{
+			TPS_CORE_CRITICAL("Failed to create semaphores!");
+			return false;
+		}
+	}
+
+	// Starts at 0, which every frame slot's FrameValue also starts at, so the first wait of each slot returns at once
+	VkSemaphoreTypeCreateInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	timelineInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo timelineSemaphoreInfo{};
+	timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	timelineSemaphoreInfo.pNext = &timelineInfo;
+
+	if (vkCreateSemaphore(m_Device, &timelineSemaphoreInfo, nullptr, &m_FrameTimeline) != VK_SUCCESS)
+	{
+		TPS_CORE_CRITICAL("Failed to create frame timeline semaphore!");
+		return false;
+	}
+
+	if (!CreateRenderFinishedSemaphores())
 	{
-		TPS_CORE_CRITICAL("Failed to create semaphores!");
 		return false;
 	}
 
+	TPS_CORE_INFO("Rendering with {0} frames in flight", m_FramesInFlight);
+
+	return true;
+}
+
+bool Tempus::Renderer::CreateRenderFinishedSemaphores()
+{
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	// Render finished semaphores are waited on by presentation, so they follow the swap chain images
+	m_RenderFinishedSemaphores.resize(m_SwapChainImages.size());
+
+	for (VkSemaphore& semaphore : m_RenderFinishedSemaphores)
+	{
+		if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) 
+		{
+			TPS_CORE_CRITICAL("Failed to create semaphores!");
+			return false;
+		}
+	}
+
 	return true;
 }
 
@@ -758,39 +1331,31 @@ bool Tempus::Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32
 		return false;
 	}
 
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = m_RenderPass;
-	renderPassInfo.framebuffer = m_SwapChainFramebuffers[imageIndex];
-	renderPassInfo.renderArea.offset = { 0, 0 };
-	renderPassInfo.renderArea.extent = m_SwapChainExtent;
-	VkClearValue clearColor = { {{m_ClearColour[0],m_ClearColour[1], m_ClearColour[2], m_ClearColour[3]}}};
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
+	// Resolves the timings this frame slot recorded last time round, which DrawFrame() has already waited for
+	m_Profiler.BeginFrame(commandBuffer, m_CurrentFrame);
+	uint32_t frameScope = m_Profiler.BeginScope(commandBuffer, "Frame");
 
-	// Begin render pass
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	// Bind to pipeline
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline);
+	// Take ownership of anything the transfer queue uploaded this frame
+	m_Uploads.RecordAcquireBarriers(commandBuffer);
 
-	// Viewport and scissor are dynamic values in our pipeline and therefore must be set in command buffer before issuing draw command
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(m_SwapChainExtent.width);
-	viewport.height = static_cast<float>(m_SwapChainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	m_bRecordingFailed = false;
+	BuildRenderGraph(imageIndex);
 
-	VkRect2D scissor{};
-	scissor.offset = { 0, 0 };
-	scissor.extent = m_SwapChainExtent;
-	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	if (!m_RenderGraph.Compile())
+	{
+		TPS_CORE_CRITICAL("Failed to compile render graph!");
+		return false;
+	}
 
-	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	m_RenderGraph.Execute(commandBuffer);
+
+	if (m_bRecordingFailed)
+	{
+		TPS_CORE_CRITICAL("Failed to record secondary command buffers!");
+		return false;
+	}
 
-	vkCmdEndRenderPass(commandBuffer);
+	m_Profiler.EndScope(commandBuffer, frameScope);
 
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) 
 	{
@@ -801,22 +1366,232 @@ bool Tempus::Renderer::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32
 	return true;
 }
 
-VkShaderModule Tempus::Renderer::CreateShaderModule(const std::vector<char>& code)
+void Tempus::Renderer::BuildRenderGraph(uint32_t imageIndex)
 {
-	VkShaderModuleCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+	m_RenderGraph.Reset();
 
-	VkShaderModule shaderModule;
-	
-	if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) 
+	// The acquire semaphore is waited on at colour attachment output, so the first transition has to wait there too.
+	// Offscreen targets are only guarded by the frame slot wait and end up ready to be copied from
+	RGHandle backbuffer = m_RenderGraph.ImportTexture("Backbuffer", m_SwapChainImages[imageIndex], m_SwapChainImageViews[imageIndex],
+		m_SwapChainImageFormat, m_SwapChainExtent, VK_IMAGE_LAYOUT_UNDEFINED,
+		m_bHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+		m_bHeadless ? VK_PIPELINE_STAGE_2_NONE : VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+	VkClearColorValue clearColour = { { m_ClearColour[0], m_ClearColour[1], m_ClearColour[2], m_ClearColour[3] } };
+
+	// The swap chain format can change when it is recreated, the cache builds a matching pipeline on demand
+	m_MainPipelineKey.ColorFormat = m_SwapChainImageFormat;
+
+	// Keeps the triangle's shape whatever the aspect ratio of the window
+	float aspectRatio = static_cast<float>(m_SwapChainExtent.width) / static_cast<float>(m_SwapChainExtent.height);
+
+	FrameConstants frameConstants{};
+	frameConstants.Scale[0] = aspectRatio > 1.0f ? 1.0f / aspectRatio : 1.0f;
+	frameConstants.Scale[1] = aspectRatio > 1.0f ? 1.0f : aspectRatio;
+	m_FrameConstantsOffset = m_Uniforms.Push(frameConstants);
+
+	m_FrameDraws.clear();
+	// Triangle of the default pipeline, followed by everything submitted since the last frame
+	m_FrameDraws.push_back({ 3, 1, 0, 0 });
+	m_FrameDraws.insert(m_FrameDraws.end(), m_PendingDraws.begin(), m_PendingDraws.end());
+	m_PendingDraws.clear();
+
+	bool bParallel = m_FrameDraws.size() >= PARALLEL_RECORD_THRESHOLD && m_Recorder.GetThreadCount() > 1;
+
+	m_RenderGraph.AddPass("Main", [this](VkCommandBuffer commandBuffer) { RecordMainPass(commandBuffer); })
+		.AddColorAttachment(backbuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColour)
+		.SetSecondaryCommandBuffers(bParallel);
+
+	m_Scene.AddPasses(m_RenderGraph, backbuffer, m_SwapChainImageFormat, m_SwapChainExtent);
+	m_Batches.AddPasses(m_RenderGraph, backbuffer, m_SwapChainImageFormat, m_SwapChainExtent);
+
+	if (m_bHeadless && !m_CapturePath.empty())
+	{
+		AddCapturePass(backbuffer);
+	}
+}
+
+void Tempus::Renderer::AddCapturePass(RGHandle backbuffer)
+{
+	VkDeviceSize size = static_cast<VkDeviceSize>(m_SwapChainExtent.width) * m_SwapChainExtent.height * 4;
+
+	if (m_CaptureBuffer == VK_NULL_HANDLE)
+	{
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// Dedicated so the whole memory object can be invalidated without respecting nonCoherentAtomSize
+		if (!m_Allocator.CreateBuffer(bufferInfo, MemoryUsage::GPUToCPU, m_CaptureBuffer, m_CaptureAllocation, true))
+		{
+			TPS_CORE_ERROR("Failed to create capture buffer!");
+			m_CapturePath.clear();
+			return;
+		}
+	}
+
+	RGHandle captureBuffer = m_RenderGraph.ImportBuffer("Capture", m_CaptureBuffer, size, true);
+
+	VkImage image = m_SwapChainImages[m_CurrentFrame];
+	VkBuffer buffer = m_CaptureBuffer;
+	VkExtent2D extent = m_SwapChainExtent;
+
+	m_RenderGraph.AddPass("Capture", [image, buffer, extent, size](VkCommandBuffer commandBuffer)
+		{
+			VkBufferImageCopy region{};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { extent.width, extent.height, 1 };
+
+			vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+			// The graph only orders device work, the host read after the frame wait needs its own barrier
+			VkBufferMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = buffer;
+			barrier.size = size;
+
+			VkDependencyInfo dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dependencyInfo.bufferMemoryBarrierCount = 1;
+			dependencyInfo.pBufferMemoryBarriers = &barrier;
+
+			vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+		})
+		.Read(backbuffer, RGUsage::TransferSrc)
+		.Write(captureBuffer, RGUsage::TransferDst)
+		.SetSideEffect();
+
+	m_CaptureInFlight = m_CapturePath;
+	m_CapturePath.clear();
+}
+
+bool Tempus::Renderer::WriteCapture()
+{
+	std::string path = m_CaptureInFlight;
+	m_CaptureInFlight.clear();
+
+	VkMappedMemoryRange range{};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = m_CaptureAllocation.Memory;
+	range.offset = 0;
+	range.size = VK_WHOLE_SIZE;
+	vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+
+	uint32_t width = m_SwapChainExtent.width;
+	uint32_t height = m_SwapChainExtent.height;
+	const uint8_t* pixels = static_cast<const uint8_t*>(m_CaptureAllocation.MappedData);
+
+	std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+
+	std::vector<uint8_t> data(header.begin(), header.end());
+	data.reserve(header.size() + static_cast<size_t>(width) * height * 3);
+
+	// Offscreen targets are RGBA8, PPM has no alpha
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+	{
+		data.push_back(pixels[i * 4 + 0]);
+		data.push_back(pixels[i * 4 + 1]);
+		data.push_back(pixels[i * 4 + 2]);
+	}
+
+	if (!FileUtils::WriteFileAtomic(path, data.data(), data.size()))
+	{
+		TPS_CORE_ERROR("Failed to write frame capture to {0}", path);
+		return false;
+	}
+
+	TPS_CORE_INFO("Frame captured to {0}", path);
+
+	return true;
+}
+
+void Tempus::Renderer::RecordMainPass(VkCommandBuffer commandBuffer)
+{
+	uint32_t drawCount = static_cast<uint32_t>(m_FrameDraws.size());
+
+	if (drawCount < PARALLEL_RECORD_THRESHOLD || m_Recorder.GetThreadCount() == 1)
+	{
+		RecordDraws(commandBuffer, m_FrameDraws.data(), drawCount);
+		return;
+	}
+
+	VkCommandBufferInheritanceRenderingInfo renderingInheritance = GetMainPassInheritance();
+
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.pNext = &renderingInheritance;
+
+	m_SecondaryCommandBuffers.clear();
+	bool bRecorded = m_Recorder.Record(inheritance, drawCount, [this](VkCommandBuffer secondary, uint32_t, uint32_t first, uint32_t count)
+		{
+			RecordDraws(secondary, m_FrameDraws.data() + first, count);
+		}, m_SecondaryCommandBuffers);
+
+	// Executing what did record would drop a slice of the draws. The pass renders secondary contents, so the draws
+	// can't be recorded inline instead, and the frame is failed in RecordCommandBuffer()
+	if (!bRecorded)
+	{
+		m_bRecordingFailed = true;
+		return;
+	}
+
+	if (!m_SecondaryCommandBuffers.empty())
+	{
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(m_SecondaryCommandBuffers.size()), m_SecondaryCommandBuffers.data());
+	}
+}
+
+VkCommandBufferInheritanceRenderingInfo Tempus::Renderer::GetMainPassInheritance() const
+{
+	VkCommandBufferInheritanceRenderingInfo renderingInheritance{};
+	renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+	renderingInheritance.colorAttachmentCount = 1;
+	renderingInheritance.pColorAttachmentFormats = &m_SwapChainImageFormat;
+	renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	return renderingInheritance;
+}
+
+void Tempus::Renderer::RecordDraws(VkCommandBuffer commandBuffer, const DrawCommand* draws, uint32_t count)
+{
+	if (m_FrameConstantsOffset == UniformAllocator::INVALID_OFFSET)
 	{
-		TPS_CORE_CRITICAL("Failed to create shader module!");
-		throw std::runtime_error("Failed to create shader module!");
+		return;
 	}
 
-	return shaderModule;
+	// Secondary command buffers inherit no state, so every range binds its own
+	m_PipelineStates.Bind(commandBuffer, m_MainPipelineKey);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineStates.GetLayout(m_MainProgram), 0, 1,
+		&m_MainUniformSet, 1, &m_FrameConstantsOffset);
+
+	// Viewport and scissor are dynamic values in our pipeline and therefore must be set in command buffer before issuing draw command
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(m_SwapChainExtent.width);
+	viewport.height = static_cast<float>(m_SwapChainExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = m_SwapChainExtent;
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		vkCmdDraw(commandBuffer, draws[i].VertexCount, draws[i].InstanceCount, draws[i].FirstVertex, draws[i].FirstInstance);
+	}
 }
 
 bool Tempus::Renderer::CreateSurface(Tempus::Window* window)
@@ -843,31 +1618,45 @@ Tempus::Renderer::QueueFamilyIndices Tempus::Renderer::FindQueueFamilies(VkPhysi
 	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-	int i = 0;
-	for (const auto& queueFamily : queueFamilies)
+	for (uint32_t i = 0; i < queueFamilyCount; i++)
 	{
+		const VkQueueFamilyProperties& queueFamily = queueFamilies[i];
+
 		// Checking if queue family supports graphics queue
-		if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		if (!indices.graphicsFamily.has_value() && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT))
 		{
 			indices.graphicsFamily = i;
 		}
 
 		// Check if queue family supports present queue
-		// These capabilities may reside in the same queue family
+		// These capabilities may reside in the same queue family, which is preferred.
+		// Without a surface nothing is presented, the graphics queue stands in for the present queue
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_VkSurface, &presentSupport);
+		if (m_bHeadless)
+		{
+			presentSupport = indices.graphicsFamily == i;
+		}
+		else
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_VkSurface, &presentSupport);
+		}
 
-		if (presentSupport) 
+		if (presentSupport && (!indices.presentFamily.has_value() || indices.graphicsFamily == i)) 
 		{
 			indices.presentFamily = i;
 		}
 
-		if (indices.IsComplete()) 
+		// A transfer family without graphics or compute usually maps to the dedicated copy engines
+		if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
 		{
-			break;
+			indices.transferFamily = i;
 		}
+	}
 
-		i++;
+	// Graphics queues implicitly support transfer
+	if (!indices.transferFamily.has_value())
+	{
+		indices.transferFamily = indices.graphicsFamily;
 	}
 
 	return indices;
@@ -943,15 +1732,12 @@ VkExtent2D Tempus::Renderer::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR &ca
 	} 
 	else 
 	{
-		int width, height;
-		// The drawable size (pixels) may differ from the window size (screen coordinates) on high DPI displays (Mac Retina)
-		// Vulkan wants exact pixel size, not screen coordinates
-		SDL_Vulkan_GetDrawableSize(m_Window->GetNativeWindow(), &width, &height);
-
+		// Vulkan wants exact pixel size, not screen coordinates. The size comes from the frame packet, SDL window calls
+		// belong to the game thread
 		VkExtent2D actualExtent = 
 		{
-			static_cast<uint32_t>(width),
-			static_cast<uint32_t>(height)
+			m_DrawableWidth,
+			m_DrawableHeight
 		};
 
 		actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
@@ -970,14 +1756,18 @@ bool Tempus::Renderer::IsDeviceSuitable(VkPhysicalDevice device)
 
 	// Check if devices swap chain has adequate support
 	bool swapChainAdequate = false;
-	// Only query if extension support exists
-	if (extensionsSupported) 
+	// Only query if extension support exists. Headless rendering has no swap chain to support
+	if (m_bHeadless)
+	{
+		swapChainAdequate = true;
+	}
+	else if (extensionsSupported) 
 	{
 		SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	return indices.IsComplete() && extensionsSupported && swapChainAdequate;
+	return indices.IsComplete() && extensionsSupported && swapChainAdequate && CheckDeviceFeatureSupport(device);
 
 }
 
@@ -1023,7 +1813,8 @@ bool Tempus::Renderer::CheckDeviceExtensionSupport(VkPhysicalDevice device)
 	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-	std::set<std::string> requiredExtensions(m_DeviceExtensions.begin(), m_DeviceExtensions.end());
+	std::vector<const char*> deviceExtensions = GetDeviceExtensions();
+	std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
 	for (const auto& extension : availableExtensions) 
 	{
@@ -1033,17 +1824,52 @@ bool Tempus::Renderer::CheckDeviceExtensionSupport(VkPhysicalDevice device)
 	return requiredExtensions.empty();
 }
 
+bool Tempus::Renderer::CheckDeviceFeatureSupport(VkPhysicalDevice device)
+{
+	// Vulkan 1.3 feature structs may only be chained on devices that support 1.3
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+	if (deviceProperties.apiVersion < VK_API_VERSION_1_3)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceVulkan13Features features13{};
+	features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	features12.pNext = &features13;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features12;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return features.features.multiDrawIndirect && features12.timelineSemaphore && features12.bufferDeviceAddress &&
+		features12.drawIndirectCount && features13.dynamicRendering && features13.synchronization2;
+}
+
 std::vector<const char*> Tempus::Renderer::GetRequiredExtensions()
 {
 	uint32_t extensionCount = 0;
 
-	// Get extension count
-	SDL_Vulkan_GetInstanceExtensions(nullptr, &extensionCount, nullptr);
+	// Surface extensions are only needed to present
+	if (!m_bHeadless)
+	{
+		// Get extension count
+		SDL_Vulkan_GetInstanceExtensions(nullptr, &extensionCount, nullptr);
+	}
 
 	std::vector<const char*> extensions(extensionCount);
 
-	// Get minimum required extensions
-	SDL_Vulkan_GetInstanceExtensions(nullptr, &extensionCount, extensions.data());
+	if (!m_bHeadless)
+	{
+		// Get minimum required extensions
+		SDL_Vulkan_GetInstanceExtensions(nullptr, &extensionCount, extensions.data());
+	}
 
 	if (m_bEnableValidationLayers) 
 	{
@@ -1054,6 +1880,59 @@ std::vector<const char*> Tempus::Renderer::GetRequiredExtensions()
 	return extensions;
 }
 
+bool Tempus::Renderer::CheckDynamicBlendSupport(VkPhysicalDevice device) const
+{
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+	bool bExtensionSupported = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return std::strcmp(extension.extensionName, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME) == 0;
+	});
+
+	if (!bExtensionSupported)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3{};
+	dynamicState3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dynamicState3;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return dynamicState3.extendedDynamicState3ColorBlendEnable && dynamicState3.extendedDynamicState3ColorBlendEquation;
+}
+
+bool Tempus::Renderer::CheckBindlessSupport(VkPhysicalDevice device) const
+{
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features12;
+
+	vkGetPhysicalDeviceFeatures2(device, &features);
+
+	return features12.runtimeDescriptorArray && features12.descriptorBindingPartiallyBound &&
+		features12.descriptorBindingSampledImageUpdateAfterBind && features12.descriptorBindingStorageBufferUpdateAfterBind &&
+		features12.descriptorBindingUpdateUnusedWhilePending && features12.shaderSampledImageArrayNonUniformIndexing &&
+		features12.shaderStorageBufferArrayNonUniformIndexing;
+}
+
+std::vector<const char*> Tempus::Renderer::GetDeviceExtensions() const
+{
+	// The swap chain extension is the only required one and headless rendering doesn't need it
+	return m_bHeadless ? std::vector<const char*>() : m_DeviceExtensions;
+}
+
 void Tempus::Renderer::PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
 {
 	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
@@ -1145,12 +2024,19 @@ void Tempus::Renderer::LogDeviceInfo(VkPhysicalDevice device)
 	ss << '\t' << "Driver Version: " << deviceProperties.driverVersion << '\n';
 	ss << '\t' << "API Version: " << deviceProperties.apiVersion << '\n';
 	ss << '\t' << "Vendor ID: " << deviceProperties.vendorID << '\n';
+	ss << '\t' << "Timestamp Period: " << deviceProperties.limits.timestampPeriod << " ns" << '\n';
 
 	TPS_CORE_INFO(ss.str());
 }
 
 void Tempus::Renderer::Cleanup()
 {
+	// Packets still queued are dropped, the frame being rendered finishes first
+	if (m_RenderThread.joinable())
+	{
+		m_Packets.Close();
+		m_RenderThread.join();
+	}
 
 	// Wait for all semaphores to finish
 	vkDeviceWaitIdle(m_Device);
@@ -1160,28 +2046,58 @@ void Tempus::Renderer::Cleanup()
 		DestroyDebugUtilsMessengerEXT(m_VkInstance, m_DebugMessenger, nullptr);
 	}
 
+	m_Recorder.Shutdown();
 	vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
 
-	vkDestroySemaphore(m_Device, m_ImageAvailableSemaphore, nullptr);
-	vkDestroySemaphore(m_Device, m_RenderFinishedSemaphore, nullptr);
-	vkDestroyFence(m_Device, m_InFlightFence, nullptr);
+	for (FrameData& frame : m_Frames)
+	{
+		vkDestroySemaphore(m_Device, frame.ImageAvailableSemaphore, nullptr);
+	}
 
-	for (auto framebuffer : m_SwapChainFramebuffers) 
+	vkDestroySemaphore(m_Device, m_FrameTimeline, nullptr);
+
+	for (VkSemaphore semaphore : m_RenderFinishedSemaphores)
 	{
-        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
-    }
+		vkDestroySemaphore(m_Device, semaphore, nullptr);
+	}
 
-	for (auto imageView : m_SwapChainImageViews) 
+	m_RenderGraph.Shutdown();
+	// Joins the watcher before the pipelines it rebuilds go away
+	m_PipelineReloader.Shutdown();
+	// After everything that queues into it and before the pipeline states and bindless handles it recycles
+	m_Deletions.Shutdown();
+	m_Scene.Shutdown();
+	m_Batches.Shutdown();
+	m_Uniforms.Shutdown();
+	m_FrameDescriptors.Shutdown();
+	m_Profiler.Shutdown();
+
+	DestroySwapChainResources();
+	DestroyOffscreenTargets();
+
+	SavePipelineCache();
+	vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+
+	m_PipelineStates.Shutdown();
+	m_Bindless.Shutdown();
+	// After every pipeline layout referencing the set layouts is gone
+	m_DescriptorLayouts.Shutdown();
+	if (m_SwapChain != VK_NULL_HANDLE)
 	{
-		vkDestroyImageView(m_Device, imageView, nullptr);
+		vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
 	}
 
-	vkDestroyPipeline(m_Device, m_GraphicsPipeline, nullptr);
-	vkDestroyPipelineLayout(m_Device, m_PipelineLayout, nullptr);
-	vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
-	vkDestroySwapchainKHR(m_Device, m_SwapChain, nullptr);
+	m_Uploads.Shutdown();
+
+	m_Allocator.LogStats();
+	m_Allocator.Shutdown();
+
 	vkDestroyDevice(m_Device, nullptr);
-	vkDestroySurfaceKHR(m_VkInstance, m_VkSurface, nullptr);
+	if (m_VkSurface != VK_NULL_HANDLE)
+	{
+		vkDestroySurfaceKHR(m_VkInstance, m_VkSurface, nullptr);
+	}
+
 	vkDestroyInstance(m_VkInstance, nullptr);
 
 }
@@ -8,7 +8,28 @@
 #include <vector>
 #include "vulkan/vulkan.h"
 #include <optional>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <exception>
 #include "Log.h"
+#include "Renderer/GPUAllocator.h"
+#include "Renderer/UploadManager.h"
+#include "Renderer/RenderGraph.h"
+#include "Renderer/CommandRecorder.h"
+#include "Renderer/GPUScene.h"
+#include "Renderer/GPUProfiler.h"
+#include "Renderer/SubmitBatch.h"
+#include "Renderer/PipelineReloader.h"
+#include "Renderer/PipelineStateCache.h"
+#include "Renderer/BatchRenderer.h"
+#include "Renderer/UniformAllocator.h"
+#include "Renderer/DescriptorAllocator.h"
+#include "Renderer/DescriptorLayoutCache.h"
+#include "Renderer/BindlessDescriptors.h"
+#include "Renderer/DeletionQueue.h"
+#include "Renderer/FramePacket.h"
 
 #ifdef TPS_PLATFORM_MAC
 #include "vulkan/vulkan_macos.h"
@@ -18,32 +39,122 @@
 
 namespace Tempus {
 
+	// Rendering into offscreen images without a window, surface or swap chain. Runs on any device with the required
+	// features, including software implementations such as lavapipe (select it with VK_DRIVER_FILES)
+	struct HeadlessConfig
+	{
+		uint32_t Width = 1280;
+		uint32_t Height = 720;
+		// Frames rendered by Application::Run before it quits
+		uint32_t FrameCount = 1000;
+		// The last frame is written here as a binary PPM when not empty
+		std::string CapturePath;
+	};
+
 	class TEMPUS_API Renderer {
 
 	public:
 
+		// Upper bound for the frames in flight ring. The active count is chosen with SetFramesInFlight()
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
 		Renderer();
 		~Renderer();
 
+		// Renders the frame packet written since the last call. With the render thread the packet is handed over instead,
+		// and this only blocks while the render thread is still on the packet before it
 		void Update();
 
 		bool Init(class Window* window);
 
 		int RenderClear();
 		void RenderPresent();
+		// Clear colour of the next frame and the ones after it
 		void SetRenderDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+		// Batch renderer camera of the next frame and the ones after it. Column major, clip space with Vulkan's [0, 1] depth range
+		void SetViewProjection(const float viewProjection[16]);
+
+		// Flags the swap chain for recreation at the end of the current frame
+		void OnWindowResized() { m_bFramebufferResized = true; }
+
+		// Must be called before Init(). Clamped to [1, MAX_FRAMES_IN_FLIGHT]
+		void SetFramesInFlight(uint32_t count);
+		uint32_t GetFramesInFlight() const { return m_FramesInFlight; }
+
+		// Must be called before Init(). Includes the render thread, 0 uses every hardware thread
+		void SetRecordingThreadCount(uint32_t count);
+
+		// Must be called before Init(). Frames are recorded and submitted on a thread of their own, one frame behind the
+		// game thread. Packet writes (SetRenderDrawColor(), SetViewProjection(), Submit() and RequestCapture()) stay safe
+		// from the game thread. So do the thread safe subsystems below, the rest need FlushRenderThread() first, which
+		// debug builds check. An exception thrown while rendering is rethrown on the game thread by the next Update() or
+		// FlushRenderThread()
+		void SetRenderThread(bool bEnabled);
+		bool HasRenderThread() const { return m_bRenderThread; }
+		// Blocks until the render thread has rendered every packet handed to it and is waiting for the next
+		void FlushRenderThread();
+
+		// Must be called before Init(), which then accepts a null window
+		void SetHeadless(const HeadlessConfig& config);
+		bool IsHeadless() const { return m_bHeadless; }
+		const HeadlessConfig& GetHeadlessConfig() const { return m_HeadlessConfig; }
+
+		// Headless only. The next frame is read back and written to path as a binary PPM once the GPU has finished it
+		void RequestCapture(const std::string& path) { m_GamePacket->CapturePath = path; }
+
+		// Queues a draw for the next frame
+		void Submit(const DrawCommand& draw) { m_GamePacket->Draws.push_back(draw); }
+		// Queues a batch renderer instance for the next frame
+		void Submit(uint32_t mesh, uint32_t material, const BatchTransform& transform) { m_GamePacket->Instances.push_back({ mesh, material, transform }); }
+
+		// Records drawCount draws with 1 to N threads and logs the recording time of each thread count
+		void RunRecordingBenchmark(uint32_t drawCount);
+
+		// Every frame signals the frame timeline with the next value, starting at 1. A frame's resources are free to
+		// reuse once the completed value has reached its frame value
+		uint64_t GetSubmittedFrameValue() const { return m_FrameValue; }
+		uint64_t GetCompletedFrameValue() const;
+		void WaitForFrame(uint64_t frameValue) const;
+
+		// Submissions queued here go out together with the next frame's rendering. Work that has to finish before
+		// rendering starts signals a timeline semaphore that the graphics submission waits on. Needs FlushRenderThread()
+		SubmitBatch& GetSubmitBatch() { CheckRenderThreadIdle(); return m_SubmitBatch; }
+
+		// Average CPU frame time in milliseconds over the last completed sample window
+		double GetAverageFrameTime() const { return m_AverageFrameTime.load(std::memory_order_relaxed); }
+
+		// Thread safe, usable from the game thread while the render thread runs
+		GPUAllocator& GetAllocator() { return m_Allocator; }
+		UploadManager& GetUploadManager() { return m_Uploads; }
+		// Destroys resources released at runtime once the frames using them have completed
+		DeletionQueue& GetDeletionQueue() { return m_Deletions; }
+		DescriptorLayoutCache& GetDescriptorLayouts() { return m_DescriptorLayouts; }
+		// Global texture, sampler and storage buffer handles. Check IsSupported(), descriptor indexing is optional
+		BindlessDescriptors& GetBindless() { return m_Bindless; }
+		PipelineStateCache& GetPipelineStates() { return m_PipelineStates; }
+
+		// Owned by the render thread, call FlushRenderThread() before using these from the game thread
+		// Per-frame uniform data, rewound each time a frame slot is reused
+		UniformAllocator& GetUniforms() { CheckRenderThreadIdle(); return m_Uniforms; }
+		// Descriptor sets that only live for the frame being recorded
+		FrameDescriptorAllocator& GetFrameDescriptors() { CheckRenderThreadIdle(); return m_FrameDescriptors; }
+		GPUScene& GetScene() { CheckRenderThreadIdle(); return m_Scene; }
+		BatchRenderer& GetBatches() { CheckRenderThreadIdle(); return m_Batches; }
+		// Per pass GPU timings, plus a "Frame" scope around the whole frame
+		const GPUProfiler& GetProfiler() const { CheckRenderThreadIdle(); return m_Profiler; }
 
 	private:
 
 		float m_ClearColour[4] = {0.25f, 0.5f, 0.1f, 0.0f};
 
 		// Struct for potential queue families
-		// Currently only searching for graphics queue family but will add more later
 		struct QueueFamilyIndices
 		{
 			// Optional value to represent if queue family exists
 			std::optional<uint32_t> graphicsFamily;
 			std::optional<uint32_t> presentFamily;
+			// Transfer only family when the device has one, otherwise the graphics family
+			std::optional<uint32_t> transferFamily;
 
 			bool IsComplete() 
 			{
@@ -59,6 +170,30 @@ namespace Tempus {
 			std::vector<VkPresentModeKHR> presentModes;
 		};
 
+		// Matches FrameConstants of shader.vert
+		struct FrameConstants
+		{
+			float Scale[2];
+			float Offset[2];
+		};
+
+		// Resources owned by a single frame in flight. The CPU records into one while the GPU executes the others
+		struct FrameData
+		{
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkSemaphore ImageAvailableSemaphore = VK_NULL_HANDLE;
+			// Frame timeline value of the slot's last submission
+			uint64_t FrameValue = 0;
+		};
+
+		void RenderPacket(const FramePacket& packet);
+		// Game thread only, SDL window calls are main thread only on macOS
+		void QueryDrawableSize(FramePacket& packet) const;
+		void RenderThreadLoop();
+		// Game thread. Throws what the render thread caught, once
+		void RethrowRenderThreadError();
+		// Debug builds log an error when the game thread reaches a render thread subsystem while frames are in flight
+		void CheckRenderThreadIdle() const;
 		void DrawFrame();
 
 		bool CreateVulkanInstance();
@@ -66,23 +201,37 @@ namespace Tempus {
 		bool CreateSurface(class Window* window);
 		bool PickPhysicalDevice();
 		bool CreateLogicalDevice();
-		bool CreateSwapChain();
+		bool CreateSwapChain(VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
+		bool CreateOffscreenTargets();
+		void DestroyOffscreenTargets();
+		bool RecreateSwapChain();
+		void DestroySwapChainResources();
 		bool CreateImageViews();
-		bool CreateRenderPass();
+		bool CreatePipelineCache();
+		void SavePipelineCache();
 		bool CreateGraphicsPipeline();
-		bool CreateFrameBuffers();
 		bool CreateCommandPool();
-		bool CreateCommandBuffer();
+		bool CreateCommandBuffers();
 		bool CreateSyncObjects();
+		bool CreateRenderFinishedSemaphores();
 
 		bool RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void BuildRenderGraph(uint32_t imageIndex);
+		void AddCapturePass(RGHandle backbuffer);
+		bool WriteCapture();
+		void RecordMainPass(VkCommandBuffer commandBuffer);
+		void RecordDraws(VkCommandBuffer commandBuffer, const DrawCommand* draws, uint32_t count);
+		VkCommandBufferInheritanceRenderingInfo GetMainPassInheritance() const;
 
-		VkShaderModule CreateShaderModule(const std::vector<char>& code);
 		QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device);
 		bool IsDeviceSuitable(VkPhysicalDevice device);
 		bool CheckValidationLayerSupport();
 		bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+		bool CheckDeviceFeatureSupport(VkPhysicalDevice device);
 		std::vector<const char*> GetRequiredExtensions();
+		std::vector<const char*> GetDeviceExtensions() const;
+		bool CheckDynamicBlendSupport(VkPhysicalDevice device) const;
+		bool CheckBindlessSupport(VkPhysicalDevice device) const;
 		void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 
 		// Swap chain support checks
@@ -93,6 +242,7 @@ namespace Tempus {
 
 		void LogExtensionsAndLayers();
 		void LogDeviceInfo(VkPhysicalDevice device);
+		void UpdateFrameStats();
 
 		void Cleanup();
 
@@ -105,26 +255,100 @@ namespace Tempus {
 		VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
 		VkDevice m_Device = VK_NULL_HANDLE;
 
+		GPUAllocator m_Allocator;
+		DeletionQueue m_Deletions;
+		UploadManager m_Uploads;
+		UniformAllocator m_Uniforms;
+		DescriptorLayoutCache m_DescriptorLayouts;
+		FrameDescriptorAllocator m_FrameDescriptors;
+		BindlessDescriptors m_Bindless;
+		RenderGraph m_RenderGraph;
+		GPUScene m_Scene;
+		BatchRenderer m_Batches;
+		GPUProfiler m_Profiler;
+
 		VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
 		std::vector<VkImage> m_SwapChainImages;
 		std::vector<VkImageView> m_SwapChainImageViews;
 		VkFormat m_SwapChainImageFormat;
 		VkExtent2D m_SwapChainExtent;
-
-		VkRenderPass m_RenderPass;
-		VkPipelineLayout m_PipelineLayout;
-		VkPipeline m_GraphicsPipeline;
-		std::vector<VkFramebuffer> m_SwapChainFramebuffers;
+		// Set from the game thread by OnWindowResized()
+		std::atomic<bool> m_bFramebufferResized = false;
+
+		// Headless mode renders into one offscreen image per frame in flight, standing in for the swap chain images
+		bool m_bHeadless = false;
+		HeadlessConfig m_HeadlessConfig;
+		std::vector<GPUAllocation> m_OffscreenAllocations;
+
+		// Pending frame capture, read back through a host visible buffer
+		std::string m_CapturePath;
+		std::string m_CaptureInFlight;
+		VkBuffer m_CaptureBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_CaptureAllocation;
+
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+		PipelineStateCache m_PipelineStates;
+		uint32_t m_MainProgram = PipelineStateCache::INVALID_PROGRAM;
+		PipelineKey m_MainPipelineKey;
+		VkDescriptorSet m_MainUniformSet = VK_NULL_HANDLE;
+		// Dynamic offset of this frame's FrameConstants
+		uint32_t m_FrameConstantsOffset = UniformAllocator::INVALID_OFFSET;
+		// VK_EXT_extended_dynamic_state3 blending is available and enabled
+		bool m_bDynamicBlend = false;
+		// The descriptor indexing features BindlessDescriptors needs are available and enabled
+		bool m_bBindless = false;
+		PipelineReloader m_PipelineReloader;
 
 		VkCommandPool m_CommandPool;
-		VkCommandBuffer m_CommandBuffer;
+
+		// Main pass draws are recorded in parallel once there are enough of them to outweigh waking the workers
+		static constexpr uint32_t PARALLEL_RECORD_THRESHOLD = 1024;
+		CommandRecorder m_Recorder;
+		uint32_t m_RecordingThreadCount = 0;
+		// Draws of the packet being rendered, moved into m_FrameDraws when the frame is recorded
+		std::vector<DrawCommand> m_PendingDraws;
+		std::vector<DrawCommand> m_FrameDraws;
+		std::vector<VkCommandBuffer> m_SecondaryCommandBuffers;
+		// Set by RecordMainPass() when a range of draws failed to record, the frame then isn't submitted
+		bool m_bRecordingFailed = false;
 
 		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
 		VkQueue m_PresentQueue = VK_NULL_HANDLE;
-
-		VkSemaphore m_ImageAvailableSemaphore;
-		VkSemaphore m_RenderFinishedSemaphore;
-		VkFence m_InFlightFence;
+		VkQueue m_TransferQueue = VK_NULL_HANDLE;
+
+		uint32_t m_FramesInFlight = 2;
+		uint32_t m_CurrentFrame = 0;
+		std::vector<FrameData> m_Frames;
+
+		VkSemaphore m_FrameTimeline = VK_NULL_HANDLE;
+		uint64_t m_FrameValue = 0;
+		SubmitBatch m_SubmitBatch;
+		// Indexed by swap chain image, since presentation of an image may outlive the frame that rendered it
+		std::vector<VkSemaphore> m_RenderFinishedSemaphores;
+
+		// Time to first frame, measured from the start of Init()
+		std::chrono::high_resolution_clock::time_point m_InitStartTime;
+		bool m_bFirstFramePresented = false;
+		bool m_bPipelineCacheWarm = false;
+
+		// CPU frame timing
+		static constexpr uint32_t FRAME_STATS_WINDOW = 1000;
+		std::chrono::high_resolution_clock::time_point m_LastFrameTime;
+		double m_FrameTimeAccumulator = 0.0;
+		uint32_t m_FrameTimeSamples = 0;
+		std::atomic<double> m_AverageFrameTime = 0.0;
+
+		// The game thread writes m_GamePacket. Without the render thread Update() renders it in place
+		FramePacketQueue m_Packets;
+		FramePacket* m_GamePacket = nullptr;
+		// Drawable size of the packet being rendered, in pixels
+		uint32_t m_DrawableWidth = 0;
+		uint32_t m_DrawableHeight = 0;
+		bool m_bRenderThread = false;
+		std::thread m_RenderThread;
+		// Set by the render thread before it stops, m_RenderThreadError is only read once the flag is seen
+		std::exception_ptr m_RenderThreadError;
+		std::atomic<bool> m_bRenderThreadFailed = false;
 
 		// Standard validation layer
 		const std::vector<const char*> m_ValidationLayers = 
@@ -132,6 +356,9 @@ namespace Tempus {
 			DESIRED_VK_LAYER
 		};
 
+		// Relative to the project root working directory
+		const char* m_PipelineCachePath = "bin/cache/pipeline.cache";
+
 		// Required device extensions
 		const std::vector<const char*> m_DeviceExtensions =
 		{
@@ -144,6 +371,13 @@ namespace Tempus {
 		const bool m_bEnableValidationLayers = false;
 #endif
 
+		// Shipping builds load their shaders once
+#ifdef TPS_DIST
+		const bool m_bEnableShaderHotReload = false;
+#else
+		const bool m_bEnableShaderHotReload = true;
+#endif
+
 		VkDebugUtilsMessengerEXT m_DebugMessenger = VK_NULL_HANDLE;
 
 	private:
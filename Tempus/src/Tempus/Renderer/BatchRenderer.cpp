@@ -0,0 +1,415 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "BatchRenderer.h"
+
+#include "Log.h"
+#include "Shaders/EmbeddedShaders.h"
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+
+namespace Tempus {
+
+	BatchRenderer::~BatchRenderer()
+	{
+		Shutdown();
+	}
+
+	bool BatchRenderer::Init(VkDevice device, GPUAllocator* allocator, UploadManager* uploads, PipelineStateCache* pipelineStates,
+		uint32_t framesInFlight, const BatchCapacity& capacity)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_Uploads = uploads;
+		m_PipelineStates = pipelineStates;
+		m_Capacity = capacity;
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		bufferInfo.size = static_cast<VkDeviceSize>(m_Capacity.MaxVertices) * sizeof(GPUVertex);
+		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bool bCreated = m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::GPUOnly, m_VertexBuffer, m_VertexAllocation);
+
+		bufferInfo.size = static_cast<VkDeviceSize>(m_Capacity.MaxIndices) * sizeof(uint32_t);
+		bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bCreated = bCreated && m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::GPUOnly, m_IndexBuffer, m_IndexAllocation);
+
+		if (!bCreated)
+		{
+			TPS_CORE_CRITICAL("Failed to create batch geometry buffers!");
+			return false;
+		}
+
+		m_InstanceBuffers.resize(framesInFlight);
+
+		if (!CreateProgram())
+		{
+			return false;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			m_ViewProjection[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+		}
+
+		TPS_CORE_INFO("Batch renderer initialized ({0} instances per frame max)", m_Capacity.MaxInstances);
+
+		return true;
+	}
+
+	void BatchRenderer::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		for (InstanceBuffer& instances : m_InstanceBuffers)
+		{
+			if (instances.Buffer != VK_NULL_HANDLE)
+			{
+				m_Allocator->DestroyBuffer(instances.Buffer, instances.Allocation);
+			}
+		}
+
+		m_InstanceBuffers.clear();
+
+		if (m_VertexBuffer != VK_NULL_HANDLE)
+		{
+			m_Uploads->Forget(m_VertexBuffer);
+			m_Allocator->DestroyBuffer(m_VertexBuffer, m_VertexAllocation);
+			m_VertexBuffer = VK_NULL_HANDLE;
+		}
+
+		if (m_IndexBuffer != VK_NULL_HANDLE)
+		{
+			m_Uploads->Forget(m_IndexBuffer);
+			m_Allocator->DestroyBuffer(m_IndexBuffer, m_IndexAllocation);
+			m_IndexBuffer = VK_NULL_HANDLE;
+		}
+
+		// The program's pipelines and layout belong to the pipeline state cache
+		m_Batches.clear();
+		m_BatchLookup.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	uint32_t BatchRenderer::AddMesh(const GPUVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		if (vertexCount == 0 || indexCount == 0)
+		{
+			return INVALID_INDEX;
+		}
+
+		if (m_VertexCount + vertexCount > m_Capacity.MaxVertices || m_IndexCount + indexCount > m_Capacity.MaxIndices ||
+			m_Meshes.size() >= m_Capacity.MaxMeshes)
+		{
+			TPS_CORE_ERROR("Batch renderer is out of mesh storage!");
+			return INVALID_INDEX;
+		}
+
+		// Append only, so uploads never touch memory a frame in flight reads
+		if (m_Uploads->UploadBuffer(m_VertexBuffer, m_VertexCount * sizeof(GPUVertex), vertices, vertexCount * sizeof(GPUVertex)) == 0 ||
+			m_Uploads->UploadBuffer(m_IndexBuffer, m_IndexCount * sizeof(uint32_t), indices, indexCount * sizeof(uint32_t)) == 0)
+		{
+			TPS_CORE_ERROR("Failed to upload batch mesh!");
+			return INVALID_INDEX;
+		}
+
+		Mesh mesh;
+		mesh.FirstIndex = m_IndexCount;
+		mesh.IndexCount = indexCount;
+		mesh.VertexOffset = static_cast<int32_t>(m_VertexCount);
+
+		m_VertexCount += vertexCount;
+		m_IndexCount += indexCount;
+		m_Meshes.push_back(mesh);
+
+		return static_cast<uint32_t>(m_Meshes.size() - 1);
+	}
+
+	uint32_t BatchRenderer::AddMaterial(const BatchMaterial& material)
+	{
+		// Only the colour changes between materials, the rest of the push constants is set once per frame
+		RenderMaterial queueMaterial;
+		queueMaterial.Layout = m_PipelineStates->GetLayout(m_Program);
+		queueMaterial.PushConstantStages = VK_SHADER_STAGE_VERTEX_BIT;
+		queueMaterial.PushConstantOffset = offsetof(PushConstants, Colour);
+		queueMaterial.PushConstantSize = sizeof(material.Colour);
+		std::memcpy(queueMaterial.PushConstants, material.Colour, sizeof(material.Colour));
+
+		// Material indices double as the queue's material IDs
+		uint32_t pipeline = m_Queue.RegisterPipeline(GetPipelineKey(material));
+		if (pipeline == RenderQueue::INVALID_ID || m_Queue.RegisterMaterial(queueMaterial) == RenderQueue::INVALID_ID)
+		{
+			return INVALID_INDEX;
+		}
+
+		m_Materials.push_back(material);
+		m_MaterialPipelines.push_back(pipeline);
+
+		return static_cast<uint32_t>(m_Materials.size() - 1);
+	}
+
+	void BatchRenderer::SetViewProjection(const float viewProjection[16])
+	{
+		std::memcpy(m_ViewProjection, viewProjection, sizeof(m_ViewProjection));
+	}
+
+	void BatchRenderer::Submit(uint32_t mesh, uint32_t material, const BatchTransform& transform)
+	{
+		if (m_SubmittedCount >= m_Capacity.MaxInstances)
+		{
+			m_DroppedCount++;
+			return;
+		}
+
+		uint64_t key = static_cast<uint64_t>(mesh) << 32 | material;
+
+		if (key != m_LastBatchKey)
+		{
+			if (mesh >= m_Meshes.size() || material >= m_Materials.size())
+			{
+				TPS_CORE_ERROR("Batch submitted with mesh {0} and material {1}, which don't exist", mesh, material);
+				return;
+			}
+
+			auto [it, bInserted] = m_BatchLookup.try_emplace(key, static_cast<uint32_t>(m_Batches.size()));
+
+			if (bInserted)
+			{
+				Batch& batch = m_Batches.emplace_back();
+				batch.Mesh = mesh;
+				batch.Material = material;
+			}
+
+			m_LastBatchKey = key;
+			m_LastBatch = it->second;
+		}
+
+		m_Batches[m_LastBatch].Transforms.push_back(transform);
+		m_SubmittedCount++;
+	}
+
+	void BatchRenderer::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_Queue.Reset();
+
+		m_Stats = BatchStats();
+		m_Stats.DroppedCount = m_DroppedCount;
+
+		if (m_DroppedCount > 0)
+		{
+			TPS_CORE_WARN("Batch renderer dropped {0} instances, the frame is limited to {1}", m_DroppedCount, m_Capacity.MaxInstances);
+		}
+
+		if (m_SubmittedCount == 0)
+		{
+			return;
+		}
+
+		InstanceBuffer& instances = m_InstanceBuffers[m_FrameIndex];
+
+		if (!ReserveInstances(instances, static_cast<VkDeviceSize>(m_SubmittedCount) * sizeof(BatchTransform)))
+		{
+			return;
+		}
+
+		// The slot's last submission has completed, so its buffer can be written directly
+		BatchTransform* mapped = static_cast<BatchTransform*>(instances.Allocation.MappedData);
+		uint32_t firstInstance = 0;
+
+		for (const Batch& batch : m_Batches)
+		{
+			if (batch.Transforms.empty())
+			{
+				continue;
+			}
+
+			const Mesh& mesh = m_Meshes[batch.Mesh];
+
+			QueuedDraw draw;
+			draw.Pipeline = m_MaterialPipelines[batch.Material];
+			draw.Material = batch.Material;
+			draw.VertexBuffer = m_VertexBuffer;
+			draw.IndexBuffer = m_IndexBuffer;
+			draw.IndexCount = mesh.IndexCount;
+			draw.InstanceCount = static_cast<uint32_t>(batch.Transforms.size());
+			draw.FirstIndex = mesh.FirstIndex;
+			draw.VertexOffset = mesh.VertexOffset;
+			draw.FirstInstance = firstInstance;
+
+			// Blended batches sort after the opaque ones, so they land on top of them. Instances of a batch are
+			// spread out, so there's no single depth to sort by
+			m_Queue.Submit(0, m_Materials[batch.Material].Blend != BlendMode::Opaque, 0, draw);
+
+			std::memcpy(mapped + firstInstance, batch.Transforms.data(), batch.Transforms.size() * sizeof(BatchTransform));
+			firstInstance += draw.InstanceCount;
+		}
+
+		m_Queue.Sort();
+
+		m_Stats.InstanceCount = firstInstance;
+		m_Stats.DrawCount = m_Queue.GetDrawCount();
+	}
+
+	void BatchRenderer::AddPasses(RenderGraph& graph, RGHandle colorTarget, VkFormat colorFormat, VkExtent2D extent)
+	{
+		if (m_Queue.GetDrawCount() == 0)
+		{
+			return;
+		}
+
+		m_Queue.SetAttachmentFormats(colorFormat, VK_FORMAT_D32_SFLOAT);
+
+		RGTextureDesc depthDesc;
+		depthDesc.Width = extent.width;
+		depthDesc.Height = extent.height;
+		depthDesc.Format = VK_FORMAT_D32_SFLOAT;
+		RGHandle depth = graph.CreateTexture("BatchDepth", depthDesc);
+
+		// Instances are written by the host before submission, which needs no barrier, so the buffer isn't imported
+		graph.AddPass("Batches", [this, extent](VkCommandBuffer commandBuffer) { RecordDraws(commandBuffer, extent); })
+			.AddColorAttachment(colorTarget, VK_ATTACHMENT_LOAD_OP_LOAD)
+			.SetDepthAttachment(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, 1.0f);
+	}
+
+	void BatchRenderer::EndFrame()
+	{
+		for (Batch& batch : m_Batches)
+		{
+			batch.Transforms.clear();
+		}
+
+		m_SubmittedCount = 0;
+		m_DroppedCount = 0;
+	}
+
+	void BatchRenderer::RegisterPrograms(PipelineReloader& reloader)
+	{
+		reloader.RegisterReload("Batch", {
+				{ "Tempus/res/shaders/batch.vert", "bin/shaders/batch_vert.spv" },
+				{ "Tempus/res/shaders/batch.frag", "bin/shaders/batch_frag.spv" }
+			},
+			[this](const std::vector<ShaderCode>& code) { return m_PipelineStates->ReloadProgram(m_Program, code[0], code[1]); });
+	}
+
+	bool BatchRenderer::CreateProgram()
+	{
+		ShaderCode vertCode = MakeShaderCode(EmbeddedShaders::BatchVert);
+		ShaderCode fragCode = MakeShaderCode(EmbeddedShaders::BatchFrag);
+
+		ShaderReflection vertReflection;
+		if (!vertReflection.Reflect(vertCode))
+		{
+			TPS_CORE_CRITICAL("Failed to reflect batch shaders!");
+			return false;
+		}
+
+		if (vertReflection.GetPushConstantSize() != sizeof(PushConstants))
+		{
+			TPS_CORE_CRITICAL("batch.vert push constants are {0} bytes, PushConstants is {1}", vertReflection.GetPushConstantSize(), sizeof(PushConstants));
+			return false;
+		}
+
+		ReflectedVertexLayout vertexLayout;
+		vertReflection.GetVertexLayout(vertexLayout);
+
+		if (vertexLayout.Binding.stride != sizeof(GPUVertex))
+		{
+			TPS_CORE_CRITICAL("batch.vert inputs are {0} bytes per vertex, GPUVertex is {1}", vertexLayout.Binding.stride, sizeof(GPUVertex));
+			return false;
+		}
+
+		m_Program = m_PipelineStates->RegisterProgram("Batch", vertCode, fragCode);
+
+		if (m_Program == PipelineStateCache::INVALID_PROGRAM)
+		{
+			TPS_CORE_CRITICAL("Failed to create batch program!");
+			return false;
+		}
+
+		return true;
+	}
+
+	bool BatchRenderer::ReserveInstances(InstanceBuffer& instances, VkDeviceSize size)
+	{
+		if (instances.Capacity >= size)
+		{
+			return true;
+		}
+
+		if (instances.Buffer != VK_NULL_HANDLE)
+		{
+			m_Allocator->DestroyBuffer(instances.Buffer, instances.Allocation);
+		}
+
+		// Grows geometrically up to a full frame, steady instance counts stop reallocating after a few frames
+		VkDeviceSize maxSize = static_cast<VkDeviceSize>(m_Capacity.MaxInstances) * sizeof(BatchTransform);
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = std::min(std::max(size, instances.Capacity * 2), maxSize);
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::CPUToGPU, instances.Buffer, instances.Allocation))
+		{
+			TPS_CORE_ERROR("Failed to create batch instance buffer!");
+			instances = InstanceBuffer();
+			return false;
+		}
+
+		VkBufferDeviceAddressInfo addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+		addressInfo.buffer = instances.Buffer;
+
+		instances.Capacity = bufferInfo.size;
+		instances.Address = vkGetBufferDeviceAddress(m_Device, &addressInfo);
+
+		return true;
+	}
+
+	PipelineKey BatchRenderer::GetPipelineKey(const BatchMaterial& material) const
+	{
+		PipelineKey key;
+		// The render queue fills in the attachment formats
+		key.Program = m_Program;
+		key.Blend = material.Blend;
+		key.CullMode = material.bTwoSided ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+		// Same winding and projection convention as the GPU scene
+		key.FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		key.bDepthTest = true;
+		key.bDepthWrite = material.Blend == BlendMode::Opaque;
+		key.DepthCompare = VK_COMPARE_OP_LESS;
+
+		return key;
+	}
+
+	void BatchRenderer::RecordDraws(VkCommandBuffer commandBuffer, VkExtent2D extent)
+	{
+		VkViewport viewport{};
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		// Everything but the colour is shared by all draws, so it's pushed once. Materials push the colour on top
+		PushConstants pushConstants{};
+		std::memcpy(pushConstants.ViewProjection, m_ViewProjection, sizeof(m_ViewProjection));
+		pushConstants.Instances = m_InstanceBuffers[m_FrameIndex].Address;
+		vkCmdPushConstants(commandBuffer, m_PipelineStates->GetLayout(m_Program), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PushConstants),
+			&pushConstants);
+
+		m_Queue.Record(commandBuffer, *m_PipelineStates);
+	}
+
+}
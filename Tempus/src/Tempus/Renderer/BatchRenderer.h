@@ -0,0 +1,182 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+#include "UploadManager.h"
+#include "RenderGraph.h"
+#include "GPUScene.h"
+#include "PipelineStateCache.h"
+#include "PipelineReloader.h"
+#include "RenderQueue.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <unordered_map>
+
+namespace Tempus {
+
+	// Row major 3x4 affine transform, the bottom row (0, 0, 0, 1) is implied. Matches Instance of batch.vert
+	struct BatchTransform
+	{
+		float Rows[3][4] =
+		{
+			{ 1.0f, 0.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f, 0.0f }
+		};
+	};
+
+	struct BatchMaterial
+	{
+		float Colour[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		// Blended materials are drawn after the opaque ones and don't write depth
+		BlendMode Blend = BlendMode::Opaque;
+		// Disables back face culling, eg. for sprites
+		bool bTwoSided = false;
+	};
+
+	struct BatchCapacity
+	{
+		uint32_t MaxVertices = 1u << 20;
+		uint32_t MaxIndices = 1u << 22;
+		uint32_t MaxMeshes = 1024;
+		// Per frame. Submissions past it are dropped
+		uint32_t MaxInstances = 1u << 20;
+	};
+
+	struct BatchStats
+	{
+		uint32_t InstanceCount = 0;
+		uint32_t DrawCount = 0;
+		// Submissions dropped because the frame was full
+		uint32_t DroppedCount = 0;
+	};
+
+	// Immediate mode instanced drawing. Submit() queues an instance of a mesh with a material, usually from
+	// Application::Update. When the frame is rendered every instance of the same mesh and material lands next to the
+	// others in that frame slot's instance buffer, and each group is drawn with a single instanced draw. The draws go
+	// through a render queue, so pipelines and materials are only bound when they change
+	class TEMPUS_API BatchRenderer
+	{
+	public:
+
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		BatchRenderer() = default;
+		~BatchRenderer();
+
+		bool Init(VkDevice device, GPUAllocator* allocator, UploadManager* uploads, PipelineStateCache* pipelineStates,
+			uint32_t framesInFlight, const BatchCapacity& capacity = BatchCapacity());
+		void Shutdown();
+
+		// Returns the mesh index, or INVALID_INDEX when the shared buffers are full
+		uint32_t AddMesh(const GPUVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+		// Init() must have succeeded
+		uint32_t AddMaterial(const BatchMaterial& material);
+
+		// Column major, clip space with Vulkan's [0, 1] depth range
+		void SetViewProjection(const float viewProjection[16]);
+
+		// Queues one instance for the next frame. Not thread safe, submit from the thread that runs the frame. Game code
+		// submits through Renderer::Submit(), which queues into the frame packet instead
+		void Submit(uint32_t mesh, uint32_t material, const BatchTransform& transform);
+
+		// The frame slot's previous submission must have completed. Writes the submitted instances into its buffer
+		void BeginFrame(uint32_t frameIndex);
+
+		// Adds the batch pass, drawing on top of colorTarget with its own depth buffer
+		void AddPasses(RenderGraph& graph, RGHandle colorTarget, VkFormat colorFormat, VkExtent2D extent);
+
+		// Drops the frame's submissions, whether or not the frame was rendered
+		void EndFrame();
+
+		// Describes the last frame that reached BeginFrame()
+		const BatchStats& GetStats() const { return m_Stats; }
+		// Binds done and avoided while recording the last frame
+		const RenderQueueStats& GetQueueStats() const { return m_Queue.GetStats(); }
+
+		// Registers the batch program for shader hot reload
+		void RegisterPrograms(PipelineReloader& reloader);
+
+	private:
+
+		// Matches the push constant block of batch.vert
+		struct PushConstants
+		{
+			float ViewProjection[16];
+			float Colour[4];
+			VkDeviceAddress Instances;
+		};
+
+		struct Mesh
+		{
+			uint32_t FirstIndex = 0;
+			uint32_t IndexCount = 0;
+			int32_t VertexOffset = 0;
+		};
+
+		struct Batch
+		{
+			uint32_t Mesh = 0;
+			uint32_t Material = 0;
+			// Kept between frames so steady submissions don't reallocate
+			std::vector<BatchTransform> Transforms;
+		};
+
+		struct InstanceBuffer
+		{
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			GPUAllocation Allocation;
+			VkDeviceSize Capacity = 0;
+			VkDeviceAddress Address = 0;
+		};
+
+		bool CreateProgram();
+		bool ReserveInstances(InstanceBuffer& instances, VkDeviceSize size);
+		PipelineKey GetPipelineKey(const BatchMaterial& material) const;
+
+		void RecordDraws(VkCommandBuffer commandBuffer, VkExtent2D extent);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+		UploadManager* m_Uploads = nullptr;
+		PipelineStateCache* m_PipelineStates = nullptr;
+		BatchCapacity m_Capacity;
+
+		uint32_t m_Program = PipelineStateCache::INVALID_PROGRAM;
+
+		VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_VertexAllocation;
+		VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_IndexAllocation;
+		uint32_t m_VertexCount = 0;
+		uint32_t m_IndexCount = 0;
+
+		std::vector<Mesh> m_Meshes;
+		std::vector<BatchMaterial> m_Materials;
+		// Render queue pipeline ID of each material. Material IDs are the material indices
+		std::vector<uint32_t> m_MaterialPipelines;
+
+		std::vector<Batch> m_Batches;
+		// Batch index by mesh in the high and material in the low 32 bits
+		std::unordered_map<uint64_t, uint32_t> m_BatchLookup;
+		// Consecutive submissions mostly share a batch, which skips the lookup
+		uint64_t m_LastBatchKey = UINT64_MAX;
+		uint32_t m_LastBatch = 0;
+		uint32_t m_SubmittedCount = 0;
+		uint32_t m_DroppedCount = 0;
+
+		RenderQueue m_Queue;
+		std::vector<InstanceBuffer> m_InstanceBuffers;
+		uint32_t m_FrameIndex = 0;
+
+		float m_ViewProjection[16] = {};
+		BatchStats m_Stats;
+
+	};
+
+}
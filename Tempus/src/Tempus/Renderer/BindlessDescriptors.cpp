@@ -0,0 +1,297 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "BindlessDescriptors.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	BindlessDescriptors::~BindlessDescriptors()
+	{
+		Shutdown();
+	}
+
+	bool BindlessDescriptors::Init(VkPhysicalDevice physicalDevice, VkDevice device, DeletionQueue* deletionQueue, bool bSupported)
+	{
+		if (!bSupported)
+		{
+			TPS_CORE_WARN("Descriptor indexing is not supported, bindless descriptors disabled");
+			return true;
+		}
+
+		m_Device = device;
+		m_DeletionQueue = deletionQueue;
+
+		VkPhysicalDeviceVulkan12Properties properties12{};
+		properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &properties12;
+
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+		// Images and buffers share the per stage resource limit
+		uint32_t resourceLimit = properties12.maxPerStageUpdateAfterBindResources / 2;
+
+		m_Images.Capacity = std::min({ MAX_IMAGES, properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, resourceLimit });
+		m_Samplers.Capacity = std::min({ MAX_SAMPLERS, properties12.maxDescriptorSetUpdateAfterBindSamplers,
+			properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+		m_Buffers.Capacity = std::min({ MAX_BUFFERS, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+			properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers, resourceLimit });
+
+		VkDescriptorSetLayoutBinding bindings[3]{};
+		bindings[IMAGE_BINDING] = { IMAGE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_Images.Capacity, VK_SHADER_STAGE_ALL, nullptr };
+		bindings[SAMPLER_BINDING] = { SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, m_Samplers.Capacity, VK_SHADER_STAGE_ALL, nullptr };
+		bindings[BUFFER_BINDING] = { BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_Buffers.Capacity, VK_SHADER_STAGE_ALL, nullptr };
+
+		// Unregistered slots are never written, and registering only touches slots no frame in flight reads
+		VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+		VkDescriptorBindingFlags bindingFlags[3] = { flags, flags, flags };
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = 3;
+		flagsInfo.pBindingFlags = bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &flagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 3;
+		layoutInfo.pBindings = bindings;
+
+		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &m_Layout) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to create bindless descriptor set layout!");
+			return false;
+		}
+
+		VkDescriptorPoolSize poolSizes[3] =
+		{
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_Images.Capacity },
+			{ VK_DESCRIPTOR_TYPE_SAMPLER, m_Samplers.Capacity },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_Buffers.Capacity }
+		};
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 3;
+		poolInfo.pPoolSizes = poolSizes;
+
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &m_Pool) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to create bindless descriptor pool!");
+			return false;
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_Pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &m_Layout;
+
+		if (vkAllocateDescriptorSets(m_Device, &allocInfo, &m_Set) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to allocate the bindless descriptor set!");
+			m_Set = VK_NULL_HANDLE;
+			return false;
+		}
+
+		TPS_CORE_INFO("Bindless descriptors initialized ({0} images, {1} samplers, {2} buffers)", m_Images.Capacity,
+			m_Samplers.Capacity, m_Buffers.Capacity);
+
+		return true;
+	}
+
+	void BindlessDescriptors::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		// Destroying the pool frees the set
+		if (m_Pool != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(m_Device, m_Pool, nullptr);
+			m_Pool = VK_NULL_HANDLE;
+		}
+
+		if (m_Layout != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorSetLayout(m_Device, m_Layout, nullptr);
+			m_Layout = VK_NULL_HANDLE;
+		}
+
+		m_Set = VK_NULL_HANDLE;
+		m_Images = HandleArray();
+		m_Samplers = HandleArray();
+		m_Buffers = HandleArray();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	uint32_t BindlessDescriptors::RegisterImage(VkImageView imageView, VkImageLayout layout)
+	{
+		if (!IsSupported())
+		{
+			return INVALID_HANDLE;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint32_t handle = AllocateHandle(m_Images, "image");
+		if (handle == INVALID_HANDLE)
+		{
+			return INVALID_HANDLE;
+		}
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageView = imageView;
+		imageInfo.imageLayout = layout;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = IMAGE_BINDING;
+		write.dstArrayElement = handle;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return handle;
+	}
+
+	uint32_t BindlessDescriptors::RegisterSampler(VkSampler sampler)
+	{
+		if (!IsSupported())
+		{
+			return INVALID_HANDLE;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint32_t handle = AllocateHandle(m_Samplers, "sampler");
+		if (handle == INVALID_HANDLE)
+		{
+			return INVALID_HANDLE;
+		}
+
+		VkDescriptorImageInfo samplerInfo{};
+		samplerInfo.sampler = sampler;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = SAMPLER_BINDING;
+		write.dstArrayElement = handle;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+		write.pImageInfo = &samplerInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return handle;
+	}
+
+	uint32_t BindlessDescriptors::RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		if (!IsSupported())
+		{
+			return INVALID_HANDLE;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint32_t handle = AllocateHandle(m_Buffers, "buffer");
+		if (handle == INVALID_HANDLE)
+		{
+			return INVALID_HANDLE;
+		}
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_Set;
+		write.dstBinding = BUFFER_BINDING;
+		write.dstArrayElement = handle;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		return handle;
+	}
+
+	void BindlessDescriptors::ReleaseImage(uint32_t handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ReleaseHandle(m_Images, handle);
+	}
+
+	void BindlessDescriptors::ReleaseSampler(uint32_t handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ReleaseHandle(m_Samplers, handle);
+	}
+
+	void BindlessDescriptors::ReleaseBuffer(uint32_t handle)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		ReleaseHandle(m_Buffers, handle);
+	}
+
+	void BindlessDescriptors::Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const
+	{
+		if (m_Set != VK_NULL_HANDLE)
+		{
+			vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, SET, 1, &m_Set, 0, nullptr);
+		}
+	}
+
+	uint32_t BindlessDescriptors::AllocateHandle(HandleArray& handles, const char* type)
+	{
+		if (!handles.FreeHandles.empty())
+		{
+			uint32_t handle = handles.FreeHandles.back();
+			handles.FreeHandles.pop_back();
+			return handle;
+		}
+
+		if (handles.Next >= handles.Capacity)
+		{
+			TPS_CORE_ERROR("Bindless descriptors are out of {0} slots ({1})!", type, handles.Capacity);
+			return INVALID_HANDLE;
+		}
+
+		return handles.Next++;
+	}
+
+	void BindlessDescriptors::ReleaseHandle(HandleArray& handles, uint32_t handle)
+	{
+		if (handle >= handles.Next)
+		{
+			return;
+		}
+
+		// Every frame recorded so far may have drawn with the handle
+		m_DeletionQueue->Defer([this, &handles, handle]()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			handles.FreeHandles.push_back(handle);
+		});
+	}
+
+}
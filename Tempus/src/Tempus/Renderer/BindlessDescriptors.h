@@ -0,0 +1,95 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "DeletionQueue.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <mutex>
+
+namespace Tempus {
+
+	// One global descriptor set holding every sampled image, sampler and storage buffer in large partially bound
+	// arrays. Resources are registered once and referenced from shaders by the 32 bit handle Register returns, so a
+	// draw only passes handles (eg. in push constants) and the set is bound once per command buffer. Shaders declare
+	// the set as
+	//
+	//   layout(set = 1, binding = 0) uniform texture2D textures[];
+	//   layout(set = 1, binding = 1) uniform sampler samplers[];
+	//   layout(set = 1, binding = 2) buffer Buffers { uint data[]; } buffers[];
+	//
+	// and index with nonuniformEXT() when a handle can differ within a draw. Requires the descriptor indexing
+	// features, see IsSupported(). Without them Init() leaves the heap disabled and Register returns INVALID_HANDLE
+	class TEMPUS_API BindlessDescriptors
+	{
+	public:
+
+		static constexpr uint32_t SET = 1;
+		static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+		static constexpr uint32_t IMAGE_BINDING = 0;
+		static constexpr uint32_t SAMPLER_BINDING = 1;
+		static constexpr uint32_t BUFFER_BINDING = 2;
+
+		// Upper bounds, lowered to the device's update after bind limits
+		static constexpr uint32_t MAX_IMAGES = 1u << 16;
+		static constexpr uint32_t MAX_SAMPLERS = 1u << 10;
+		static constexpr uint32_t MAX_BUFFERS = 1u << 16;
+
+		BindlessDescriptors() = default;
+		~BindlessDescriptors();
+
+		// bSupported is whether the descriptor indexing features were enabled on the device. Only fails when they were
+		// and the set can't be created. Released handles wait in deletionQueue, which has to be flushed before Shutdown()
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, DeletionQueue* deletionQueue, bool bSupported);
+		void Shutdown();
+
+		bool IsSupported() const { return m_Set != VK_NULL_HANDLE; }
+
+		// Thread safe. The descriptor is written immediately, slots no frame in flight uses may be updated after bind
+		uint32_t RegisterImage(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		uint32_t RegisterSampler(VkSampler sampler);
+		uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+		// Thread safe. The handle is recycled once every frame that may have used it has completed
+		void ReleaseImage(uint32_t handle);
+		void ReleaseSampler(uint32_t handle);
+		void ReleaseBuffer(uint32_t handle);
+
+		// Binds the set at SET. layout has to declare the bindless set, which every program that uses it does
+		void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const;
+
+		VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+
+	private:
+
+		// Handles of one binding. Released handles come back to FreeHandles through the deletion queue
+		struct HandleArray
+		{
+			uint32_t Capacity = 0;
+			uint32_t Next = 0;
+			std::vector<uint32_t> FreeHandles;
+		};
+
+		uint32_t AllocateHandle(HandleArray& handles, const char* type);
+		void ReleaseHandle(HandleArray& handles, uint32_t handle);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		DeletionQueue* m_DeletionQueue = nullptr;
+		VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
+		VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+		VkDescriptorSet m_Set = VK_NULL_HANDLE;
+
+		HandleArray m_Images;
+		HandleArray m_Samplers;
+		HandleArray m_Buffers;
+
+		std::mutex m_Mutex;
+
+	};
+
+}
@@ -0,0 +1,253 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "CommandRecorder.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	CommandRecorder::~CommandRecorder()
+	{
+		Shutdown();
+	}
+
+	bool CommandRecorder::Init(VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t threadCount)
+	{
+		m_Device = device;
+		m_FramesInFlight = framesInFlight;
+
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		m_ThreadCount = std::clamp(threadCount, 1u, MAX_THREADS);
+		m_Pools.resize(m_FramesInFlight * m_ThreadCount);
+		m_Results.resize(m_ThreadCount, VK_NULL_HANDLE);
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		// Buffers are never reset individually, the whole pool is reset once per frame
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamily;
+
+		for (ThreadPool& pool : m_Pools)
+		{
+			if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &pool.Pool) != VK_SUCCESS)
+			{
+				TPS_CORE_CRITICAL("Failed to create recording command pool!");
+				return false;
+			}
+		}
+
+		for (uint32_t i = 1; i < m_ThreadCount; i++)
+		{
+			m_Workers.emplace_back(&CommandRecorder::WorkerLoop, this, i);
+		}
+
+		TPS_CORE_INFO("Command recording on {0} threads", m_ThreadCount);
+
+		return true;
+	}
+
+	void CommandRecorder::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bStopping = true;
+		}
+
+		m_WorkCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+
+		m_Workers.clear();
+
+		// Destroying a pool frees its command buffers
+		for (ThreadPool& pool : m_Pools)
+		{
+			if (pool.Pool != VK_NULL_HANDLE)
+			{
+				vkDestroyCommandPool(m_Device, pool.Pool, nullptr);
+			}
+		}
+
+		m_Pools.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void CommandRecorder::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+
+		for (uint32_t thread = 0; thread < m_ThreadCount; thread++)
+		{
+			ThreadPool& pool = m_Pools[m_FrameIndex * m_ThreadCount + thread];
+			vkResetCommandPool(m_Device, pool.Pool, 0);
+			pool.UsedCount = 0;
+		}
+	}
+
+	bool CommandRecorder::Record(const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunc& func,
+		std::vector<VkCommandBuffer>& outCommandBuffers, uint32_t threadCount)
+	{
+		if (itemCount == 0)
+		{
+			return true;
+		}
+
+		threadCount = threadCount == 0 ? m_ThreadCount : std::min(threadCount, m_ThreadCount);
+		// No point waking threads for a handful of items each
+		threadCount = std::min(threadCount, itemCount);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			m_Job.Inheritance = &inheritance;
+			m_Job.Func = &func;
+			m_Job.ThreadCount = threadCount;
+			m_Job.ItemCount = itemCount;
+
+			m_PendingWorkers = threadCount - 1;
+			m_Generation++;
+		}
+
+		if (threadCount > 1)
+		{
+			m_WorkCondition.notify_all();
+		}
+
+		RecordRange(0);
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_DoneCondition.wait(lock, [this]() { return m_PendingWorkers == 0; });
+		}
+
+		// Every thread has at least one item, so a missing buffer is a failed range
+		for (uint32_t thread = 0; thread < threadCount; thread++)
+		{
+			if (m_Results[thread] == VK_NULL_HANDLE)
+			{
+				return false;
+			}
+		}
+
+		outCommandBuffers.insert(outCommandBuffers.end(), m_Results.begin(), m_Results.begin() + threadCount);
+		return true;
+	}
+
+	void CommandRecorder::WorkerLoop(uint32_t threadIndex)
+	{
+		uint64_t seenGeneration = 0;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkCondition.wait(lock, [&]() { return m_bStopping || m_Generation != seenGeneration; });
+
+				if (m_bStopping)
+				{
+					return;
+				}
+
+				seenGeneration = m_Generation;
+
+				if (threadIndex >= m_Job.ThreadCount)
+				{
+					continue;
+				}
+			}
+
+			RecordRange(threadIndex);
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				if (--m_PendingWorkers == 0)
+				{
+					m_DoneCondition.notify_one();
+				}
+			}
+		}
+	}
+
+	void CommandRecorder::RecordRange(uint32_t threadIndex)
+	{
+		// Spread the remainder over the first threads so ranges differ by at most one item
+		uint32_t baseCount = m_Job.ItemCount / m_Job.ThreadCount;
+		uint32_t remainder = m_Job.ItemCount % m_Job.ThreadCount;
+		uint32_t first = threadIndex * baseCount + std::min(threadIndex, remainder);
+		uint32_t count = baseCount + (threadIndex < remainder ? 1 : 0);
+
+		m_Results[threadIndex] = VK_NULL_HANDLE;
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		VkCommandBuffer commandBuffer = AcquireCommandBuffer(threadIndex);
+		if (commandBuffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = m_Job.Inheritance;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to begin secondary command buffer!");
+			return;
+		}
+
+		(*m_Job.Func)(commandBuffer, threadIndex, first, count);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to record secondary command buffer!");
+			return;
+		}
+
+		m_Results[threadIndex] = commandBuffer;
+	}
+
+	VkCommandBuffer CommandRecorder::AcquireCommandBuffer(uint32_t threadIndex)
+	{
+		// Only ever touched by its own thread
+		ThreadPool& pool = m_Pools[m_FrameIndex * m_ThreadCount + threadIndex];
+
+		if (pool.UsedCount == pool.CommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.Pool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				TPS_CORE_ERROR("Failed to allocate secondary command buffer!");
+				return VK_NULL_HANDLE;
+			}
+
+			pool.CommandBuffers.push_back(commandBuffer);
+		}
+
+		return pool.CommandBuffers[pool.UsedCount++];
+	}
+
+}
@@ -0,0 +1,93 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Tempus {
+
+	// Records secondary command buffers on worker threads. Every thread owns one command pool per frame in flight,
+	// so recording never contends on a pool and a frame's pools are reset wholesale once the frame has completed.
+	// The calling thread records the first range itself instead of idling
+	class TEMPUS_API CommandRecorder
+	{
+	public:
+
+		static constexpr uint32_t MAX_THREADS = 16;
+
+		// Records items [first, first + count) into commandBuffer, which is already begun. threadIndex is the recording
+		// thread's index below GetThreadCount(), 0 being the calling thread, eg. for FrameDescriptorAllocator::Allocate
+		using RecordFunc = std::function<void(VkCommandBuffer commandBuffer, uint32_t threadIndex, uint32_t first, uint32_t count)>;
+
+		CommandRecorder() = default;
+		~CommandRecorder();
+
+		// threadCount includes the calling thread. 0 picks one per hardware thread
+		bool Init(VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t threadCount = 0);
+		void Shutdown();
+
+		// Resets the pools of a frame slot. The slot's previous submission must have completed
+		void BeginFrame(uint32_t frameIndex);
+
+		// Splits [0, itemCount) into contiguous ranges, one per thread, and records them into secondary command buffers.
+		// The buffers are appended in range order so executing them matches a serial recording.
+		// threadCount limits how many threads take part, 0 uses all of them. Returns false when any range failed to
+		// record, outCommandBuffers is left as it was then so a partial recording never gets executed
+		bool Record(const VkCommandBufferInheritanceInfo& inheritance, uint32_t itemCount, const RecordFunc& func,
+			std::vector<VkCommandBuffer>& outCommandBuffers, uint32_t threadCount = 0);
+
+		uint32_t GetThreadCount() const { return m_ThreadCount; }
+
+	private:
+
+		struct ThreadPool
+		{
+			VkCommandPool Pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> CommandBuffers;
+			uint32_t UsedCount = 0;
+		};
+
+		struct Job
+		{
+			const VkCommandBufferInheritanceInfo* Inheritance = nullptr;
+			const RecordFunc* Func = nullptr;
+			uint32_t ThreadCount = 0;
+			uint32_t ItemCount = 0;
+		};
+
+		void WorkerLoop(uint32_t threadIndex);
+		void RecordRange(uint32_t threadIndex);
+		VkCommandBuffer AcquireCommandBuffer(uint32_t threadIndex);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		uint32_t m_ThreadCount = 1;
+		uint32_t m_FramesInFlight = 1;
+		uint32_t m_FrameIndex = 0;
+
+		// Indexed by frameIndex * m_ThreadCount + threadIndex
+		std::vector<ThreadPool> m_Pools;
+
+		std::vector<std::thread> m_Workers;
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkCondition;
+		std::condition_variable m_DoneCondition;
+		uint64_t m_Generation = 0;
+		uint32_t m_PendingWorkers = 0;
+		bool m_bStopping = false;
+
+		Job m_Job;
+		// One slot per thread, VK_NULL_HANDLE when the thread's range was empty
+		std::vector<VkCommandBuffer> m_Results;
+
+	};
+
+}
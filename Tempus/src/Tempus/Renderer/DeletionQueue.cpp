@@ -0,0 +1,212 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "DeletionQueue.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	DeletionQueue::~DeletionQueue()
+	{
+		Shutdown();
+	}
+
+	void DeletionQueue::Init(VkDevice device, GPUAllocator* allocator, uint32_t maxDestroysPerFrame)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_MaxDestroysPerFrame = std::max(maxDestroysPerFrame, 1u);
+	}
+
+	void DeletionQueue::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		// Callbacks may queue more, so keep going until nothing is left
+		while (true)
+		{
+			std::deque<Entry> entries;
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				entries.swap(m_Entries);
+				m_FirstUnresolved = 0;
+			}
+
+			if (entries.empty())
+			{
+				break;
+			}
+
+			for (Entry& entry : entries)
+			{
+				Destroy(entry);
+			}
+		}
+
+		m_Destroying.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void DeletionQueue::DestroyBuffer(VkBuffer buffer, const GPUAllocation& allocation, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Buffer;
+		entry.Buffer = buffer;
+		entry.Allocation = allocation;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroyImage(VkImage image, const GPUAllocation& allocation, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Image;
+		entry.Image = image;
+		entry.Allocation = allocation;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroyImageView(VkImageView imageView, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::ImageView;
+		entry.ImageView = imageView;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroySampler(VkSampler sampler, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Sampler;
+		entry.Sampler = sampler;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroyPipeline(VkPipeline pipeline, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Pipeline;
+		entry.Pipeline = pipeline;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroyPipelineLayout(VkPipelineLayout layout, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::PipelineLayout;
+		entry.PipelineLayout = layout;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::DestroyDescriptorPool(VkDescriptorPool pool, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::DescriptorPool;
+		entry.DescriptorPool = pool;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::FreeMemory(const GPUAllocation& allocation, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Memory;
+		entry.Allocation = allocation;
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::Defer(std::function<void()> callback, uint64_t frameValue)
+	{
+		Entry entry;
+		entry.Type = ObjectType::Callback;
+		entry.Callback = std::move(callback);
+		Push(std::move(entry), frameValue);
+	}
+
+	void DeletionQueue::Update(uint64_t submittedFrameValue, uint64_t completedFrameValue)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// Every frame up to the submitted one may have recorded a use of the object
+			for (size_t i = m_FirstUnresolved; i < m_Entries.size(); i++)
+			{
+				if (m_Entries[i].FrameValue == CURRENT_FRAME)
+				{
+					m_Entries[i].FrameValue = submittedFrameValue;
+				}
+			}
+
+			m_FirstUnresolved = m_Entries.size();
+
+			// Stops at the first entry that isn't done yet, entries behind it were queued later and wait with it
+			while (!m_Entries.empty() && m_Destroying.size() < m_MaxDestroysPerFrame && m_Entries.front().FrameValue <= completedFrameValue)
+			{
+				m_Destroying.push_back(std::move(m_Entries.front()));
+				m_Entries.pop_front();
+				m_FirstUnresolved--;
+			}
+		}
+
+		// Unlocked, callbacks take their owner's lock and that owner may be queueing at the same time
+		for (Entry& entry : m_Destroying)
+		{
+			Destroy(entry);
+		}
+
+		m_DestroyedCount += m_Destroying.size();
+		m_Destroying.clear();
+	}
+
+	uint32_t DeletionQueue::GetPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return static_cast<uint32_t>(m_Entries.size());
+	}
+
+	void DeletionQueue::Push(Entry&& entry, uint64_t frameValue)
+	{
+		entry.FrameValue = frameValue;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Entries.push_back(std::move(entry));
+	}
+
+	void DeletionQueue::Destroy(Entry& entry)
+	{
+		switch (entry.Type)
+		{
+		case ObjectType::Buffer:
+			m_Allocator->DestroyBuffer(entry.Buffer, entry.Allocation);
+			break;
+		case ObjectType::Image:
+			m_Allocator->DestroyImage(entry.Image, entry.Allocation);
+			break;
+		case ObjectType::ImageView:
+			vkDestroyImageView(m_Device, entry.ImageView, nullptr);
+			break;
+		case ObjectType::Sampler:
+			vkDestroySampler(m_Device, entry.Sampler, nullptr);
+			break;
+		case ObjectType::Pipeline:
+			vkDestroyPipeline(m_Device, entry.Pipeline, nullptr);
+			break;
+		case ObjectType::PipelineLayout:
+			vkDestroyPipelineLayout(m_Device, entry.PipelineLayout, nullptr);
+			break;
+		case ObjectType::DescriptorPool:
+			vkDestroyDescriptorPool(m_Device, entry.DescriptorPool, nullptr);
+			break;
+		case ObjectType::Memory:
+			m_Allocator->Free(entry.Allocation);
+			break;
+		case ObjectType::Callback:
+			entry.Callback();
+			break;
+		}
+	}
+
+}
@@ -0,0 +1,113 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+
+#include "vulkan/vulkan.h"
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+namespace Tempus {
+
+	// Destroys Vulkan objects once the GPU is done with them, instead of waiting for the device to go idle. Objects are
+	// queued with the frame value of the last frame that may use them and destroyed by Update() once the frame timeline
+	// has passed it. Update() destroys at most the per frame cap, so releasing many resources at once spreads the
+	// driver calls and frees over several frames instead of spiking one.
+	//
+	// Objects are destroyed in the order they were queued, so an image queued before the memory it's bound to is
+	// always destroyed first. Anything else that has to wait for the GPU, like recycling a bindless handle, is queued
+	// as a callback and counts against the same cap
+	class TEMPUS_API DeletionQueue
+	{
+	public:
+
+		static constexpr uint32_t DEFAULT_MAX_DESTROYS_PER_FRAME = 256;
+		// The object may be used by any frame recorded so far. Update() resolves it to the last submitted frame
+		static constexpr uint64_t CURRENT_FRAME = 0;
+
+		DeletionQueue() = default;
+		~DeletionQueue();
+
+		void Init(VkDevice device, GPUAllocator* allocator, uint32_t maxDestroysPerFrame = DEFAULT_MAX_DESTROYS_PER_FRAME);
+		// The device must be idle. Destroys everything still queued
+		void Shutdown();
+
+		// Thread safe. frameValue is the last frame that may use the object
+		void DestroyBuffer(VkBuffer buffer, const GPUAllocation& allocation, uint64_t frameValue = CURRENT_FRAME);
+		void DestroyImage(VkImage image, const GPUAllocation& allocation, uint64_t frameValue = CURRENT_FRAME);
+		void DestroyImageView(VkImageView imageView, uint64_t frameValue = CURRENT_FRAME);
+		void DestroySampler(VkSampler sampler, uint64_t frameValue = CURRENT_FRAME);
+		void DestroyPipeline(VkPipeline pipeline, uint64_t frameValue = CURRENT_FRAME);
+		void DestroyPipelineLayout(VkPipelineLayout layout, uint64_t frameValue = CURRENT_FRAME);
+		void DestroyDescriptorPool(VkDescriptorPool pool, uint64_t frameValue = CURRENT_FRAME);
+		// Memory allocated separately from the objects bound to it, eg. aliased render graph textures
+		void FreeMemory(const GPUAllocation& allocation, uint64_t frameValue = CURRENT_FRAME);
+		// Runs on the render thread without the queue locked, so it may queue more work
+		void Defer(std::function<void()> callback, uint64_t frameValue = CURRENT_FRAME);
+
+		// Called by the render thread between frames. submittedFrameValue is the last frame handed to the GPU and
+		// completedFrameValue the last one it finished
+		void Update(uint64_t submittedFrameValue, uint64_t completedFrameValue);
+
+		uint32_t GetPendingCount() const;
+		uint64_t GetDestroyedCount() const { return m_DestroyedCount; }
+
+	private:
+
+		enum class ObjectType : uint8_t
+		{
+			Buffer,
+			Image,
+			ImageView,
+			Sampler,
+			Pipeline,
+			PipelineLayout,
+			DescriptorPool,
+			Memory,
+			Callback
+		};
+
+		struct Entry
+		{
+			ObjectType Type = ObjectType::Memory;
+			union
+			{
+				VkBuffer Buffer;
+				VkImage Image;
+				VkImageView ImageView;
+				VkSampler Sampler;
+				VkPipeline Pipeline;
+				VkPipelineLayout PipelineLayout;
+				VkDescriptorPool DescriptorPool;
+			};
+			GPUAllocation Allocation;
+			std::function<void()> Callback;
+			uint64_t FrameValue = CURRENT_FRAME;
+
+			Entry() : Buffer(VK_NULL_HANDLE) {}
+		};
+
+		void Push(Entry&& entry, uint64_t frameValue);
+		void Destroy(Entry& entry);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+		uint32_t m_MaxDestroysPerFrame = DEFAULT_MAX_DESTROYS_PER_FRAME;
+
+		std::deque<Entry> m_Entries;
+		// Entries from here on were queued since the last Update() and may still hold CURRENT_FRAME
+		size_t m_FirstUnresolved = 0;
+		// Render thread only. Entries taken off the queue by Update(), destroyed once the lock is released
+		std::vector<Entry> m_Destroying;
+		uint64_t m_DestroyedCount = 0;
+		mutable std::mutex m_Mutex;
+
+	};
+
+}
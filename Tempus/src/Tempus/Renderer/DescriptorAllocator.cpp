@@ -0,0 +1,241 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "DescriptorAllocator.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		Shutdown();
+	}
+
+	bool DescriptorAllocator::Init(VkDevice device, uint32_t setsPerPool, const std::vector<DescriptorPoolRatio>& ratios)
+	{
+		m_Device = device;
+		m_SetsPerPool = std::clamp(setsPerPool, 1u, MAX_SETS_PER_POOL);
+		m_Ratios = ratios;
+
+		if (m_Ratios.empty())
+		{
+			m_Ratios =
+			{
+				{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+				{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f },
+				{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+				{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f }
+			};
+		}
+
+		return true;
+	}
+
+	void DescriptorAllocator::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		// Destroying a pool frees its sets
+		for (VkDescriptorPool pool : m_ReadyPools)
+		{
+			vkDestroyDescriptorPool(m_Device, pool, nullptr);
+		}
+
+		for (VkDescriptorPool pool : m_FullPools)
+		{
+			vkDestroyDescriptorPool(m_Device, pool, nullptr);
+		}
+
+		m_ReadyPools.clear();
+		m_FullPools.clear();
+		m_CurrentPoolSetCount = 0;
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout, const void* pNext)
+	{
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.pNext = pNext;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		// Every failure retires a pool that has sets in it, so this ends at an empty pool at the latest
+		while (true)
+		{
+			VkDescriptorPool pool = GetPool();
+			if (pool == VK_NULL_HANDLE)
+			{
+				return VK_NULL_HANDLE;
+			}
+
+			allocInfo.descriptorPool = pool;
+
+			VkDescriptorSet set = VK_NULL_HANDLE;
+			VkResult result = vkAllocateDescriptorSets(m_Device, &allocInfo, &set);
+
+			if (result == VK_SUCCESS)
+			{
+				m_CurrentPoolSetCount++;
+				return set;
+			}
+
+			if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+			{
+				TPS_CORE_ERROR("Failed to allocate a descriptor set!");
+				return VK_NULL_HANDLE;
+			}
+
+			// An empty pool that can't fit the set means the layout needs descriptor types or counts the ratios don't
+			// provide. The pool stays ready, retiring it would only grow the next one for nothing
+			if (m_CurrentPoolSetCount == 0)
+			{
+				TPS_CORE_ERROR("Descriptor set layout is incompatible with the pool ratios, it needs more than an empty pool holds!");
+				return VK_NULL_HANDLE;
+			}
+
+			m_ReadyPools.pop_back();
+			m_FullPools.push_back(pool);
+			m_CurrentPoolSetCount = 0;
+		}
+	}
+
+	void DescriptorAllocator::Reset()
+	{
+		for (VkDescriptorPool pool : m_ReadyPools)
+		{
+			vkResetDescriptorPool(m_Device, pool, 0);
+		}
+
+		for (VkDescriptorPool pool : m_FullPools)
+		{
+			vkResetDescriptorPool(m_Device, pool, 0);
+			m_ReadyPools.push_back(pool);
+		}
+
+		m_FullPools.clear();
+		m_CurrentPoolSetCount = 0;
+	}
+
+	VkDescriptorPool DescriptorAllocator::GetPool()
+	{
+		if (!m_ReadyPools.empty())
+		{
+			return m_ReadyPools.back();
+		}
+
+		// Pools are created on first use. Each one is larger than the last, so a frame that outgrew its pools settles on
+		// a few large ones
+		VkDescriptorPool pool = CreatePool(m_SetsPerPool);
+		m_SetsPerPool = std::min(m_SetsPerPool + m_SetsPerPool / 2, MAX_SETS_PER_POOL);
+
+		if (pool != VK_NULL_HANDLE)
+		{
+			m_ReadyPools.push_back(pool);
+		}
+
+		return pool;
+	}
+
+	VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		poolSizes.reserve(m_Ratios.size());
+
+		for (const DescriptorPoolRatio& ratio : m_Ratios)
+		{
+			VkDescriptorPoolSize poolSize{};
+			poolSize.type = ratio.Type;
+			poolSize.descriptorCount = std::max(static_cast<uint32_t>(ratio.Ratio * setCount), 1u);
+			poolSizes.push_back(poolSize);
+		}
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = setCount;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		if (vkCreateDescriptorPool(m_Device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to create a descriptor pool for {0} sets!", setCount);
+			return VK_NULL_HANDLE;
+		}
+
+		return pool;
+	}
+
+	FrameDescriptorAllocator::~FrameDescriptorAllocator()
+	{
+		Shutdown();
+	}
+
+	bool FrameDescriptorAllocator::Init(VkDevice device, uint32_t framesInFlight, uint32_t threadCount, uint32_t setsPerPool,
+		const std::vector<DescriptorPoolRatio>& ratios)
+	{
+		m_FramesInFlight = framesInFlight;
+		m_ThreadCount = threadCount;
+		m_Allocators.resize(static_cast<size_t>(framesInFlight) * (m_ThreadCount + 1));
+
+		for (std::unique_ptr<DescriptorAllocator>& allocator : m_Allocators)
+		{
+			allocator = std::make_unique<DescriptorAllocator>();
+
+			if (!allocator->Init(device, setsPerPool, ratios))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void FrameDescriptorAllocator::Shutdown()
+	{
+		m_Allocators.clear();
+	}
+
+	void FrameDescriptorAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+
+		size_t first = static_cast<size_t>(frameIndex) * (m_ThreadCount + 1);
+
+		for (size_t i = first; i < first + m_ThreadCount + 1; i++)
+		{
+			m_Allocators[i]->Reset();
+		}
+	}
+
+	VkDescriptorSet FrameDescriptorAllocator::Allocate(uint32_t threadIndex, VkDescriptorSetLayout layout, const void* pNext)
+	{
+		size_t first = static_cast<size_t>(m_FrameIndex) * (m_ThreadCount + 1);
+
+		if (threadIndex < m_ThreadCount)
+		{
+			return m_Allocators[first + threadIndex]->Allocate(layout, pNext);
+		}
+
+		std::lock_guard<std::mutex> lock(m_SharedMutex);
+		return m_Allocators[first + m_ThreadCount]->Allocate(layout, pNext);
+	}
+
+	uint32_t FrameDescriptorAllocator::GetPoolCount() const
+	{
+		uint32_t count = 0;
+		for (const std::unique_ptr<DescriptorAllocator>& allocator : m_Allocators)
+		{
+			count += allocator->GetPoolCount();
+		}
+
+		return count;
+	}
+
+}
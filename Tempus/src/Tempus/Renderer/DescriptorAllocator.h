@@ -0,0 +1,106 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <mutex>
+#include <memory>
+
+namespace Tempus {
+
+	// Descriptors of a type per set in a pool
+	struct DescriptorPoolRatio
+	{
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		float Ratio = 1.0f;
+	};
+
+	// Allocates descriptor sets from a list of pools sized by per type ratios. When a pool runs out it's set aside and
+	// allocation moves to a new pool, each one larger than the last, so one oversized pool never has to be guessed up
+	// front. Reset() returns every set at once, which is all the freeing there is. Not thread safe
+	class TEMPUS_API DescriptorAllocator
+	{
+	public:
+
+		static constexpr uint32_t DEFAULT_SETS_PER_POOL = 64;
+		static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+		DescriptorAllocator() = default;
+		~DescriptorAllocator();
+
+		// Empty ratios use a mix suited to material and per-draw sets
+		bool Init(VkDevice device, uint32_t setsPerPool = DEFAULT_SETS_PER_POOL, const std::vector<DescriptorPoolRatio>& ratios = {});
+		void Shutdown();
+
+		// pNext is chained to the VkDescriptorSetAllocateInfo, eg. for variable descriptor counts. Returns
+		// VK_NULL_HANDLE on failure
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout, const void* pNext = nullptr);
+
+		// Frees every set allocated so far. None of them may still be in use by the GPU
+		void Reset();
+
+		uint32_t GetPoolCount() const { return static_cast<uint32_t>(m_ReadyPools.size() + m_FullPools.size()); }
+
+	private:
+
+		VkDescriptorPool GetPool();
+		VkDescriptorPool CreatePool(uint32_t setCount);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		std::vector<DescriptorPoolRatio> m_Ratios;
+		// Set count of the next pool created
+		uint32_t m_SetsPerPool = DEFAULT_SETS_PER_POOL;
+
+		// Pools with room left, allocation uses the last one. Full pools wait here for Reset()
+		std::vector<VkDescriptorPool> m_ReadyPools;
+		std::vector<VkDescriptorPool> m_FullPools;
+		// Sets allocated from the last ready pool. Every other ready pool is untouched since it was created or reset
+		uint32_t m_CurrentPoolSetCount = 0;
+
+	};
+
+	// Transient descriptor sets that live for one frame. Every CommandRecorder thread gets its own growable allocator per
+	// frame in flight, so allocating per draw from recording threads never takes a lock, and BeginFrame() resets a frame
+	// slot's allocators wholesale once its previous submission has completed
+	class TEMPUS_API FrameDescriptorAllocator
+	{
+	public:
+
+		// Any other thread passes this and shares one allocator behind a mutex
+		static constexpr uint32_t SHARED_THREAD = UINT32_MAX;
+
+		FrameDescriptorAllocator() = default;
+		~FrameDescriptorAllocator();
+
+		// threadCount is the command recorder's, see CommandRecorder::GetThreadCount
+		bool Init(VkDevice device, uint32_t framesInFlight, uint32_t threadCount,
+			uint32_t setsPerPool = DescriptorAllocator::DEFAULT_SETS_PER_POOL, const std::vector<DescriptorPoolRatio>& ratios = {});
+		void Shutdown();
+
+		// The frame slot's previous submission must have completed, and no thread may allocate during the call
+		void BeginFrame(uint32_t frameIndex);
+
+		// Thread safe. threadIndex is the recording thread's, see CommandRecorder::RecordFunc. No two threads may pass the
+		// same index at once. The set is valid until this frame slot comes around again
+		VkDescriptorSet Allocate(uint32_t threadIndex, VkDescriptorSetLayout layout, const void* pNext = nullptr);
+
+		uint32_t GetPoolCount() const;
+
+	private:
+
+		uint32_t m_FramesInFlight = 0;
+		uint32_t m_ThreadCount = 0;
+		uint32_t m_FrameIndex = 0;
+
+		// Indexed by frameIndex * (m_ThreadCount + 1) + threadIndex. The last slot of a frame is the shared one
+		std::vector<std::unique_ptr<DescriptorAllocator>> m_Allocators;
+		std::mutex m_SharedMutex;
+
+	};
+
+}
@@ -0,0 +1,182 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "DescriptorLayoutCache.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <numeric>
+
+namespace Tempus {
+
+	void DescriptorSetLayoutDesc::Normalize()
+	{
+		if (std::is_sorted(Bindings.begin(), Bindings.end(),
+			[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; }))
+		{
+			return;
+		}
+
+		// Binding flags are positional, so they are permuted along with the bindings
+		std::vector<uint32_t> order(Bindings.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return Bindings[a].binding < Bindings[b].binding; });
+
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+		for (uint32_t index : order)
+		{
+			bindings.push_back(Bindings[index]);
+			if (!BindingFlags.empty())
+			{
+				bindingFlags.push_back(BindingFlags[index]);
+			}
+		}
+
+		Bindings = std::move(bindings);
+		BindingFlags = std::move(bindingFlags);
+	}
+
+	bool DescriptorSetLayoutDesc::operator==(const DescriptorSetLayoutDesc& other) const
+	{
+		if (Flags != other.Flags || Bindings.size() != other.Bindings.size() || BindingFlags != other.BindingFlags)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Bindings.size(); i++)
+		{
+			const VkDescriptorSetLayoutBinding& a = Bindings[i];
+			const VkDescriptorSetLayoutBinding& b = other.Bindings[i];
+
+			if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount ||
+				a.stageFlags != b.stageFlags)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	size_t DescriptorSetLayoutDescHash::operator()(const DescriptorSetLayoutDesc& desc) const
+	{
+		// FNV-1a over every field that takes part in the comparison
+		uint64_t hash = 14695981039346656037ull;
+		auto mix = [&hash](uint32_t word) { hash = (hash ^ word) * 1099511628211ull; };
+
+		mix(desc.Flags);
+
+		for (const VkDescriptorSetLayoutBinding& binding : desc.Bindings)
+		{
+			mix(binding.binding);
+			mix(static_cast<uint32_t>(binding.descriptorType));
+			mix(binding.descriptorCount);
+			mix(binding.stageFlags);
+		}
+
+		for (VkDescriptorBindingFlags flags : desc.BindingFlags)
+		{
+			mix(flags);
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
+	DescriptorLayoutCache::~DescriptorLayoutCache()
+	{
+		Shutdown();
+	}
+
+	void DescriptorLayoutCache::Init(VkDevice device)
+	{
+		m_Device = device;
+	}
+
+	void DescriptorLayoutCache::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		for (const auto& [desc, layout] : m_Layouts)
+		{
+			vkDestroyDescriptorSetLayout(m_Device, layout, nullptr);
+		}
+
+		m_Layouts.clear();
+		m_ReservedSets.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	VkDescriptorSetLayout DescriptorLayoutCache::GetLayout(DescriptorSetLayoutDesc desc)
+	{
+		desc.Normalize();
+
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+			auto it = m_Layouts.find(desc);
+			if (it != m_Layouts.end())
+			{
+				return it->second;
+			}
+		}
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+		auto it = m_Layouts.find(desc);
+		if (it != m_Layouts.end())
+		{
+			return it->second;
+		}
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = static_cast<uint32_t>(desc.BindingFlags.size());
+		flagsInfo.pBindingFlags = desc.BindingFlags.data();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = desc.BindingFlags.empty() ? nullptr : &flagsInfo;
+		layoutInfo.flags = desc.Flags;
+		layoutInfo.bindingCount = static_cast<uint32_t>(desc.Bindings.size());
+		layoutInfo.pBindings = desc.Bindings.data();
+
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		if (vkCreateDescriptorSetLayout(m_Device, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to create descriptor set layout!");
+			return VK_NULL_HANDLE;
+		}
+
+		m_Layouts.emplace(std::move(desc), layout);
+		return layout;
+	}
+
+	uint32_t DescriptorLayoutCache::GetLayoutCount() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return static_cast<uint32_t>(m_Layouts.size());
+	}
+
+	void DescriptorLayoutCache::ReserveSet(uint32_t set, VkDescriptorSetLayout layout)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+		if (set >= m_ReservedSets.size())
+		{
+			m_ReservedSets.resize(set + 1, VK_NULL_HANDLE);
+		}
+
+		m_ReservedSets[set] = layout;
+	}
+
+	VkDescriptorSetLayout DescriptorLayoutCache::GetReservedSet(uint32_t set) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return set < m_ReservedSets.size() ? m_ReservedSets[set] : VK_NULL_HANDLE;
+	}
+
+}
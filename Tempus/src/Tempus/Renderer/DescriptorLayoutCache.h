@@ -0,0 +1,67 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+
+namespace Tempus {
+
+	// Everything that defines a descriptor set layout. Immutable samplers aren't supported
+	struct DescriptorSetLayoutDesc
+	{
+		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		// Empty, or one entry per binding
+		std::vector<VkDescriptorBindingFlags> BindingFlags;
+		VkDescriptorSetLayoutCreateFlags Flags = 0;
+
+		// Sorts the bindings by index so that declaration order doesn't matter
+		void Normalize();
+		bool operator==(const DescriptorSetLayoutDesc& other) const;
+	};
+
+	struct DescriptorSetLayoutDescHash
+	{
+		size_t operator()(const DescriptorSetLayoutDesc& desc) const;
+	};
+
+	// Deduplicates descriptor set layouts. Programs declaring the same set get the same VkDescriptorSetLayout, so sets
+	// allocated for one of them can be bound with any of the others. Owns the layouts, lookups are thread safe
+	class TEMPUS_API DescriptorLayoutCache
+	{
+	public:
+
+		DescriptorLayoutCache() = default;
+		~DescriptorLayoutCache();
+
+		void Init(VkDevice device);
+		void Shutdown();
+
+		// Creates the layout on first use. Returns VK_NULL_HANDLE on failure
+		VkDescriptorSetLayout GetLayout(DescriptorSetLayoutDesc desc);
+
+		uint32_t GetLayoutCount() const;
+
+		// Makes every reflected pipeline layout use layout for set instead of the set the shaders declare, for sets
+		// the engine binds itself like BindlessDescriptors. The caller keeps ownership of layout. Call before any
+		// pipeline layout is created
+		void ReserveSet(uint32_t set, VkDescriptorSetLayout layout);
+		VkDescriptorSetLayout GetReservedSet(uint32_t set) const;
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		std::unordered_map<DescriptorSetLayoutDesc, VkDescriptorSetLayout, DescriptorSetLayoutDescHash> m_Layouts;
+		// Indexed by set, VK_NULL_HANDLE where nothing is reserved
+		std::vector<VkDescriptorSetLayout> m_ReservedSets;
+		// Shared for lookups, exclusive while a layout is added
+		mutable std::shared_mutex m_Mutex;
+
+	};
+
+}
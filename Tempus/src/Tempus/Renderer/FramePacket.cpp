@@ -0,0 +1,106 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "FramePacket.h"
+
+#include <algorithm>
+
+namespace Tempus {
+
+	void FramePacket::BeginFrom(const FramePacket& previous)
+	{
+		if (&previous != this)
+		{
+			std::copy(previous.ClearColour, previous.ClearColour + 4, ClearColour);
+			std::copy(previous.ViewProjection, previous.ViewProjection + 16, ViewProjection);
+			bHasViewProjection = previous.bHasViewProjection;
+			DrawableWidth = previous.DrawableWidth;
+			DrawableHeight = previous.DrawableHeight;
+		}
+
+		FrameNumber = previous.FrameNumber + 1;
+
+		Draws.clear();
+		Instances.clear();
+		CapturePath.clear();
+	}
+
+	FramePacketQueue::FramePacketQueue()
+	{
+		for (uint32_t i = 0; i < PACKET_COUNT; i++)
+		{
+			m_Free[i] = &m_Packets[i];
+		}
+
+		m_FreeCount = PACKET_COUNT;
+	}
+
+	FramePacket* FramePacketQueue::Acquire()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return m_FreeCount > 0; });
+
+		return m_Free[--m_FreeCount];
+	}
+
+	void FramePacketQueue::Publish(FramePacket* packet)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Ready[m_ReadyCount++] = packet;
+		}
+
+		m_Condition.notify_all();
+	}
+
+	void FramePacketQueue::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return m_bClosed || (m_ReadyCount == 0 && m_RenderingCount == 0); });
+	}
+
+	bool FramePacketQueue::IsIdle() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_bClosed || (m_ReadyCount == 0 && m_RenderingCount == 0);
+	}
+
+	FramePacket* FramePacketQueue::Pop()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return m_bClosed || m_ReadyCount > 0; });
+
+		if (m_bClosed)
+		{
+			return nullptr;
+		}
+
+		FramePacket* packet = m_Ready[0];
+		std::copy(m_Ready + 1, m_Ready + m_ReadyCount, m_Ready);
+		m_ReadyCount--;
+		m_RenderingCount++;
+
+		return packet;
+	}
+
+	void FramePacketQueue::Release(FramePacket* packet)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Free[m_FreeCount++] = packet;
+			m_RenderingCount--;
+		}
+
+		m_Condition.notify_all();
+	}
+
+	void FramePacketQueue::Close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bClosed = true;
+		}
+
+		m_Condition.notify_all();
+	}
+
+}
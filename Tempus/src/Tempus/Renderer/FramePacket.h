@@ -0,0 +1,104 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "BatchRenderer.h"
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+
+namespace Tempus {
+
+	struct DrawCommand
+	{
+		uint32_t VertexCount = 0;
+		uint32_t InstanceCount = 1;
+		uint32_t FirstVertex = 0;
+		uint32_t FirstInstance = 0;
+	};
+
+	struct BatchInstance
+	{
+		uint32_t Mesh = 0;
+		uint32_t Material = 0;
+		BatchTransform Transform;
+	};
+
+	// Everything the game thread hands the renderer for one frame. Once published the packet is only read, by the render
+	// thread, while the game thread writes the next one. Clear colour and camera carry over from the previous packet,
+	// the draw lists start out empty every frame
+	struct FramePacket
+	{
+		uint64_t FrameNumber = 0;
+
+		float ClearColour[4] = { 0.25f, 0.5f, 0.1f, 0.0f };
+
+		// Window drawable size in pixels, queried on the game thread since SDL window calls can't move to the render thread
+		uint32_t DrawableWidth = 0;
+		uint32_t DrawableHeight = 0;
+
+		// Batch renderer camera, column major. Left alone until the game sets one
+		float ViewProjection[16] = {};
+		bool bHasViewProjection = false;
+
+		std::vector<DrawCommand> Draws;
+		std::vector<BatchInstance> Instances;
+
+		// Headless only, the frame is captured when not empty
+		std::string CapturePath;
+
+		// Starts the next frame from previous, keeping the lists' capacity
+		void BeginFrom(const FramePacket& previous);
+	};
+
+	// Bounded handoff between the game and render threads over PACKET_COUNT packets. The game thread fills the packet it
+	// acquired and publishes it, the render thread pops, renders and releases it. With two packets the game thread runs
+	// at most one frame ahead and blocks in Acquire() until the render thread hands one back
+	class TEMPUS_API FramePacketQueue
+	{
+	public:
+
+		static constexpr uint32_t PACKET_COUNT = 2;
+
+		FramePacketQueue();
+
+		FramePacketQueue(const FramePacketQueue&) = delete;
+		FramePacketQueue& operator=(const FramePacketQueue&) = delete;
+
+		// Game thread. Blocks until a packet is free
+		FramePacket* Acquire();
+		void Publish(FramePacket* packet);
+		// Game thread. Blocks until every published packet has been released
+		void WaitIdle();
+		// True when no published packet is waiting or being rendered, or once closed
+		bool IsIdle() const;
+
+		// Render thread. Blocks until a packet is published, returns nullptr once closed
+		FramePacket* Pop();
+		void Release(FramePacket* packet);
+
+		// Wakes the render thread to exit, packets still queued are dropped
+		void Close();
+
+	private:
+
+		FramePacket m_Packets[PACKET_COUNT];
+
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+
+		FramePacket* m_Free[PACKET_COUNT] = {};
+		uint32_t m_FreeCount = 0;
+		// Published packets, oldest first
+		FramePacket* m_Ready[PACKET_COUNT] = {};
+		uint32_t m_ReadyCount = 0;
+		// Popped and not yet released
+		uint32_t m_RenderingCount = 0;
+		bool m_bClosed = false;
+
+	};
+
+}
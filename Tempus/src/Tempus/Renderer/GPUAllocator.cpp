@@ -0,0 +1,603 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "GPUAllocator.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <random>
+
+namespace Tempus {
+
+	struct GPUMemoryBlock
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Size = 0;
+		// Base pointer of the persistent mapping, null for device local memory
+		void* MappedData = nullptr;
+		uint32_t PoolIndex = 0;
+		TLSFAllocator Allocator;
+	};
+
+	GPUAllocator::~GPUAllocator()
+	{
+		Shutdown();
+	}
+
+	bool GPUAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize, bool bBufferDeviceAddress)
+	{
+		m_PhysicalDevice = physicalDevice;
+		m_Device = device;
+		m_PreferredBlockSize = preferredBlockSize;
+		m_bBufferDeviceAddress = bBufferDeviceAddress;
+
+		vkGetPhysicalDeviceMemoryProperties(m_PhysicalDevice, &m_MemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+		m_BufferImageGranularity = properties.limits.bufferImageGranularity;
+
+		// Linear and optimal resources sharing a block would have to be padded apart to the granularity.
+		// Giving each its own pool avoids that padding entirely
+		uint32_t poolsPerType = m_BufferImageGranularity > 1 ? 2 : 1;
+		m_Pools.resize(m_MemoryProperties.memoryTypeCount * poolsPerType);
+
+		for (uint32_t i = 0; i < m_Pools.size(); i++)
+		{
+			uint32_t memoryTypeIndex = i / poolsPerType;
+			VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+
+			m_Pools[i].MemoryTypeIndex = memoryTypeIndex;
+			// Small heaps (eg. the 256MB host visible device local heap) get proportionally smaller blocks
+			m_Pools[i].BlockSize = heapSize <= 1024ull * 1024 * 1024 ? (std::min)(m_PreferredBlockSize, heapSize / 8) : m_PreferredBlockSize;
+		}
+
+		TPS_CORE_INFO("GPU allocator initialized ({0} memory types, bufferImageGranularity {1})", m_MemoryProperties.memoryTypeCount, m_BufferImageGranularity);
+
+		return true;
+	}
+
+	void GPUAllocator::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		uint32_t leakedAllocations = m_DedicatedAllocationCount;
+
+		for (MemoryPool& pool : m_Pools)
+		{
+			for (auto& block : pool.Blocks)
+			{
+				leakedAllocations += block->Allocator.GetAllocationCount();
+				vkFreeMemory(m_Device, block->Memory, nullptr);
+			}
+
+			pool.Blocks.clear();
+		}
+
+		if (leakedAllocations > 0)
+		{
+			TPS_CORE_WARN("GPU allocator shut down with {0} live allocations!", leakedAllocations);
+		}
+
+		m_Pools.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	bool GPUAllocator::Allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, bool bLinear, GPUAllocation& outAllocation)
+	{
+		uint32_t memoryTypeIndex;
+
+		if (!FindMemoryType(requirements.memoryTypeBits, usage, memoryTypeIndex))
+		{
+			TPS_CORE_ERROR("Failed to find suitable memory type!");
+			return false;
+		}
+
+		uint32_t poolIndex = GetPoolIndex(memoryTypeIndex, bLinear);
+
+		// Anything larger than half a block would waste most of a new block, so it gets its own memory
+		if (requirements.size > m_Pools[poolIndex].BlockSize / 2)
+		{
+			return AllocateDedicated(memoryTypeIndex, requirements.size, VK_NULL_HANDLE, VK_NULL_HANDLE, outAllocation);
+		}
+
+		return AllocateFromPool(poolIndex, requirements, outAllocation);
+	}
+
+	void GPUAllocator::Free(GPUAllocation& allocation)
+	{
+		if (!allocation.IsValid())
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!allocation.Block)
+		{
+			vkFreeMemory(m_Device, allocation.Memory, nullptr);
+
+			m_DedicatedAllocationCount--;
+			m_DedicatedBytes -= allocation.Size;
+			m_DeviceMemoryCount--;
+
+			allocation = GPUAllocation();
+			return;
+		}
+
+		GPUMemoryBlock* block = allocation.Block;
+		block->Allocator.Free(allocation.SubAllocation);
+
+		// Keep a single empty block around per pool so alloc/free patterns at a block boundary don't thrash vkAllocateMemory
+		if (block->Allocator.IsEmpty())
+		{
+			MemoryPool& pool = m_Pools[block->PoolIndex];
+
+			bool bHasOtherEmptyBlock = std::any_of(pool.Blocks.begin(), pool.Blocks.end(),
+				[block](const std::unique_ptr<GPUMemoryBlock>& other)
+				{
+					return other.get() != block && other->Allocator.IsEmpty();
+				});
+
+			if (bHasOtherEmptyBlock)
+			{
+				vkFreeMemory(m_Device, block->Memory, nullptr);
+				m_DeviceMemoryCount--;
+
+				pool.Blocks.erase(std::find_if(pool.Blocks.begin(), pool.Blocks.end(),
+					[block](const std::unique_ptr<GPUMemoryBlock>& other)
+					{
+						return other.get() == block;
+					}));
+			}
+		}
+
+		allocation = GPUAllocation();
+	}
+
+	bool GPUAllocator::CreateBuffer(const VkBufferCreateInfo& createInfo, MemoryUsage usage, VkBuffer& outBuffer, GPUAllocation& outAllocation, bool bDedicated)
+	{
+		if (vkCreateBuffer(m_Device, &createInfo, nullptr, &outBuffer) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to create buffer!");
+			return false;
+		}
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.buffer = outBuffer;
+
+		vkGetBufferMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+		bool bAllocated;
+
+		// The driver may ask for a dedicated allocation on its own
+		if (bDedicated || dedicatedRequirements.prefersDedicatedAllocation)
+		{
+			uint32_t memoryTypeIndex;
+			bAllocated = FindMemoryType(requirements.memoryRequirements.memoryTypeBits, usage, memoryTypeIndex) &&
+				AllocateDedicated(memoryTypeIndex, requirements.memoryRequirements.size, outBuffer, VK_NULL_HANDLE, outAllocation);
+		}
+		else
+		{
+			bAllocated = Allocate(requirements.memoryRequirements, usage, true, outAllocation);
+		}
+
+		if (!bAllocated || vkBindBufferMemory(m_Device, outBuffer, outAllocation.Memory, outAllocation.Offset) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to allocate buffer memory!");
+			Free(outAllocation);
+			vkDestroyBuffer(m_Device, outBuffer, nullptr);
+			outBuffer = VK_NULL_HANDLE;
+			return false;
+		}
+
+		return true;
+	}
+
+	void GPUAllocator::DestroyBuffer(VkBuffer buffer, GPUAllocation& allocation)
+	{
+		vkDestroyBuffer(m_Device, buffer, nullptr);
+		Free(allocation);
+	}
+
+	bool GPUAllocator::CreateImage(const VkImageCreateInfo& createInfo, MemoryUsage usage, VkImage& outImage, GPUAllocation& outAllocation, bool bDedicated)
+	{
+		if (vkCreateImage(m_Device, &createInfo, nullptr, &outImage) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to create image!");
+			return false;
+		}
+
+		VkMemoryDedicatedRequirements dedicatedRequirements{};
+		dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+		VkMemoryRequirements2 requirements{};
+		requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+		requirements.pNext = &dedicatedRequirements;
+
+		VkImageMemoryRequirementsInfo2 requirementsInfo{};
+		requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+		requirementsInfo.image = outImage;
+
+		vkGetImageMemoryRequirements2(m_Device, &requirementsInfo, &requirements);
+
+		bool bAllocated;
+
+		if (bDedicated || dedicatedRequirements.prefersDedicatedAllocation)
+		{
+			uint32_t memoryTypeIndex;
+			bAllocated = FindMemoryType(requirements.memoryRequirements.memoryTypeBits, usage, memoryTypeIndex) &&
+				AllocateDedicated(memoryTypeIndex, requirements.memoryRequirements.size, VK_NULL_HANDLE, outImage, outAllocation);
+		}
+		else
+		{
+			bAllocated = Allocate(requirements.memoryRequirements, usage, createInfo.tiling == VK_IMAGE_TILING_LINEAR, outAllocation);
+		}
+
+		if (!bAllocated || vkBindImageMemory(m_Device, outImage, outAllocation.Memory, outAllocation.Offset) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to allocate image memory!");
+			Free(outAllocation);
+			vkDestroyImage(m_Device, outImage, nullptr);
+			outImage = VK_NULL_HANDLE;
+			return false;
+		}
+
+		return true;
+	}
+
+	void GPUAllocator::DestroyImage(VkImage image, GPUAllocation& allocation)
+	{
+		vkDestroyImage(m_Device, image, nullptr);
+		Free(allocation);
+	}
+
+	GPUAllocatorStats GPUAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		GPUAllocatorStats stats;
+		VkDeviceSize largestFreeSum = 0;
+
+		for (const MemoryPool& pool : m_Pools)
+		{
+			for (const auto& block : pool.Blocks)
+			{
+				stats.BlockCount++;
+				stats.AllocationCount += block->Allocator.GetAllocationCount();
+				stats.BytesAllocated += block->Size;
+				stats.BytesUsed += block->Allocator.GetUsedSize();
+				stats.BytesFree += block->Allocator.GetFreeSize();
+				largestFreeSum += block->Allocator.GetLargestFreeRange();
+			}
+		}
+
+		stats.DedicatedAllocationCount = m_DedicatedAllocationCount;
+		stats.AllocationCount += m_DedicatedAllocationCount;
+		stats.BytesAllocated += m_DedicatedBytes;
+		stats.BytesUsed += m_DedicatedBytes;
+
+		if (stats.BytesFree > 0)
+		{
+			stats.Fragmentation = 1.0f - static_cast<float>(static_cast<double>(largestFreeSum) / static_cast<double>(stats.BytesFree));
+		}
+
+		return stats;
+	}
+
+	void GPUAllocator::LogStats() const
+	{
+		GPUAllocatorStats stats = GetStats();
+
+		TPS_CORE_INFO("GPU memory: {0} blocks, {1} dedicated, {2} allocations, {3:.2f} MB used / {4:.2f} MB free of {5:.2f} MB, fragmentation {6:.2f}",
+			stats.BlockCount, stats.DedicatedAllocationCount, stats.AllocationCount,
+			stats.BytesUsed / (1024.0 * 1024.0), stats.BytesFree / (1024.0 * 1024.0), stats.BytesAllocated / (1024.0 * 1024.0),
+			stats.Fragmentation);
+	}
+
+	void GPUAllocator::RunBenchmark(uint32_t operationCount, uint32_t liveCount)
+	{
+		// Raw allocations count against maxMemoryAllocationCount, which is as low as 4096 on common drivers
+		liveCount = std::clamp(liveCount, 1u, 2048u);
+
+		VkMemoryRequirements requirements{};
+		requirements.alignment = 256;
+		// Every memory type. Shifting by 32 is undefined, which VK_MAX_MEMORY_TYPES types would do
+		requirements.memoryTypeBits = m_MemoryProperties.memoryTypeCount >= 32 ? UINT32_MAX : (1u << m_MemoryProperties.memoryTypeCount) - 1;
+
+		uint32_t memoryTypeIndex;
+		if (!FindMemoryType(requirements.memoryTypeBits, MemoryUsage::GPUOnly, memoryTypeIndex))
+		{
+			TPS_CORE_ERROR("GPU allocator benchmark found no device local memory type!");
+			return;
+		}
+
+		// Log uniform from 256 bytes to 1 MB, mostly small buffers with the odd large one. Everything stays below half a
+		// block so the allocator never falls back to dedicated memory. Both runs replay the same sizes and frees
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<double> logSize(std::log2(256.0), std::log2(1024.0 * 1024.0));
+		std::uniform_int_distribution<uint32_t> slot(0, liveCount - 1);
+
+		std::vector<VkDeviceSize> sizes(liveCount + operationCount);
+		std::vector<uint32_t> slots(operationCount);
+
+		for (VkDeviceSize& size : sizes)
+		{
+			size = (static_cast<VkDeviceSize>(std::exp2(logSize(gen))) + 255) & ~VkDeviceSize(255);
+		}
+
+		for (uint32_t& index : slots)
+		{
+			index = slot(gen);
+		}
+
+		auto elapsed = [](std::chrono::high_resolution_clock::time_point start)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		std::vector<GPUAllocation> allocations(liveCount);
+		bool bFailed = false;
+
+		for (uint32_t i = 0; i < liveCount && !bFailed; i++)
+		{
+			requirements.size = sizes[i];
+			bFailed = !Allocate(requirements, MemoryUsage::GPUOnly, true, allocations[i]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < operationCount && !bFailed; i++)
+		{
+			Free(allocations[slots[i]]);
+			requirements.size = sizes[liveCount + i];
+			bFailed = !Allocate(requirements, MemoryUsage::GPUOnly, true, allocations[slots[i]]);
+		}
+
+		double pooledTime = elapsed(start);
+		GPUAllocatorStats stats = GetStats();
+
+		for (GPUAllocation& allocation : allocations)
+		{
+			Free(allocation);
+		}
+
+		std::vector<VkDeviceMemory> memories(liveCount, VK_NULL_HANDLE);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		for (uint32_t i = 0; i < liveCount && !bFailed; i++)
+		{
+			allocInfo.allocationSize = sizes[i];
+			bFailed = vkAllocateMemory(m_Device, &allocInfo, nullptr, &memories[i]) != VK_SUCCESS;
+		}
+
+		start = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t i = 0; i < operationCount && !bFailed; i++)
+		{
+			vkFreeMemory(m_Device, memories[slots[i]], nullptr);
+			allocInfo.allocationSize = sizes[liveCount + i];
+
+			if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &memories[slots[i]]) != VK_SUCCESS)
+			{
+				memories[slots[i]] = VK_NULL_HANDLE;
+				bFailed = true;
+			}
+		}
+
+		double rawTime = elapsed(start);
+
+		for (VkDeviceMemory memory : memories)
+		{
+			if (memory != VK_NULL_HANDLE)
+			{
+				vkFreeMemory(m_Device, memory, nullptr);
+			}
+		}
+
+		if (bFailed)
+		{
+			TPS_CORE_ERROR("GPU allocator benchmark ran out of device memory!");
+			return;
+		}
+
+		auto perOperation = [operationCount](double milliseconds) { return operationCount > 0 ? milliseconds * 1000.0 / operationCount : 0.0; };
+
+		TPS_CORE_INFO("GPU allocator benchmark: {0} free and allocate pairs, {1} live allocations of 256 B to 1 MB", operationCount, liveCount);
+		TPS_CORE_INFO("\tTLSF sub-allocation: {0:.3f} ms ({1:.3f} us per pair), {2} blocks, fragmentation {3:.2f}", pooledTime,
+			perOperation(pooledTime), stats.BlockCount, stats.Fragmentation);
+		TPS_CORE_INFO("\tvkAllocateMemory:    {0:.3f} ms ({1:.3f} us per pair, {2:.1f}x)", rawTime, perOperation(rawTime),
+			pooledTime > 0.0 ? rawTime / pooledTime : 0.0);
+	}
+
+	bool GPUAllocator::FindMemoryType(uint32_t typeBits, MemoryUsage usage, uint32_t& outTypeIndex) const
+	{
+		VkMemoryPropertyFlags required = 0;
+		VkMemoryPropertyFlags preferred = 0;
+		VkMemoryPropertyFlags notPreferred = 0;
+
+		switch (usage)
+		{
+		case MemoryUsage::GPUOnly:
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			notPreferred = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			break;
+		case MemoryUsage::CPUToGPU:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+			notPreferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		case MemoryUsage::GPUToCPU:
+			required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		}
+
+		int bestCost = INT32_MAX;
+
+		// Pick the memory type that satisfies all required flags and misses the fewest preferences
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = m_MemoryProperties.memoryTypes[i].propertyFlags;
+
+			if (!(typeBits & (1u << i)) || (flags & required) != required)
+			{
+				continue;
+			}
+
+			int cost = std::popcount(preferred & ~flags) + std::popcount(flags & notPreferred);
+
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				outTypeIndex = i;
+			}
+		}
+
+		return bestCost != INT32_MAX;
+	}
+
+	bool GPUAllocator::AllocateFromPool(uint32_t poolIndex, const VkMemoryRequirements& requirements, GPUAllocation& outAllocation)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		MemoryPool& pool = m_Pools[poolIndex];
+		GPUMemoryBlock* block = nullptr;
+		TLSFAllocator::Allocation subAllocation;
+
+		for (auto& candidate : pool.Blocks)
+		{
+			subAllocation = candidate->Allocator.Allocate(requirements.size, requirements.alignment);
+
+			if (subAllocation.IsValid())
+			{
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (!block)
+		{
+			auto newBlock = std::make_unique<GPUMemoryBlock>();
+			newBlock->Size = pool.BlockSize;
+			newBlock->PoolIndex = poolIndex;
+
+			if (!AllocateDeviceMemory(pool.MemoryTypeIndex, newBlock->Size, nullptr, newBlock->Memory, newBlock->MappedData))
+			{
+				return false;
+			}
+
+			newBlock->Allocator.Reset(newBlock->Size);
+			subAllocation = newBlock->Allocator.Allocate(requirements.size, requirements.alignment);
+
+			block = newBlock.get();
+			pool.Blocks.push_back(std::move(newBlock));
+		}
+
+		outAllocation.Memory = block->Memory;
+		outAllocation.Offset = subAllocation.Offset;
+		outAllocation.Size = subAllocation.Size;
+		outAllocation.MappedData = block->MappedData ? static_cast<char*>(block->MappedData) + subAllocation.Offset : nullptr;
+		outAllocation.Block = block;
+		outAllocation.SubAllocation = subAllocation;
+
+		return true;
+	}
+
+	bool GPUAllocator::AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, VkBuffer buffer, VkImage image, GPUAllocation& outAllocation)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// Telling the driver which resource owns the memory lets it pick the optimal placement
+		VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+		dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.buffer = buffer;
+		dedicatedInfo.image = image;
+
+		bool bHasResource = buffer != VK_NULL_HANDLE || image != VK_NULL_HANDLE;
+
+		if (!AllocateDeviceMemory(memoryTypeIndex, size, bHasResource ? &dedicatedInfo : nullptr, outAllocation.Memory, outAllocation.MappedData))
+		{
+			return false;
+		}
+
+		outAllocation.Offset = 0;
+		outAllocation.Size = size;
+		outAllocation.Block = nullptr;
+
+		m_DedicatedAllocationCount++;
+		m_DedicatedBytes += size;
+
+		return true;
+	}
+
+	bool GPUAllocator::AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, const void* pNext, VkDeviceMemory& outMemory, void*& outMapped)
+	{
+		VkMemoryAllocateFlagsInfo flagsInfo{};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+		flagsInfo.pNext = pNext;
+		flagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = m_bBufferDeviceAddress ? &flagsInfo : pNext;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &outMemory) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to allocate {0} bytes of device memory!", size);
+			outMemory = VK_NULL_HANDLE;
+			return false;
+		}
+
+		m_DeviceMemoryCount++;
+
+		// Host visible memory stays mapped for its whole lifetime
+		outMapped = nullptr;
+
+		if (IsHostVisible(memoryTypeIndex) && vkMapMemory(m_Device, outMemory, 0, VK_WHOLE_SIZE, 0, &outMapped) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to map device memory!");
+			vkFreeMemory(m_Device, outMemory, nullptr);
+			m_DeviceMemoryCount--;
+			outMemory = VK_NULL_HANDLE;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool GPUAllocator::IsHostVisible(uint32_t memoryTypeIndex) const
+	{
+		return m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	}
+
+	uint32_t GPUAllocator::GetPoolIndex(uint32_t memoryTypeIndex, bool bLinear) const
+	{
+		if (m_BufferImageGranularity > 1)
+		{
+			return memoryTypeIndex * 2 + (bLinear ? 0 : 1);
+		}
+
+		return memoryTypeIndex;
+	}
+
+}
@@ -0,0 +1,129 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "TLSFAllocator.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+
+namespace Tempus {
+
+	enum class MemoryUsage
+	{
+		// Device local, not visible to the CPU. Render targets, vertex/index buffers, textures
+		GPUOnly,
+		// Host visible and coherent, persistently mapped. Staging and per-frame data
+		CPUToGPU,
+		// Host visible and cached where available, persistently mapped. Readback
+		GPUToCPU
+	};
+
+	struct GPUMemoryBlock;
+
+	struct GPUAllocation
+	{
+		VkDeviceMemory Memory = VK_NULL_HANDLE;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		// Non-null for host visible memory, already offset to the start of the allocation
+		void* MappedData = nullptr;
+
+		// Owning block, null for dedicated allocations
+		GPUMemoryBlock* Block = nullptr;
+		TLSFAllocator::Allocation SubAllocation;
+
+		bool IsValid() const { return Memory != VK_NULL_HANDLE; }
+	};
+
+	struct GPUAllocatorStats
+	{
+		uint32_t BlockCount = 0;
+		uint32_t DedicatedAllocationCount = 0;
+		uint32_t AllocationCount = 0;
+		// Total device memory obtained from vkAllocateMemory
+		VkDeviceSize BytesAllocated = 0;
+		VkDeviceSize BytesUsed = 0;
+		VkDeviceSize BytesFree = 0;
+		// 0 when all free memory of each block is one contiguous range, approaching 1 as it splinters
+		float Fragmentation = 0.0f;
+	};
+
+	// Sub-allocates buffers and images out of large per memory type blocks so the number of live
+	// vkAllocateMemory calls stays far below maxMemoryAllocationCount
+	class TEMPUS_API GPUAllocator
+	{
+	public:
+
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+		GPUAllocator() = default;
+		~GPUAllocator();
+
+		// bBufferDeviceAddress must match the bufferDeviceAddress device feature. All memory is then allocated with the
+		// device address flag, so any buffer may be created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE,
+			bool bBufferDeviceAddress = false);
+		void Shutdown();
+
+		// bLinear describes the resource tiling (buffers and linear images are linear) and is used to keep
+		// linear and optimal resources apart when the device has a bufferImageGranularity above 1
+		bool Allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, bool bLinear, GPUAllocation& outAllocation);
+		void Free(GPUAllocation& allocation);
+
+		// Dedicated allocations get their own VkDeviceMemory. Intended for large render targets
+		bool CreateBuffer(const VkBufferCreateInfo& createInfo, MemoryUsage usage, VkBuffer& outBuffer, GPUAllocation& outAllocation, bool bDedicated = false);
+		void DestroyBuffer(VkBuffer buffer, GPUAllocation& allocation);
+
+		bool CreateImage(const VkImageCreateInfo& createInfo, MemoryUsage usage, VkImage& outImage, GPUAllocation& outAllocation, bool bDedicated = false);
+		void DestroyImage(VkImage image, GPUAllocation& allocation);
+
+		GPUAllocatorStats GetStats() const;
+		void LogStats() const;
+
+		// Keeps liveCount device local allocations of random sizes alive and replaces a random one operationCount times,
+		// first through this allocator, then with a vkAllocateMemory and vkFreeMemory per allocation. Logs both timings
+		void RunBenchmark(uint32_t operationCount = 500000, uint32_t liveCount = 1024);
+
+	private:
+
+		struct MemoryPool
+		{
+			uint32_t MemoryTypeIndex = 0;
+			VkDeviceSize BlockSize = 0;
+			std::vector<std::unique_ptr<GPUMemoryBlock>> Blocks;
+		};
+
+		bool FindMemoryType(uint32_t typeBits, MemoryUsage usage, uint32_t& outTypeIndex) const;
+		bool AllocateFromPool(uint32_t poolIndex, const VkMemoryRequirements& requirements, GPUAllocation& outAllocation);
+		bool AllocateDedicated(uint32_t memoryTypeIndex, VkDeviceSize size, VkBuffer buffer, VkImage image, GPUAllocation& outAllocation);
+		bool AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, const void* pNext, VkDeviceMemory& outMemory, void*& outMapped);
+
+		bool IsHostVisible(uint32_t memoryTypeIndex) const;
+		uint32_t GetPoolIndex(uint32_t memoryTypeIndex, bool bLinear) const;
+
+	private:
+
+		VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
+		VkDevice m_Device = VK_NULL_HANDLE;
+
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+		VkDeviceSize m_BufferImageGranularity = 1;
+		VkDeviceSize m_PreferredBlockSize = DEFAULT_BLOCK_SIZE;
+		bool m_bBufferDeviceAddress = false;
+
+		// Indexed by GetPoolIndex(). Linear and optimal resources only use separate pools when granularity requires it
+		std::vector<MemoryPool> m_Pools;
+
+		uint32_t m_DedicatedAllocationCount = 0;
+		VkDeviceSize m_DedicatedBytes = 0;
+		uint32_t m_DeviceMemoryCount = 0;
+
+		mutable std::mutex m_Mutex;
+
+	};
+
+}
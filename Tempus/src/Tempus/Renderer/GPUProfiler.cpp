@@ -0,0 +1,200 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "GPUProfiler.h"
+
+#include "Log.h"
+
+namespace Tempus {
+
+	GPUProfiler::~GPUProfiler()
+	{
+		Shutdown();
+	}
+
+	bool GPUProfiler::Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight)
+	{
+		m_Device = device;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamily < queueFamilyCount ? queueFamilies[queueFamily].timestampValidBits : 0;
+
+		if (validBits == 0 || properties.limits.timestampPeriod <= 0.0f)
+		{
+			TPS_CORE_WARN("GPU timestamps are not supported, GPU profiling disabled");
+			return true;
+		}
+
+		m_TimestampPeriod = properties.limits.timestampPeriod;
+		m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = MAX_SCOPES * 2;
+
+		m_Frames.resize(framesInFlight);
+
+		for (FrameQueries& frame : m_Frames)
+		{
+			if (vkCreateQueryPool(m_Device, &poolInfo, nullptr, &frame.Pool) != VK_SUCCESS)
+			{
+				TPS_CORE_CRITICAL("Failed to create timestamp query pool!");
+				return false;
+			}
+
+			frame.Names.resize(MAX_SCOPES);
+		}
+
+		m_Results.resize(MAX_SCOPES * 2 * 2);
+		m_bSupported = true;
+
+		return true;
+	}
+
+	void GPUProfiler::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		for (FrameQueries& frame : m_Frames)
+		{
+			if (frame.Pool != VK_NULL_HANDLE)
+			{
+				vkDestroyQueryPool(m_Device, frame.Pool, nullptr);
+			}
+		}
+
+		m_Frames.clear();
+		m_CurrentFrame = nullptr;
+		m_bSupported = false;
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void GPUProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!m_bSupported)
+		{
+			return;
+		}
+
+		FrameQueries& frame = m_Frames[frameIndex];
+
+		if (frame.bSubmitted)
+		{
+			ResolveFrame(frame);
+		}
+
+		vkCmdResetQueryPool(commandBuffer, frame.Pool, 0, MAX_SCOPES * 2);
+
+		frame.ScopeCount = 0;
+		frame.bSubmitted = true;
+		m_CurrentFrame = &frame;
+	}
+
+	uint32_t GPUProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string& name)
+	{
+		if (m_CurrentFrame == nullptr || m_CurrentFrame->ScopeCount == MAX_SCOPES)
+		{
+			return INVALID_SCOPE;
+		}
+
+		uint32_t scope = m_CurrentFrame->ScopeCount++;
+		// Reuses the string's storage from earlier frames
+		m_CurrentFrame->Names[scope] = name;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_CurrentFrame->Pool, scope * 2);
+
+		return scope;
+	}
+
+	void GPUProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (m_CurrentFrame == nullptr || scope >= m_CurrentFrame->ScopeCount)
+		{
+			return;
+		}
+
+		// Written once all earlier commands, including the scope's own, have finished
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_CurrentFrame->Pool, scope * 2 + 1);
+	}
+
+	double GPUProfiler::GetAverageTime(const std::string& name) const
+	{
+		auto it = m_History.find(name);
+		if (it == m_History.end() || it->second.Count == 0)
+		{
+			return 0.0;
+		}
+
+		return it->second.Sum / it->second.Count;
+	}
+
+	void GPUProfiler::ResolveFrame(FrameQueries& frame)
+	{
+		if (frame.ScopeCount == 0)
+		{
+			return;
+		}
+
+		uint32_t queryCount = frame.ScopeCount * 2;
+
+		// No wait flag, the frame slot wait already guarantees completion. Availability guards against scopes that were
+		// begun but never ended
+		VkResult result = vkGetQueryPoolResults(m_Device, frame.Pool, 0, queryCount, queryCount * 2 * sizeof(uint64_t),
+			m_Results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+		{
+			return;
+		}
+
+		m_Timings.resize(frame.ScopeCount);
+		uint32_t timingCount = 0;
+
+		for (uint32_t scope = 0; scope < frame.ScopeCount; scope++)
+		{
+			const uint64_t* begin = &m_Results[scope * 4];
+			const uint64_t* end = &m_Results[scope * 4 + 2];
+
+			if (begin[1] == 0 || end[1] == 0)
+			{
+				continue;
+			}
+
+			// Masking keeps the difference correct across a counter wrap
+			uint64_t ticks = (end[0] - begin[0]) & m_TimestampMask;
+			double milliseconds = ticks * m_TimestampPeriod * 1e-6;
+
+			ScopeHistory& history = m_History[frame.Names[scope]];
+			if (history.Count == AVERAGE_WINDOW)
+			{
+				history.Sum -= history.Samples[history.Next];
+			}
+			else
+			{
+				history.Count++;
+			}
+
+			history.Samples[history.Next] = milliseconds;
+			history.Sum += milliseconds;
+			history.Next = (history.Next + 1) % AVERAGE_WINDOW;
+
+			GPUScopeTiming& timing = m_Timings[timingCount++];
+			timing.Name = frame.Names[scope];
+			timing.Milliseconds = milliseconds;
+			timing.AverageMilliseconds = history.Sum / history.Count;
+		}
+
+		m_Timings.resize(timingCount);
+	}
+
+}
@@ -0,0 +1,94 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+namespace Tempus {
+
+	struct GPUScopeTiming
+	{
+		std::string Name;
+		double Milliseconds = 0.0;
+		// Rolling average over the last GPUProfiler::AVERAGE_WINDOW frames the scope was recorded in
+		double AverageMilliseconds = 0.0;
+	};
+
+	// GPU timings from timestamp queries. Each frame in flight owns a query pool, and a slot's results are read once
+	// the frame has completed, so reading them back never stalls. Timings therefore lag the CPU by the frames in flight
+	class TEMPUS_API GPUProfiler
+	{
+	public:
+
+		static constexpr uint32_t MAX_SCOPES = 128;
+		static constexpr uint32_t AVERAGE_WINDOW = 120;
+		static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+		GPUProfiler() = default;
+		~GPUProfiler();
+
+		// Disables itself when the queue family doesn't support timestamps
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight);
+		void Shutdown();
+
+		// Resolves the timings of the slot's previous submission and resets its queries. The slot's previous submission
+		// must have completed and commandBuffer must be recording
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+		// Scopes may nest. Returns INVALID_SCOPE when profiling is unavailable or the frame ran out of scopes
+		uint32_t BeginScope(VkCommandBuffer commandBuffer, const std::string& name);
+		void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// Timings of the most recently resolved frame, in the order their scopes began
+		const std::vector<GPUScopeTiming>& GetTimings() const { return m_Timings; }
+		// 0 for scopes that haven't been resolved yet
+		double GetAverageTime(const std::string& name) const;
+
+		bool IsSupported() const { return m_bSupported; }
+
+	private:
+
+		struct FrameQueries
+		{
+			VkQueryPool Pool = VK_NULL_HANDLE;
+			// Scope names in begin order. Scope i owns queries 2i and 2i + 1
+			std::vector<std::string> Names;
+			uint32_t ScopeCount = 0;
+			bool bSubmitted = false;
+		};
+
+		struct ScopeHistory
+		{
+			double Samples[AVERAGE_WINDOW] = {};
+			double Sum = 0.0;
+			uint32_t Count = 0;
+			uint32_t Next = 0;
+		};
+
+		void ResolveFrame(FrameQueries& frame);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		bool m_bSupported = false;
+
+		// Nanoseconds per tick
+		double m_TimestampPeriod = 1.0;
+		uint64_t m_TimestampMask = ~0ull;
+
+		std::vector<FrameQueries> m_Frames;
+		FrameQueries* m_CurrentFrame = nullptr;
+
+		std::vector<GPUScopeTiming> m_Timings;
+		std::unordered_map<std::string, ScopeHistory> m_History;
+		// Query results with availability, two values per query
+		std::vector<uint64_t> m_Results;
+
+	};
+
+}
@@ -0,0 +1,538 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "GPUScene.h"
+
+#include "Log.h"
+#include "Shaders/EmbeddedShaders.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <iterator>
+
+namespace Tempus {
+
+	GPUScene::~GPUScene()
+	{
+		Shutdown();
+	}
+
+	bool GPUScene::Init(VkDevice device, GPUAllocator* allocator, UploadManager* uploads, PipelineStateCache* pipelineStates,
+		VkPipelineCache pipelineCache, uint32_t framesInFlight, const GPUSceneCapacity& capacity)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_Uploads = uploads;
+		m_Capacity = capacity;
+		m_PipelineStates = pipelineStates;
+		m_PipelineCache = pipelineCache;
+
+		VkBufferUsageFlags storageUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+			VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+		if (!CreateBuffer(static_cast<VkDeviceSize>(m_Capacity.MaxVertices) * sizeof(GPUVertex),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, m_VertexBuffer, m_VertexAllocation) ||
+			!CreateBuffer(static_cast<VkDeviceSize>(m_Capacity.MaxIndices) * sizeof(uint32_t),
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, m_IndexBuffer, m_IndexAllocation) ||
+			!CreateBuffer(static_cast<VkDeviceSize>(m_Capacity.MaxMeshes) * sizeof(GPUMeshInfo), storageUsage, m_MeshBuffer, m_MeshAllocation) ||
+			!CreateBuffer(static_cast<VkDeviceSize>(m_Capacity.MaxInstances) * sizeof(GPUInstance), storageUsage, m_InstanceBuffer, m_InstanceAllocation) ||
+			!CreateBuffer(DRAW_COMMANDS_OFFSET + static_cast<VkDeviceSize>(m_Capacity.MaxInstances) * sizeof(VkDrawIndexedIndirectCommand),
+				storageUsage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, m_DrawBuffer, m_DrawAllocation))
+		{
+			TPS_CORE_CRITICAL("Failed to create GPU scene buffers!");
+			return false;
+		}
+
+		m_MeshAddress = GetBufferAddress(m_MeshBuffer);
+		m_InstanceAddress = GetBufferAddress(m_InstanceBuffer);
+		m_DrawAddress = GetBufferAddress(m_DrawBuffer);
+
+		m_InstanceStaging.resize(framesInFlight);
+
+		if (!CreatePipelines())
+		{
+			return false;
+		}
+
+		// Identity until the application provides a camera
+		for (int i = 0; i < 16; i++)
+		{
+			m_ViewProjection[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+		}
+
+		TPS_CORE_INFO("GPU scene initialized ({0} instances, {1} meshes max)", m_Capacity.MaxInstances, m_Capacity.MaxMeshes);
+
+		return true;
+	}
+
+	void GPUScene::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkDestroyPipeline(m_Device, m_CullPipeline, nullptr);
+		m_CullLayout.Destroy(m_Device);
+
+		for (InstanceStaging& staging : m_InstanceStaging)
+		{
+			if (staging.Buffer != VK_NULL_HANDLE)
+			{
+				m_Allocator->DestroyBuffer(staging.Buffer, staging.Allocation);
+			}
+		}
+
+		m_InstanceStaging.clear();
+
+		VkBuffer* buffers[] = { &m_VertexBuffer, &m_IndexBuffer, &m_MeshBuffer, &m_InstanceBuffer, &m_DrawBuffer };
+		GPUAllocation* allocations[] = { &m_VertexAllocation, &m_IndexAllocation, &m_MeshAllocation, &m_InstanceAllocation, &m_DrawAllocation };
+
+		for (size_t i = 0; i < std::size(buffers); i++)
+		{
+			if (*buffers[i] != VK_NULL_HANDLE)
+			{
+				m_Uploads->Forget(*buffers[i]);
+				m_Allocator->DestroyBuffer(*buffers[i], *allocations[i]);
+				*buffers[i] = VK_NULL_HANDLE;
+			}
+		}
+
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	uint32_t GPUScene::AddMesh(const GPUVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount)
+	{
+		if (vertexCount == 0 || indexCount == 0)
+		{
+			return INVALID_INDEX;
+		}
+
+		if (m_VertexCount + vertexCount > m_Capacity.MaxVertices || m_IndexCount + indexCount > m_Capacity.MaxIndices ||
+			m_Meshes.size() >= m_Capacity.MaxMeshes)
+		{
+			TPS_CORE_ERROR("GPU scene is out of mesh storage!");
+			return INVALID_INDEX;
+		}
+
+		// Bounding sphere around the centre of the bounding box. Not minimal, but cheap and good enough for culling
+		float minBounds[3] = { vertices[0].Position[0], vertices[0].Position[1], vertices[0].Position[2] };
+		float maxBounds[3] = { minBounds[0], minBounds[1], minBounds[2] };
+
+		for (uint32_t i = 1; i < vertexCount; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				minBounds[axis] = std::min(minBounds[axis], vertices[i].Position[axis]);
+				maxBounds[axis] = std::max(maxBounds[axis], vertices[i].Position[axis]);
+			}
+		}
+
+		GPUMeshInfo mesh;
+		mesh.FirstIndex = m_IndexCount;
+		mesh.IndexCount = indexCount;
+		mesh.VertexOffset = static_cast<int32_t>(m_VertexCount);
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			mesh.Center[axis] = (minBounds[axis] + maxBounds[axis]) * 0.5f;
+		}
+
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			float dx = vertices[i].Position[0] - mesh.Center[0];
+			float dy = vertices[i].Position[1] - mesh.Center[1];
+			float dz = vertices[i].Position[2] - mesh.Center[2];
+			mesh.Radius = std::max(mesh.Radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+		}
+
+		uint32_t meshIndex = static_cast<uint32_t>(m_Meshes.size());
+
+		// Mesh storage is append only, so uploads never touch memory a frame in flight reads
+		if (m_Uploads->UploadBuffer(m_VertexBuffer, m_VertexCount * sizeof(GPUVertex), vertices, vertexCount * sizeof(GPUVertex)) == 0 ||
+			m_Uploads->UploadBuffer(m_IndexBuffer, m_IndexCount * sizeof(uint32_t), indices, indexCount * sizeof(uint32_t)) == 0 ||
+			m_Uploads->UploadBuffer(m_MeshBuffer, meshIndex * sizeof(GPUMeshInfo), &mesh, sizeof(GPUMeshInfo)) == 0)
+		{
+			TPS_CORE_ERROR("Failed to upload mesh!");
+			return INVALID_INDEX;
+		}
+
+		m_VertexCount += vertexCount;
+		m_IndexCount += indexCount;
+		m_Meshes.push_back(mesh);
+
+		return meshIndex;
+	}
+
+	uint32_t GPUScene::AddInstance(const GPUInstance& instance)
+	{
+		if (m_Instances.size() >= m_Capacity.MaxInstances)
+		{
+			TPS_CORE_ERROR("GPU scene is out of instance storage!");
+			return INVALID_INDEX;
+		}
+
+		uint32_t index = static_cast<uint32_t>(m_Instances.size());
+		m_Instances.push_back(instance);
+
+		m_DirtyBegin = std::min(m_DirtyBegin, index);
+		m_DirtyEnd = std::max(m_DirtyEnd, index + 1);
+
+		return index;
+	}
+
+	void GPUScene::UpdateInstance(uint32_t index, const GPUInstance& instance)
+	{
+		if (index >= m_Instances.size())
+		{
+			return;
+		}
+
+		m_Instances[index] = instance;
+
+		m_DirtyBegin = std::min(m_DirtyBegin, index);
+		m_DirtyEnd = std::max(m_DirtyEnd, index + 1);
+	}
+
+	void GPUScene::ClearInstances()
+	{
+		m_Instances.clear();
+		m_DirtyBegin = UINT32_MAX;
+		m_DirtyEnd = 0;
+	}
+
+	void GPUScene::SetViewProjection(const float viewProjection[16])
+	{
+		std::memcpy(m_ViewProjection, viewProjection, sizeof(m_ViewProjection));
+	}
+
+	void GPUScene::BeginFrame(uint32_t frameIndex)
+	{
+		m_FrameIndex = frameIndex;
+		m_PendingInstanceCopy = {};
+
+		if (m_DirtyBegin >= m_DirtyEnd)
+		{
+			return;
+		}
+
+		VkDeviceSize size = static_cast<VkDeviceSize>(m_DirtyEnd - m_DirtyBegin) * sizeof(GPUInstance);
+		InstanceStaging& staging = m_InstanceStaging[m_FrameIndex];
+
+		// The slot's last submission has completed, so its staging buffer can be replaced
+		if (staging.Capacity < size)
+		{
+			if (staging.Buffer != VK_NULL_HANDLE)
+			{
+				m_Allocator->DestroyBuffer(staging.Buffer, staging.Allocation);
+			}
+
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = std::max(size, staging.Capacity * 2);
+			bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (!m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::CPUToGPU, staging.Buffer, staging.Allocation))
+			{
+				TPS_CORE_ERROR("Failed to create instance staging buffer!");
+				staging.Buffer = VK_NULL_HANDLE;
+				staging.Capacity = 0;
+				return;
+			}
+
+			staging.Capacity = bufferInfo.size;
+		}
+
+		std::memcpy(staging.Allocation.MappedData, m_Instances.data() + m_DirtyBegin, size);
+
+		m_PendingInstanceCopy.srcOffset = 0;
+		m_PendingInstanceCopy.dstOffset = static_cast<VkDeviceSize>(m_DirtyBegin) * sizeof(GPUInstance);
+		m_PendingInstanceCopy.size = size;
+
+		m_DirtyBegin = UINT32_MAX;
+		m_DirtyEnd = 0;
+	}
+
+	void GPUScene::AddPasses(RenderGraph& graph, RGHandle colorTarget, VkFormat colorFormat, VkExtent2D extent)
+	{
+		if (m_Instances.empty())
+		{
+			return;
+		}
+
+		// Both buffers are reused every frame, so their first write waits for the previous frame's readers
+		RGHandle instances = graph.ImportBuffer("Instances", m_InstanceBuffer, m_InstanceAllocation.Size, false,
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+		RGHandle draws = graph.ImportBuffer("DrawCommands", m_DrawBuffer, m_DrawAllocation.Size, false,
+			VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+		if (m_PendingInstanceCopy.size > 0)
+		{
+			graph.AddPass("InstanceUpload", [this](VkCommandBuffer commandBuffer) { RecordInstanceUpload(commandBuffer); })
+				.Write(instances, RGUsage::TransferDst);
+		}
+
+		graph.AddPass("ResetDrawCount", [this](VkCommandBuffer commandBuffer)
+			{
+				vkCmdFillBuffer(commandBuffer, m_DrawBuffer, 0, DRAW_COMMANDS_OFFSET, 0);
+			})
+			.Write(draws, RGUsage::TransferDst);
+
+		graph.AddPass("Cull", [this](VkCommandBuffer commandBuffer) { RecordCulling(commandBuffer); })
+			.Read(instances, RGUsage::StorageRead)
+			.Write(draws, RGUsage::StorageWrite);
+
+		RGTextureDesc depthDesc;
+		depthDesc.Width = extent.width;
+		depthDesc.Height = extent.height;
+		depthDesc.Format = VK_FORMAT_D32_SFLOAT;
+		RGHandle depth = graph.CreateTexture("SceneDepth", depthDesc);
+
+		// Counter clockwise front faces, assuming a projection that flips Y into Vulkan's downward clip space
+		PipelineKey key;
+		key.Program = m_DrawProgram;
+		key.ColorFormat = colorFormat;
+		key.DepthFormat = depthDesc.Format;
+		key.CullMode = VK_CULL_MODE_BACK_BIT;
+		key.FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		key.bDepthTest = true;
+		key.bDepthWrite = true;
+		key.DepthCompare = VK_COMPARE_OP_LESS;
+
+		graph.AddPass("Scene", [this, key, extent](VkCommandBuffer commandBuffer) { RecordDraws(commandBuffer, key, extent); })
+			.AddColorAttachment(colorTarget, VK_ATTACHMENT_LOAD_OP_LOAD)
+			.SetDepthAttachment(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, 1.0f)
+			.Read(draws, RGUsage::IndirectRead)
+			.Read(instances, RGUsage::StorageRead);
+	}
+
+	void GPUScene::RecordInstanceUpload(VkCommandBuffer commandBuffer)
+	{
+		vkCmdCopyBuffer(commandBuffer, m_InstanceStaging[m_FrameIndex].Buffer, m_InstanceBuffer, 1, &m_PendingInstanceCopy);
+	}
+
+	void GPUScene::RecordCulling(VkCommandBuffer commandBuffer)
+	{
+		CullPushConstants pushConstants{};
+		ExtractFrustumPlanes(pushConstants.FrustumPlanes);
+		pushConstants.Instances = m_InstanceAddress;
+		pushConstants.Meshes = m_MeshAddress;
+		pushConstants.Draws = m_DrawAddress;
+		pushConstants.InstanceCount = static_cast<uint32_t>(m_Instances.size());
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullPipeline);
+		vkCmdPushConstants(commandBuffer, m_CullLayout.Layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pushConstants);
+
+		// 64 matches local_size_x of cull.comp
+		vkCmdDispatch(commandBuffer, (pushConstants.InstanceCount + 63) / 64, 1, 1);
+	}
+
+	void GPUScene::RecordDraws(VkCommandBuffer commandBuffer, const PipelineKey& key, VkExtent2D extent)
+	{
+		// Skipped rather than drawn without a pipeline when the format's pipeline failed to build
+		if (m_PipelineStates->GetPipeline(key) == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		m_PipelineStates->Bind(commandBuffer, key);
+
+		VkViewport viewport{};
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkDeviceSize vertexOffset = 0;
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_VertexBuffer, &vertexOffset);
+		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+		DrawPushConstants pushConstants{};
+		std::memcpy(pushConstants.ViewProjection, m_ViewProjection, sizeof(m_ViewProjection));
+		pushConstants.Instances = m_InstanceAddress;
+
+		vkCmdPushConstants(commandBuffer, m_PipelineStates->GetLayout(m_DrawProgram), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawPushConstants), &pushConstants);
+
+		// One draw per pipeline. The count written by the culling pass decides how many commands execute
+		vkCmdDrawIndexedIndirectCount(commandBuffer, m_DrawBuffer, DRAW_COMMANDS_OFFSET, m_DrawBuffer, 0,
+			static_cast<uint32_t>(m_Instances.size()), sizeof(VkDrawIndexedIndirectCommand));
+	}
+
+	void GPUScene::ExtractFrustumPlanes(float outPlanes[6][4]) const
+	{
+		// Gribb/Hartmann. Rows of the column major matrix combine into the clip planes, near is row 2 alone
+		// because Vulkan clip space depth starts at 0
+		auto row = [this](int r, int c) { return m_ViewProjection[c * 4 + r]; };
+
+		for (int c = 0; c < 4; c++)
+		{
+			outPlanes[0][c] = row(3, c) + row(0, c);
+			outPlanes[1][c] = row(3, c) - row(0, c);
+			outPlanes[2][c] = row(3, c) + row(1, c);
+			outPlanes[3][c] = row(3, c) - row(1, c);
+			outPlanes[4][c] = row(2, c);
+			outPlanes[5][c] = row(3, c) - row(2, c);
+		}
+
+		for (int i = 0; i < 6; i++)
+		{
+			float length = std::sqrt(outPlanes[i][0] * outPlanes[i][0] + outPlanes[i][1] * outPlanes[i][1] + outPlanes[i][2] * outPlanes[i][2]);
+
+			if (length > 0.0f)
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					outPlanes[i][c] /= length;
+				}
+			}
+		}
+	}
+
+	bool GPUScene::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& outBuffer, GPUAllocation& outAllocation)
+	{
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		return m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::GPUOnly, outBuffer, outAllocation);
+	}
+
+	VkDeviceAddress GPUScene::GetBufferAddress(VkBuffer buffer) const
+	{
+		VkBufferDeviceAddressInfo addressInfo{};
+		addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+		addressInfo.buffer = buffer;
+
+		return vkGetBufferDeviceAddress(m_Device, &addressInfo);
+	}
+
+	VkShaderModule GPUScene::CreateShaderModule(ShaderCode code) const
+	{
+		if (!code.IsValid())
+		{
+			TPS_CORE_ERROR("Shader code is not a valid SPIR-V binary!");
+			return VK_NULL_HANDLE;
+		}
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = code.GetSize();
+		createInfo.pCode = code.Words;
+
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+
+		if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to create shader module!");
+		}
+
+		return shaderModule;
+	}
+
+	bool GPUScene::CreatePipelines()
+	{
+		ShaderCode cullCode = MakeShaderCode(EmbeddedShaders::CullComp);
+		ShaderCode vertCode = MakeShaderCode(EmbeddedShaders::SceneVert);
+		ShaderCode fragCode = MakeShaderCode(EmbeddedShaders::SceneFrag);
+
+		ShaderReflection cullReflection;
+		ShaderReflection vertReflection;
+
+		if (!cullReflection.Reflect(cullCode) || !vertReflection.Reflect(vertCode))
+		{
+			TPS_CORE_CRITICAL("Failed to reflect GPU scene shaders!");
+			return false;
+		}
+
+		// Culling
+		if (!ShaderReflection::CreatePipelineLayout(m_Device, { &cullReflection }, m_CullLayout))
+		{
+			TPS_CORE_CRITICAL("Failed to create culling pipeline layout!");
+			return false;
+		}
+
+		// The push constant structs mirror the GLSL blocks by hand, the reflected sizes catch them drifting apart
+		if (m_CullLayout.PushConstantSize != sizeof(CullPushConstants))
+		{
+			TPS_CORE_CRITICAL("cull.comp push constants are {0} bytes, CullPushConstants is {1}", m_CullLayout.PushConstantSize, sizeof(CullPushConstants));
+			return false;
+		}
+
+		m_CullPipeline = BuildCullPipeline(cullCode);
+		if (m_CullPipeline == VK_NULL_HANDLE)
+		{
+			TPS_CORE_CRITICAL("Failed to create culling pipeline!");
+			return false;
+		}
+
+		// Drawing
+		if (vertReflection.GetPushConstantSize() != sizeof(DrawPushConstants))
+		{
+			TPS_CORE_CRITICAL("scene.vert push constants are {0} bytes, DrawPushConstants is {1}", vertReflection.GetPushConstantSize(), sizeof(DrawPushConstants));
+			return false;
+		}
+
+		ReflectedVertexLayout vertexLayout;
+		vertReflection.GetVertexLayout(vertexLayout);
+
+		if (vertexLayout.Binding.stride != sizeof(GPUVertex))
+		{
+			TPS_CORE_CRITICAL("scene.vert inputs are {0} bytes per vertex, GPUVertex is {1}", vertexLayout.Binding.stride, sizeof(GPUVertex));
+			return false;
+		}
+
+		// Pipelines are created per colour format on first use, see AddPasses()
+		m_DrawProgram = m_PipelineStates->RegisterProgram("Scene", vertCode, fragCode);
+		if (m_DrawProgram == PipelineStateCache::INVALID_PROGRAM)
+		{
+			TPS_CORE_CRITICAL("Failed to create scene program!");
+			return false;
+		}
+
+		return true;
+	}
+
+	void GPUScene::RegisterPipelines(PipelineReloader& reloader)
+	{
+		reloader.Register("SceneCull", { { "Tempus/res/shaders/cull.comp", "bin/shaders/cull_comp.spv" } },
+			[this](const std::vector<ShaderCode>& code) { return BuildCullPipeline(code[0]); }, &m_CullPipeline);
+
+		reloader.RegisterReload("SceneDraw", {
+				{ "Tempus/res/shaders/scene.vert", "bin/shaders/scene_vert.spv" },
+				{ "Tempus/res/shaders/scene.frag", "bin/shaders/scene_frag.spv" }
+			},
+			[this](const std::vector<ShaderCode>& code) { return m_PipelineStates->ReloadProgram(m_DrawProgram, code[0], code[1]); });
+	}
+
+	VkPipeline GPUScene::BuildCullPipeline(ShaderCode cullCode) const
+	{
+		VkShaderModule cullShader = CreateShaderModule(cullCode);
+		if (cullShader == VK_NULL_HANDLE)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		VkComputePipelineCreateInfo cullPipelineInfo{};
+		cullPipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		cullPipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		cullPipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		cullPipelineInfo.stage.module = cullShader;
+		cullPipelineInfo.stage.pName = "main";
+		cullPipelineInfo.layout = m_CullLayout.Layout;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult result = vkCreateComputePipelines(m_Device, m_PipelineCache, 1, &cullPipelineInfo, nullptr, &pipeline);
+		vkDestroyShaderModule(m_Device, cullShader, nullptr);
+
+		return result == VK_SUCCESS ? pipeline : VK_NULL_HANDLE;
+	}
+
+}
@@ -0,0 +1,178 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+#include "UploadManager.h"
+#include "RenderGraph.h"
+#include "PipelineReloader.h"
+#include "PipelineStateCache.h"
+#include "ShaderReflection.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+
+namespace Tempus {
+
+	struct GPUVertex
+	{
+		float Position[3];
+		float Normal[3];
+	};
+
+	// Matches the std430 Instance struct of cull.comp and scene.vert
+	struct GPUInstance
+	{
+		float Position[3] = { 0.0f, 0.0f, 0.0f };
+		float Scale = 1.0f;
+		float Colour[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		uint32_t Mesh = 0;
+		uint32_t Padding[3] = { 0, 0, 0 };
+	};
+
+	struct GPUSceneCapacity
+	{
+		uint32_t MaxVertices = 1u << 20;
+		uint32_t MaxIndices = 1u << 22;
+		uint32_t MaxMeshes = 1024;
+		uint32_t MaxInstances = 1u << 20;
+	};
+
+	// GPU driven geometry. Every mesh lives in one shared vertex and index buffer and every instance in one storage
+	// buffer. Each frame a compute pass frustum culls all instances and appends a VkDrawIndexedIndirectCommand per
+	// visible instance, which a single vkCmdDrawIndexedIndirectCount then draws. The CPU cost of a frame doesn't
+	// depend on the instance count, only instance edits are uploaded
+	class TEMPUS_API GPUScene
+	{
+	public:
+
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		GPUScene() = default;
+		~GPUScene();
+
+		// The drawing pipeline lives in pipelineStates, which has to outlive the scene. pipelineCache backs the culling pipeline
+		bool Init(VkDevice device, GPUAllocator* allocator, UploadManager* uploads, PipelineStateCache* pipelineStates,
+			VkPipelineCache pipelineCache, uint32_t framesInFlight, const GPUSceneCapacity& capacity = GPUSceneCapacity());
+		void Shutdown();
+
+		// Returns the mesh index, or INVALID_INDEX when the shared buffers are full
+		uint32_t AddMesh(const GPUVertex* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+		uint32_t AddInstance(const GPUInstance& instance);
+		void UpdateInstance(uint32_t index, const GPUInstance& instance);
+		void ClearInstances();
+		uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_Instances.size()); }
+
+		// Column major, clip space with Vulkan's [0, 1] depth range
+		void SetViewProjection(const float viewProjection[16]);
+
+		// The frame slot's previous submission must have completed
+		void BeginFrame(uint32_t frameIndex);
+
+		// Adds the instance upload, culling and drawing passes. Draws on top of colorTarget with its own depth buffer. The
+		// drawing pipeline is looked up by colorFormat, so a swap chain recreated with another format gets its own
+		void AddPasses(RenderGraph& graph, RGHandle colorTarget, VkFormat colorFormat, VkExtent2D extent);
+
+		// Registers the culling pipeline and drawing program for shader hot reload
+		void RegisterPipelines(PipelineReloader& reloader);
+
+	private:
+
+		// Matches MeshInfo of cull.comp
+		struct GPUMeshInfo
+		{
+			uint32_t FirstIndex = 0;
+			uint32_t IndexCount = 0;
+			int32_t VertexOffset = 0;
+			float Radius = 0.0f;
+			float Center[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		};
+
+		struct CullPushConstants
+		{
+			float FrustumPlanes[6][4];
+			VkDeviceAddress Instances;
+			VkDeviceAddress Meshes;
+			VkDeviceAddress Draws;
+			uint32_t InstanceCount;
+		};
+
+		struct DrawPushConstants
+		{
+			float ViewProjection[16];
+			VkDeviceAddress Instances;
+		};
+
+		// Per frame staging for instance edits, copied into the instance buffer on the graphics queue
+		struct InstanceStaging
+		{
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			GPUAllocation Allocation;
+			VkDeviceSize Capacity = 0;
+		};
+
+		// Offset of the first VkDrawIndexedIndirectCommand, the draw count sits in front of it
+		static constexpr VkDeviceSize DRAW_COMMANDS_OFFSET = 16;
+
+		bool CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& outBuffer, GPUAllocation& outAllocation);
+		// Creates the culling layout and pipeline and registers the drawing program from the embedded shaders. The Build
+		// function only reads state that is fixed after Init, so the pipeline reloader can call it from its watcher thread
+		bool CreatePipelines();
+		VkPipeline BuildCullPipeline(ShaderCode cullCode) const;
+		// Returns VK_NULL_HANDLE when the code isn't valid SPIR-V
+		VkShaderModule CreateShaderModule(ShaderCode code) const;
+		VkDeviceAddress GetBufferAddress(VkBuffer buffer) const;
+		void ExtractFrustumPlanes(float outPlanes[6][4]) const;
+
+		void RecordInstanceUpload(VkCommandBuffer commandBuffer);
+		void RecordCulling(VkCommandBuffer commandBuffer);
+		void RecordDraws(VkCommandBuffer commandBuffer, const PipelineKey& key, VkExtent2D extent);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+		UploadManager* m_Uploads = nullptr;
+		GPUSceneCapacity m_Capacity;
+
+		VkBuffer m_VertexBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_VertexAllocation;
+		VkBuffer m_IndexBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_IndexAllocation;
+		VkBuffer m_MeshBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_MeshAllocation;
+		VkBuffer m_InstanceBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_InstanceAllocation;
+		VkBuffer m_DrawBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_DrawAllocation;
+
+		VkDeviceAddress m_InstanceAddress = 0;
+		VkDeviceAddress m_MeshAddress = 0;
+		VkDeviceAddress m_DrawAddress = 0;
+
+		uint32_t m_VertexCount = 0;
+		uint32_t m_IndexCount = 0;
+		std::vector<GPUMeshInfo> m_Meshes;
+
+		std::vector<GPUInstance> m_Instances;
+		// Range of instances edited since the last upload
+		uint32_t m_DirtyBegin = UINT32_MAX;
+		uint32_t m_DirtyEnd = 0;
+
+		std::vector<InstanceStaging> m_InstanceStaging;
+		uint32_t m_FrameIndex = 0;
+		VkBufferCopy m_PendingInstanceCopy{};
+
+		float m_ViewProjection[16] = {};
+
+		PipelineStateCache* m_PipelineStates = nullptr;
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+		ReflectedPipelineLayout m_CullLayout;
+		VkPipeline m_CullPipeline = VK_NULL_HANDLE;
+		uint32_t m_DrawProgram = PipelineStateCache::INVALID_PROGRAM;
+
+	};
+
+}
@@ -0,0 +1,334 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "PipelineReloader.h"
+
+#include "Log.h"
+#include "Utils/FileUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace Tempus {
+
+	PipelineReloader::~PipelineReloader()
+	{
+		Shutdown();
+	}
+
+	bool PipelineReloader::Init(VkDevice device, DeletionQueue* deletionQueue)
+	{
+		m_Device = device;
+		m_DeletionQueue = deletionQueue;
+		m_bStopping = false;
+		m_Watcher = std::thread(&PipelineReloader::WatcherLoop, this);
+
+		TPS_CORE_INFO("Shader hot reload enabled, polling every {0} ms", POLL_INTERVAL_MS);
+		return true;
+	}
+
+	void PipelineReloader::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_bStopping = true;
+		}
+
+		m_StopCondition.notify_all();
+
+		if (m_Watcher.joinable())
+		{
+			m_Watcher.join();
+		}
+
+		// Never swapped in, so no frame has used them
+		for (const ReadyPipeline& ready : m_Ready)
+		{
+			vkDestroyPipeline(m_Device, ready.Pipeline, nullptr);
+		}
+
+		m_Ready.clear();
+		m_Registrations.clear();
+		m_Shaders.clear();
+		m_Entries.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void PipelineReloader::Register(const char* name, const std::vector<ShaderSource>& shaders, BuildFunc build, VkPipeline* pipeline)
+	{
+		PendingRegistration registration;
+		registration.Pipeline.Name = name;
+		registration.Pipeline.Build = std::move(build);
+		registration.Pipeline.Target = pipeline;
+		registration.Shaders = shaders;
+
+		// Adopted by the watcher on its next poll, so the watched lists never need locking
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Registrations.push_back(std::move(registration));
+	}
+
+	void PipelineReloader::RegisterReload(const char* name, const std::vector<ShaderSource>& shaders, ReloadFunc reload)
+	{
+		PendingRegistration registration;
+		registration.Pipeline.Name = name;
+		registration.Pipeline.Reload = std::move(reload);
+		registration.Shaders = shaders;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Registrations.push_back(std::move(registration));
+	}
+
+	void PipelineReloader::Update()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Swapping.swap(m_Ready);
+		}
+
+		for (const ReadyPipeline& ready : m_Swapping)
+		{
+			// Every frame recorded so far may have used the old pipeline
+			if (*ready.Target != VK_NULL_HANDLE)
+			{
+				m_DeletionQueue->DestroyPipeline(*ready.Target);
+			}
+
+			*ready.Target = ready.Pipeline;
+			TPS_CORE_INFO("Reloaded pipeline {0}", ready.Name);
+		}
+
+		m_Swapping.clear();
+	}
+
+	void PipelineReloader::WatcherLoop()
+	{
+		std::vector<PendingRegistration> registrations;
+
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_StopCondition.wait_for(lock, std::chrono::milliseconds(POLL_INTERVAL_MS), [this]() { return m_bStopping; });
+
+				if (m_bStopping)
+				{
+					return;
+				}
+
+				registrations.swap(m_Registrations);
+			}
+
+			for (PendingRegistration& registration : registrations)
+			{
+				AdoptRegistration(registration);
+			}
+
+			registrations.clear();
+
+			// Compiles and pipeline builds run unlocked, so Update() never waits on them
+			Poll();
+		}
+	}
+
+	void PipelineReloader::AdoptRegistration(PendingRegistration& registration)
+	{
+		Entry& entry = m_Entries.emplace_back(std::move(registration.Pipeline));
+
+		for (const ShaderSource& source : registration.Shaders)
+		{
+			auto it = std::find_if(m_Shaders.begin(), m_Shaders.end(), [&source](const WatchedShader& shader)
+			{
+				return shader.Paths.Binary == source.Binary;
+			});
+
+			if (it == m_Shaders.end())
+			{
+				WatchedShader shader;
+				shader.Paths = source;
+				// Starts from the current write times, so nothing is rebuilt until a file is actually edited
+				HasChanged(shader.Paths.Source, shader.SourceWrite);
+				HasChanged(shader.Paths.Binary, shader.BinaryWrite);
+
+				m_Shaders.push_back(shader);
+				it = m_Shaders.end() - 1;
+			}
+
+			entry.Shaders.push_back(static_cast<uint32_t>(it - m_Shaders.begin()));
+		}
+	}
+
+	void PipelineReloader::Poll()
+	{
+		std::vector<bool> changed(m_Shaders.size(), false);
+		std::vector<std::vector<uint32_t>> binaries;
+		std::vector<ShaderCode> code;
+
+		for (size_t i = 0; i < m_Shaders.size(); i++)
+		{
+			WatchedShader& shader = m_Shaders[i];
+
+			if (!shader.Paths.Source.empty() && HasChanged(shader.Paths.Source, shader.SourceWrite))
+			{
+				TPS_CORE_INFO("Shader source {0} changed, recompiling", shader.Paths.Source);
+				CompileShader(shader.Paths);
+			}
+
+			if (HasChanged(shader.Paths.Binary, shader.BinaryWrite))
+			{
+				shader.bDirty = true;
+			}
+			else if (shader.bDirty)
+			{
+				changed[i] = true;
+				shader.bDirty = false;
+			}
+		}
+
+		for (const Entry& entry : m_Entries)
+		{
+			bool bAffected = std::any_of(entry.Shaders.begin(), entry.Shaders.end(), [&changed](uint32_t shader) { return changed[shader]; });
+			if (!bAffected)
+			{
+				continue;
+			}
+
+			binaries.resize(entry.Shaders.size());
+			code.clear();
+
+			bool bLoaded = true;
+			for (size_t i = 0; i < entry.Shaders.size() && bLoaded; i++)
+			{
+				bLoaded = LoadBinary(m_Shaders[entry.Shaders[i]].Paths.Binary, binaries[i]);
+				code.push_back({ binaries[i].data(), binaries[i].size() });
+			}
+
+			if (!bLoaded)
+			{
+				continue;
+			}
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			bool bReloaded = false;
+
+			try
+			{
+				if (entry.Reload)
+				{
+					bReloaded = entry.Reload(code);
+				}
+				else
+				{
+					pipeline = entry.Build(code);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				TPS_CORE_ERROR("Failed to rebuild pipeline {0}: {1}", entry.Name, e.what());
+				continue;
+			}
+
+			if (entry.Reload)
+			{
+				if (bReloaded)
+				{
+					TPS_CORE_INFO("Reloaded shader program {0}", entry.Name);
+				}
+				else
+				{
+					TPS_CORE_ERROR("Failed to reload shader program {0}, keeping the previous one", entry.Name);
+				}
+
+				continue;
+			}
+
+			if (pipeline == VK_NULL_HANDLE)
+			{
+				TPS_CORE_ERROR("Failed to rebuild pipeline {0}, keeping the previous one", entry.Name);
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Ready.push_back({ entry.Name, entry.Target, pipeline });
+		}
+	}
+
+	bool PipelineReloader::HasChanged(const std::string& path, std::filesystem::file_time_type& lastWrite)
+	{
+		std::error_code error;
+		std::filesystem::file_time_type write = std::filesystem::last_write_time(path, error);
+
+		// Editors often delete and recreate a file on save, a missing file is picked up once it is back
+		if (error || write == lastWrite)
+		{
+			return false;
+		}
+
+		lastWrite = write;
+		return true;
+	}
+
+	bool PipelineReloader::LoadBinary(const std::string& path, std::vector<uint32_t>& outWords)
+	{
+		std::vector<char> bytes;
+
+		try
+		{
+			bytes = FileUtils::ReadFile(path);
+		}
+		catch (const std::exception& e)
+		{
+			TPS_CORE_ERROR("Failed to read {0}: {1}", path, e.what());
+			return false;
+		}
+
+		outWords.resize(bytes.size() / sizeof(uint32_t));
+		std::memcpy(outWords.data(), bytes.data(), outWords.size() * sizeof(uint32_t));
+
+		ShaderCode code{ outWords.data(), outWords.size() };
+		if (bytes.size() % sizeof(uint32_t) != 0 || !code.IsValid())
+		{
+			TPS_CORE_ERROR("{0} is not a valid SPIR-V binary", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool PipelineReloader::CompileShader(const ShaderSource& shader)
+	{
+		const char* sdk = std::getenv("VULKAN_SDK");
+		if (sdk == nullptr)
+		{
+			TPS_CORE_WARN("VULKAN_SDK is not set, can't recompile {0}", shader.Source);
+			return false;
+		}
+
+#ifdef TPS_PLATFORM_WINDOWS
+		std::string compiler = std::string(sdk) + "\\Bin\\glslc.exe";
+#else
+		std::string compiler = std::string(sdk) + "/bin/glslc";
+#endif
+
+		std::string command = "\"" + compiler + "\" --target-env=vulkan1.3 \"" + shader.Source + "\" -o \"" + shader.Binary + "\"";
+
+#ifdef TPS_PLATFORM_WINDOWS
+		// cmd strips the outer quotes, keeping the quoted compiler path intact
+		command = "\"" + command + "\"";
+#endif
+
+		if (std::system(command.c_str()) != 0)
+		{
+			TPS_CORE_ERROR("Failed to compile {0}", shader.Source);
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,126 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "ShaderReflection.h"
+#include "DeletionQueue.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <string>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Tempus {
+
+	// GLSL source and the SPIR-V it compiles to, relative to the project root working directory
+	struct ShaderSource
+	{
+		std::string Source;
+		std::string Binary;
+	};
+
+	// Shader hot reload. A watcher thread polls the registered GLSL sources and SPIR-V binaries. Edited sources are
+	// recompiled with glslc, and every pipeline using a changed binary is rebuilt on the watcher thread. Rebuilt
+	// pipelines are swapped in by Update() at a frame boundary, and the pipelines they replace go to the deletion queue
+	// until no frame in flight can still reference them. The render thread never waits on a compile.
+	// Pipeline layouts are not rebuilt, so shader edits must keep their resource interface
+	class TEMPUS_API PipelineReloader
+	{
+	public:
+
+		static constexpr uint32_t POLL_INTERVAL_MS = 250;
+
+		// Receives the reloaded SPIR-V in registration order and returns VK_NULL_HANDLE on failure. Runs on the watcher
+		// thread, so it may only read state that stays constant
+		using BuildFunc = std::function<VkPipeline(const std::vector<ShaderCode>& shaders)>;
+		// Like BuildFunc, for owners that swap in and retire their own pipelines. Returns false on failure
+		using ReloadFunc = std::function<bool(const std::vector<ShaderCode>& shaders)>;
+
+		PipelineReloader() = default;
+		~PipelineReloader();
+
+		// Replaced pipelines go to deletionQueue. Shut it down after the reloader, the watcher may queue until it's joined
+		bool Init(VkDevice device, DeletionQueue* deletionQueue);
+		// Stops the watcher and destroys pipelines that were rebuilt but never swapped in. Registered pipelines stay
+		// owned by whoever registered them
+		void Shutdown();
+
+		// pipeline is overwritten by Update() whenever a rebuild finishes, it must outlive the reloader
+		void Register(const char* name, const std::vector<ShaderSource>& shaders, BuildFunc build, VkPipeline* pipeline);
+		void RegisterReload(const char* name, const std::vector<ShaderSource>& shaders, ReloadFunc reload);
+
+		// Called by the render thread between frames, before the deletion queue's Update()
+		void Update();
+
+	private:
+
+		struct WatchedShader
+		{
+			ShaderSource Paths;
+			std::filesystem::file_time_type SourceWrite;
+			std::filesystem::file_time_type BinaryWrite;
+			// Binary changed and is rebuilt once its write time has held still for a poll, so half written files are skipped
+			bool bDirty = false;
+		};
+
+		struct Entry
+		{
+			std::string Name;
+			std::vector<uint32_t> Shaders;
+			BuildFunc Build;
+			VkPipeline* Target = nullptr;
+			// Set instead of Build and Target by RegisterReload
+			ReloadFunc Reload;
+		};
+
+		struct PendingRegistration
+		{
+			Entry Pipeline;
+			std::vector<ShaderSource> Shaders;
+		};
+
+		struct ReadyPipeline
+		{
+			std::string Name;
+			VkPipeline* Target = nullptr;
+			VkPipeline Pipeline = VK_NULL_HANDLE;
+		};
+
+		void WatcherLoop();
+		void AdoptRegistration(PendingRegistration& registration);
+		void Poll();
+
+		// Returns true when the file's write time moved since the last call
+		static bool HasChanged(const std::string& path, std::filesystem::file_time_type& lastWrite);
+		static bool CompileShader(const ShaderSource& shader);
+		static bool LoadBinary(const std::string& path, std::vector<uint32_t>& outWords);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		DeletionQueue* m_DeletionQueue = nullptr;
+
+		// Watcher thread only
+		std::vector<WatchedShader> m_Shaders;
+		std::vector<Entry> m_Entries;
+
+		// Shared, guarded by m_Mutex
+		std::vector<PendingRegistration> m_Registrations;
+		std::vector<ReadyPipeline> m_Ready;
+		bool m_bStopping = false;
+
+		// Render thread only
+		std::vector<ReadyPipeline> m_Swapping;
+
+		std::thread m_Watcher;
+		std::mutex m_Mutex;
+		std::condition_variable m_StopCondition;
+
+	};
+
+}
@@ -0,0 +1,559 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "PipelineStateCache.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <mutex>
+
+namespace Tempus {
+
+	namespace {
+
+		// Pipelines only fix the topology class, the exact topology is dynamic within it
+		VkPrimitiveTopology GetTopologyClass(VkPrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+				return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+			case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+			case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+			case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+			case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+				return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+				return VK_PRIMITIVE_TOPOLOGY_PATCH_LIST;
+			default:
+				return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			}
+		}
+
+		VkColorBlendEquationEXT GetBlendEquation(BlendMode blend)
+		{
+			VkColorBlendEquationEXT equation{};
+			equation.colorBlendOp = VK_BLEND_OP_ADD;
+			equation.alphaBlendOp = VK_BLEND_OP_ADD;
+			equation.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			equation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+
+			switch (blend)
+			{
+			case BlendMode::Alpha:
+				equation.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				equation.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				equation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				break;
+			case BlendMode::Additive:
+				equation.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				equation.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+				equation.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				break;
+			default:
+				equation.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+				equation.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+				break;
+			}
+
+			return equation;
+		}
+
+	}
+
+	uint32_t PipelineKey::PackState() const
+	{
+		return static_cast<uint32_t>(Topology) |
+			static_cast<uint32_t>(Blend) << 4 |
+			static_cast<uint32_t>(CullMode) << 6 |
+			static_cast<uint32_t>(FrontFace) << 8 |
+			static_cast<uint32_t>(bDepthTest) << 9 |
+			static_cast<uint32_t>(bDepthWrite) << 10 |
+			static_cast<uint32_t>(DepthCompare) << 11;
+	}
+
+	bool PipelineKey::operator==(const PipelineKey& other) const
+	{
+		return Program == other.Program && VariantBits == other.VariantBits && ColorFormat == other.ColorFormat &&
+			DepthFormat == other.DepthFormat && PackState() == other.PackState();
+	}
+
+	size_t PipelineKeyHash::operator()(const PipelineKey& key) const
+	{
+		// FNV-1a over the key's words
+		const uint32_t words[] = { key.Program, key.VariantBits, static_cast<uint32_t>(key.ColorFormat),
+			static_cast<uint32_t>(key.DepthFormat), key.PackState() };
+
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t word : words)
+		{
+			hash = (hash ^ word) * 1099511628211ull;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+
+	PipelineStateCache::~PipelineStateCache()
+	{
+		Shutdown();
+	}
+
+	bool PipelineStateCache::Init(VkDevice device, VkPipelineCache pipelineCache, DeletionQueue* deletionQueue, bool bDynamicBlend,
+		DescriptorLayoutCache* layoutCache)
+	{
+		m_Device = device;
+		m_PipelineCache = pipelineCache;
+		m_DeletionQueue = deletionQueue;
+		m_LayoutCache = layoutCache;
+
+		if (bDynamicBlend)
+		{
+			m_CmdSetColorBlendEnable = reinterpret_cast<PFN_vkCmdSetColorBlendEnableEXT>(
+				vkGetDeviceProcAddr(m_Device, "vkCmdSetColorBlendEnableEXT"));
+			m_CmdSetColorBlendEquation = reinterpret_cast<PFN_vkCmdSetColorBlendEquationEXT>(
+				vkGetDeviceProcAddr(m_Device, "vkCmdSetColorBlendEquationEXT"));
+		}
+
+		m_bDynamicBlend = m_CmdSetColorBlendEnable != nullptr && m_CmdSetColorBlendEquation != nullptr;
+
+		TPS_CORE_INFO("Pipeline state cache initialized (dynamic blending {0})", m_bDynamicBlend ? "on" : "off");
+
+		return true;
+	}
+
+	void PipelineStateCache::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		for (const auto& [key, pipeline] : m_Pipelines)
+		{
+			vkDestroyPipeline(m_Device, pipeline, nullptr);
+		}
+
+		for (Program& program : m_Programs)
+		{
+			program.Layout.Destroy(m_Device);
+		}
+
+		m_Pipelines.clear();
+		m_Programs.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	uint32_t PipelineStateCache::RegisterProgram(const char* name, ShaderCode vertCode, ShaderCode fragCode, uint32_t variantBitCount)
+	{
+		Program program;
+		program.Name = name;
+		program.VertCode.assign(vertCode.Words, vertCode.Words + vertCode.WordCount);
+		program.FragCode.assign(fragCode.Words, fragCode.Words + fragCode.WordCount);
+		program.VariantBitCount = std::min(variantBitCount, MAX_VARIANT_BITS);
+
+		ShaderReflection vertReflection;
+		ShaderReflection fragReflection;
+
+		if (!vertReflection.Reflect(vertCode) || !fragReflection.Reflect(fragCode) ||
+			!ShaderReflection::CreatePipelineLayout(m_Device, { &vertReflection, &fragReflection }, program.Layout, m_LayoutCache))
+		{
+			TPS_CORE_ERROR("Failed to create the layout of shader program {0}!", name);
+			return INVALID_PROGRAM;
+		}
+
+		vertReflection.GetVertexLayout(program.VertexLayout);
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+		m_Programs.push_back(std::move(program));
+
+		return static_cast<uint32_t>(m_Programs.size() - 1);
+	}
+
+	VkPipelineLayout PipelineStateCache::GetLayout(uint32_t program) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return program < m_Programs.size() ? m_Programs[program].Layout.Layout : VK_NULL_HANDLE;
+	}
+
+	VkDescriptorSetLayout PipelineStateCache::GetSetLayout(uint32_t program, uint32_t set) const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+		if (program >= m_Programs.size() || set >= m_Programs[program].Layout.SetLayouts.size())
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		return m_Programs[program].Layout.SetLayouts[set];
+	}
+
+	VkPipeline PipelineStateCache::GetPipeline(const PipelineKey& key)
+	{
+		PipelineKey pipelineKey = GetPipelineKey(key);
+
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+			auto it = m_Pipelines.find(pipelineKey);
+			if (it != m_Pipelines.end())
+			{
+				return it->second;
+			}
+		}
+
+		// Compiled without the lock so other threads keep recording. Concurrent misses on the same key may both build
+		// it, the first one inserted wins and the others are destroyed unused
+		while (true)
+		{
+			Program program;
+
+			{
+				std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+				if (pipelineKey.Program >= m_Programs.size())
+				{
+					TPS_CORE_ERROR("Pipeline key references unknown shader program {0}", pipelineKey.Program);
+					return VK_NULL_HANDLE;
+				}
+
+				// Copied, RegisterProgram() and ReloadProgram() may change the original meanwhile
+				program = m_Programs[pipelineKey.Program];
+			}
+
+			VkPipeline pipeline = CreatePipeline(pipelineKey, program, program.VertCode, program.FragCode, program.VertexLayout);
+
+			if (pipeline == VK_NULL_HANDLE)
+			{
+				TPS_CORE_ERROR("Failed to create a pipeline for shader program {0}!", program.Name);
+				return VK_NULL_HANDLE;
+			}
+
+			std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+			auto it = m_Pipelines.find(pipelineKey);
+			if (it != m_Pipelines.end())
+			{
+				vkDestroyPipeline(m_Device, pipeline, nullptr);
+				return it->second;
+			}
+
+			// The program was reloaded while this compiled, build again from the new code
+			if (m_Programs[pipelineKey.Program].Generation != program.Generation)
+			{
+				lock.unlock();
+				vkDestroyPipeline(m_Device, pipeline, nullptr);
+				continue;
+			}
+
+			m_Pipelines.emplace(pipelineKey, pipeline);
+			return pipeline;
+		}
+	}
+
+	void PipelineStateCache::Bind(VkCommandBuffer commandBuffer, const PipelineKey& key)
+	{
+		VkPipeline pipeline = GetPipeline(key);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+		vkCmdSetPrimitiveTopology(commandBuffer, key.Topology);
+		vkCmdSetCullMode(commandBuffer, key.CullMode);
+		vkCmdSetFrontFace(commandBuffer, key.FrontFace);
+		vkCmdSetDepthTestEnable(commandBuffer, key.bDepthTest);
+		vkCmdSetDepthWriteEnable(commandBuffer, key.bDepthWrite);
+		vkCmdSetDepthCompareOp(commandBuffer, key.DepthCompare);
+
+		if (m_bDynamicBlend)
+		{
+			VkBool32 bBlendEnable = key.Blend != BlendMode::Opaque;
+			VkColorBlendEquationEXT equation = GetBlendEquation(key.Blend);
+
+			m_CmdSetColorBlendEnable(commandBuffer, 0, 1, &bBlendEnable);
+			m_CmdSetColorBlendEquation(commandBuffer, 0, 1, &equation);
+		}
+	}
+
+	bool PipelineStateCache::ReloadProgram(uint32_t programIndex, ShaderCode vertCode, ShaderCode fragCode)
+	{
+		std::vector<uint32_t> newVertCode(vertCode.Words, vertCode.Words + vertCode.WordCount);
+		std::vector<uint32_t> newFragCode(fragCode.Words, fragCode.Words + fragCode.WordCount);
+
+		ShaderReflection vertReflection;
+		if (!vertReflection.Reflect(vertCode))
+		{
+			return false;
+		}
+
+		ReflectedVertexLayout vertexLayout;
+		vertReflection.GetVertexLayout(vertexLayout);
+
+		// Snapshot of the program and the keys using it, the pipelines are built without holding the lock
+		Program program;
+		std::vector<PipelineKey> keys;
+
+		{
+			std::shared_lock<std::shared_mutex> lock(m_Mutex);
+
+			if (programIndex >= m_Programs.size())
+			{
+				return false;
+			}
+
+			program.Name = m_Programs[programIndex].Name;
+			program.Layout.Layout = m_Programs[programIndex].Layout.Layout;
+			program.VariantBitCount = m_Programs[programIndex].VariantBitCount;
+
+			for (const auto& [key, pipeline] : m_Pipelines)
+			{
+				if (key.Program == programIndex)
+				{
+					keys.push_back(key);
+				}
+			}
+		}
+
+		std::vector<VkPipeline> pipelines;
+
+		for (const PipelineKey& key : keys)
+		{
+			VkPipeline pipeline = CreatePipeline(key, program, newVertCode, newFragCode, vertexLayout);
+			if (pipeline == VK_NULL_HANDLE)
+			{
+				for (VkPipeline built : pipelines)
+				{
+					vkDestroyPipeline(m_Device, built, nullptr);
+				}
+
+				return false;
+			}
+
+			pipelines.push_back(pipeline);
+		}
+
+		std::unique_lock<std::shared_mutex> lock(m_Mutex);
+
+		Program& target = m_Programs[programIndex];
+		target.VertCode = std::move(newVertCode);
+		target.FragCode = std::move(newFragCode);
+		target.VertexLayout = vertexLayout;
+		target.Generation++;
+
+		for (auto it = m_Pipelines.begin(); it != m_Pipelines.end();)
+		{
+			if (it->first.Program != programIndex)
+			{
+				++it;
+				continue;
+			}
+
+			m_DeletionQueue->DestroyPipeline(it->second);
+
+			auto rebuilt = std::find(keys.begin(), keys.end(), it->first);
+			if (rebuilt != keys.end())
+			{
+				it->second = pipelines[rebuilt - keys.begin()];
+				++it;
+			}
+			else
+			{
+				// Added while the rebuild ran, so it still uses the old code. Recreated on its next use
+				it = m_Pipelines.erase(it);
+			}
+		}
+
+		return true;
+	}
+
+	uint32_t PipelineStateCache::GetPipelineCount() const
+	{
+		std::shared_lock<std::shared_mutex> lock(m_Mutex);
+		return static_cast<uint32_t>(m_Pipelines.size());
+	}
+
+	PipelineKey PipelineStateCache::GetPipelineKey(const PipelineKey& key) const
+	{
+		PipelineKey pipelineKey = key;
+		pipelineKey.Topology = GetTopologyClass(key.Topology);
+		pipelineKey.CullMode = VK_CULL_MODE_NONE;
+		pipelineKey.FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		pipelineKey.bDepthTest = false;
+		pipelineKey.bDepthWrite = false;
+		pipelineKey.DepthCompare = VK_COMPARE_OP_NEVER;
+
+		if (m_bDynamicBlend)
+		{
+			pipelineKey.Blend = BlendMode::Opaque;
+		}
+
+		return pipelineKey;
+	}
+
+	VkPipeline PipelineStateCache::CreatePipeline(const PipelineKey& key, const Program& program, const std::vector<uint32_t>& vertCode,
+		const std::vector<uint32_t>& fragCode, const ReflectedVertexLayout& vertexLayout) const
+	{
+		VkShaderModule vertShader = CreateShaderModule(vertCode);
+		VkShaderModule fragShader = CreateShaderModule(fragCode);
+
+		if (vertShader == VK_NULL_HANDLE || fragShader == VK_NULL_HANDLE)
+		{
+			vkDestroyShaderModule(m_Device, vertShader, nullptr);
+			vkDestroyShaderModule(m_Device, fragShader, nullptr);
+			return VK_NULL_HANDLE;
+		}
+
+		// Specialization constant i is variant bit i, constants a stage doesn't declare are ignored
+		VkSpecializationMapEntry specializationEntries[MAX_VARIANT_BITS];
+		VkBool32 specializationData[MAX_VARIANT_BITS];
+
+		for (uint32_t bit = 0; bit < program.VariantBitCount; bit++)
+		{
+			specializationEntries[bit].constantID = bit;
+			specializationEntries[bit].offset = bit * sizeof(VkBool32);
+			specializationEntries[bit].size = sizeof(VkBool32);
+			specializationData[bit] = (key.VariantBits >> bit) & 1;
+		}
+
+		VkSpecializationInfo specialization{};
+		specialization.mapEntryCount = program.VariantBitCount;
+		specialization.pMapEntries = specializationEntries;
+		specialization.dataSize = program.VariantBitCount * sizeof(VkBool32);
+		specialization.pData = specializationData;
+
+		VkPipelineShaderStageCreateInfo shaderStages[2]{};
+		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = vertShader;
+		shaderStages[0].pName = "main";
+		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[1].module = fragShader;
+		shaderStages[1].pName = "main";
+
+		if (program.VariantBitCount > 0)
+		{
+			shaderStages[0].pSpecializationInfo = &specialization;
+			shaderStages[1].pSpecializationInfo = &specialization;
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = vertexLayout.GetCreateInfo();
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = key.Topology;
+
+		std::vector<VkDynamicState> dynamicStates =
+		{
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR,
+			VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+			VK_DYNAMIC_STATE_CULL_MODE,
+			VK_DYNAMIC_STATE_FRONT_FACE,
+			VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+			VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP
+		};
+
+		if (m_bDynamicBlend)
+		{
+			dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+			dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_EQUATION_EXT);
+		}
+
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+		dynamicState.pDynamicStates = dynamicStates.data();
+
+		VkPipelineViewportStateCreateInfo viewportState{};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		VkPipelineRasterizationStateCreateInfo rasterizer{};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizer.lineWidth = 1.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisampling{};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisampling.minSampleShading = 1.0f;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+		VkColorBlendEquationEXT equation = GetBlendEquation(key.Blend);
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = key.Blend != BlendMode::Opaque;
+		colorBlendAttachment.srcColorBlendFactor = equation.srcColorBlendFactor;
+		colorBlendAttachment.dstColorBlendFactor = equation.dstColorBlendFactor;
+		colorBlendAttachment.colorBlendOp = equation.colorBlendOp;
+		colorBlendAttachment.srcAlphaBlendFactor = equation.srcAlphaBlendFactor;
+		colorBlendAttachment.dstAlphaBlendFactor = equation.dstAlphaBlendFactor;
+		colorBlendAttachment.alphaBlendOp = equation.alphaBlendOp;
+
+		VkPipelineColorBlendStateCreateInfo colorBlending{};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.attachmentCount = 1;
+		colorBlending.pAttachments = &colorBlendAttachment;
+
+		VkPipelineRenderingCreateInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachmentFormats = &key.ColorFormat;
+		renderingInfo.depthAttachmentFormat = key.DepthFormat;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = key.DepthFormat != VK_FORMAT_UNDEFINED ? &depthStencil : nullptr;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = program.Layout.Layout;
+		pipelineInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VkResult result = vkCreateGraphicsPipelines(m_Device, m_PipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+
+		vkDestroyShaderModule(m_Device, vertShader, nullptr);
+		vkDestroyShaderModule(m_Device, fragShader, nullptr);
+
+		return result == VK_SUCCESS ? pipeline : VK_NULL_HANDLE;
+	}
+
+	VkShaderModule PipelineStateCache::CreateShaderModule(const std::vector<uint32_t>& code) const
+	{
+		ShaderCode shaderCode{ code.data(), code.size() };
+		if (!shaderCode.IsValid())
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		VkShaderModuleCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		createInfo.codeSize = shaderCode.GetSize();
+		createInfo.pCode = shaderCode.Words;
+
+		VkShaderModule shaderModule = VK_NULL_HANDLE;
+
+		if (vkCreateShaderModule(m_Device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		return shaderModule;
+	}
+
+}
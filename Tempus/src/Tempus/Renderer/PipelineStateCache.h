@@ -0,0 +1,133 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "ShaderReflection.h"
+#include "DeletionQueue.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <shared_mutex>
+
+namespace Tempus {
+
+	enum class BlendMode : uint8_t
+	{
+		Opaque = 0,
+		Alpha,
+		Additive
+	};
+
+	// Everything that selects a graphics pipeline. Fields the device can set dynamically are still part of the key, the
+	// cache drops them when looking up the pipeline and sets them on the command buffer in Bind()
+	struct PipelineKey
+	{
+		// Returned by PipelineStateCache::RegisterProgram
+		uint32_t Program = 0;
+		// Bit i is specialization constant i of every stage, as a bool
+		uint32_t VariantBits = 0;
+		VkFormat ColorFormat = VK_FORMAT_UNDEFINED;
+		// VK_FORMAT_UNDEFINED renders without depth
+		VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+
+		VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		BlendMode Blend = BlendMode::Opaque;
+		VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace FrontFace = VK_FRONT_FACE_CLOCKWISE;
+		bool bDepthTest = false;
+		bool bDepthWrite = false;
+		VkCompareOp DepthCompare = VK_COMPARE_OP_LESS;
+
+		// Fixed function state packed into one word, which is what the hash and comparison look at
+		uint32_t PackState() const;
+		bool operator==(const PipelineKey& other) const;
+	};
+
+	struct PipelineKeyHash
+	{
+		size_t operator()(const PipelineKey& key) const;
+	};
+
+	// Lazily created graphics pipelines keyed by PipelineKey. With the Vulkan 1.3 extended dynamic state cull mode,
+	// front face, topology (within its class) and depth state never cause a new pipeline, and blending joins them when
+	// VK_EXT_extended_dynamic_state3 is available. Lookups are thread safe so worker threads can bind while recording
+	class TEMPUS_API PipelineStateCache
+	{
+	public:
+
+		static constexpr uint32_t INVALID_PROGRAM = UINT32_MAX;
+		static constexpr uint32_t MAX_VARIANT_BITS = 32;
+
+		PipelineStateCache() = default;
+		~PipelineStateCache();
+
+		// bDynamicBlend requires the extendedDynamicState3ColorBlendEnable and ColorBlendEquation features to be enabled.
+		// Replaced pipelines go to deletionQueue, which has to be flushed before Shutdown(). Program set layouts come
+		// from layoutCache when given, which then has to outlive the cache
+		bool Init(VkDevice device, VkPipelineCache pipelineCache, DeletionQueue* deletionQueue, bool bDynamicBlend,
+			DescriptorLayoutCache* layoutCache = nullptr);
+		void Shutdown();
+
+		// Copies the code and creates the program's layout from reflection. variantBitCount is how many specialization
+		// constants the shaders declare. Returns INVALID_PROGRAM on failure
+		uint32_t RegisterProgram(const char* name, ShaderCode vertCode, ShaderCode fragCode, uint32_t variantBitCount = 0);
+		VkPipelineLayout GetLayout(uint32_t program) const;
+		// VK_NULL_HANDLE when the program's shaders declare no set at that index or above
+		VkDescriptorSetLayout GetSetLayout(uint32_t program, uint32_t set) const;
+
+		// Creates the pipeline on first use, which stalls the calling thread but no other. Warm keys up front with this
+		// when that matters
+		VkPipeline GetPipeline(const PipelineKey& key);
+		// Binds the key's pipeline and sets the state it leaves dynamic. Viewport and scissor are left to the caller
+		void Bind(VkCommandBuffer commandBuffer, const PipelineKey& key);
+
+		// Rebuilds every cached pipeline of the program on the calling thread, then swaps them in. The replaced
+		// pipelines are queued for deletion until no frame in flight can use them. The layout is kept
+		bool ReloadProgram(uint32_t program, ShaderCode vertCode, ShaderCode fragCode);
+
+		uint32_t GetPipelineCount() const;
+		bool HasDynamicBlend() const { return m_bDynamicBlend; }
+
+	private:
+
+		struct Program
+		{
+			std::string Name;
+			std::vector<uint32_t> VertCode;
+			std::vector<uint32_t> FragCode;
+			ReflectedPipelineLayout Layout;
+			ReflectedVertexLayout VertexLayout;
+			uint32_t VariantBitCount = 0;
+			// Bumped by ReloadProgram(), so pipelines built from older code are never inserted
+			uint32_t Generation = 0;
+		};
+
+		// Clears the fields that are set dynamically, so keys differing only in those share a pipeline
+		PipelineKey GetPipelineKey(const PipelineKey& key) const;
+		VkPipeline CreatePipeline(const PipelineKey& key, const Program& program, const std::vector<uint32_t>& vertCode,
+			const std::vector<uint32_t>& fragCode, const ReflectedVertexLayout& vertexLayout) const;
+		VkShaderModule CreateShaderModule(const std::vector<uint32_t>& code) const;
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+		DeletionQueue* m_DeletionQueue = nullptr;
+		DescriptorLayoutCache* m_LayoutCache = nullptr;
+		bool m_bDynamicBlend = false;
+
+		PFN_vkCmdSetColorBlendEnableEXT m_CmdSetColorBlendEnable = nullptr;
+		PFN_vkCmdSetColorBlendEquationEXT m_CmdSetColorBlendEquation = nullptr;
+
+		std::vector<Program> m_Programs;
+		std::unordered_map<PipelineKey, VkPipeline, PipelineKeyHash> m_Pipelines;
+
+		// Shared for lookups, exclusive while a pipeline is added or swapped. Never held while a pipeline compiles
+		mutable std::shared_mutex m_Mutex;
+
+	};
+
+}
@@ -0,0 +1,871 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "RenderGraph.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	namespace {
+
+		VkImageAspectFlags GetAspectMask(VkFormat format)
+		{
+			switch (format)
+			{
+			case VK_FORMAT_D16_UNORM:
+			case VK_FORMAT_X8_D24_UNORM_PACK32:
+			case VK_FORMAT_D32_SFLOAT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT;
+			case VK_FORMAT_D16_UNORM_S8_UINT:
+			case VK_FORMAT_D24_UNORM_S8_UINT:
+			case VK_FORMAT_D32_SFLOAT_S8_UINT:
+				return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+			case VK_FORMAT_S8_UINT:
+				return VK_IMAGE_ASPECT_STENCIL_BIT;
+			default:
+				return VK_IMAGE_ASPECT_COLOR_BIT;
+			}
+		}
+
+		void HashCombine(size_t& seed, uint64_t value)
+		{
+			seed ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		}
+
+		constexpr VkPipelineStageFlags2 SHADER_STAGES = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+	}
+
+	RenderGraphPass& RenderGraphPass::AddColorAttachment(RGHandle texture, VkAttachmentLoadOp loadOp, VkClearColorValue clearColour)
+	{
+		Attachment attachment;
+		attachment.Resource = texture.Index;
+		attachment.LoadOp = loadOp;
+		attachment.Clear.color = clearColour;
+		m_ColorAttachments.push_back(attachment);
+
+		Access access;
+		access.Resource = texture.Index;
+		access.Usage = RGUsage::ColorAttachment;
+		access.bRead = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+		access.bWrite = true;
+		access.bOverwrite = !access.bRead;
+		m_Accesses.push_back(access);
+
+		return *this;
+	}
+
+	RenderGraphPass& RenderGraphPass::SetDepthAttachment(RGHandle texture, VkAttachmentLoadOp loadOp, float clearDepth)
+	{
+		m_DepthAttachment.Resource = texture.Index;
+		m_DepthAttachment.LoadOp = loadOp;
+		m_DepthAttachment.Clear.depthStencil = { clearDepth, 0 };
+		m_bHasDepth = true;
+
+		Access access;
+		access.Resource = texture.Index;
+		access.Usage = RGUsage::DepthAttachment;
+		access.bRead = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+		access.bWrite = true;
+		access.bOverwrite = !access.bRead;
+		m_Accesses.push_back(access);
+
+		return *this;
+	}
+
+	RenderGraphPass& RenderGraphPass::Read(RGHandle resource, RGUsage usage)
+	{
+		Access access;
+		access.Resource = resource.Index;
+		access.Usage = usage;
+		access.bRead = true;
+		m_Accesses.push_back(access);
+
+		return *this;
+	}
+
+	RenderGraphPass& RenderGraphPass::Write(RGHandle resource, RGUsage usage)
+	{
+		Access access;
+		access.Resource = resource.Index;
+		access.Usage = usage;
+		access.bWrite = true;
+		m_Accesses.push_back(access);
+
+		return *this;
+	}
+
+	RenderGraph::~RenderGraph()
+	{
+		Shutdown();
+	}
+
+	bool RenderGraph::Init(VkDevice device, GPUAllocator* allocator, DeletionQueue* deletionQueue)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_DeletionQueue = deletionQueue;
+
+		return true;
+	}
+
+	void RenderGraph::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		Reset();
+		DestroyTransients();
+
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void RenderGraph::Reset()
+	{
+		m_Resources.clear();
+		m_Passes.clear();
+		m_ImageBarriers.clear();
+		m_BufferBarriers.clear();
+		m_FinalBarriers.clear();
+	}
+
+	RGHandle RenderGraph::ImportTexture(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+		VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags2 initialStage)
+	{
+		Resource resource;
+		resource.Name = name;
+		resource.Type = ResourceType::Texture;
+		resource.bImported = true;
+		resource.bExported = finalLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+		resource.Desc.Width = extent.width;
+		resource.Desc.Height = extent.height;
+		resource.Desc.Format = format;
+		resource.Image = image;
+		resource.View = view;
+		resource.FinalLayout = finalLayout;
+		resource.State.Layout = initialLayout;
+		resource.State.WriteStages = initialStage;
+
+		m_Resources.push_back(resource);
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	RGHandle RenderGraph::ImportBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, bool bExported,
+		VkPipelineStageFlags2 previousStages)
+	{
+		Resource resource;
+		resource.Name = name;
+		resource.Type = ResourceType::Buffer;
+		resource.bImported = true;
+		resource.bExported = bExported;
+		resource.Buffer = buffer;
+		resource.BufferSize = size;
+		resource.State.ReadStages = previousStages;
+
+		m_Resources.push_back(resource);
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	RGHandle RenderGraph::CreateTexture(const char* name, const RGTextureDesc& desc)
+	{
+		Resource resource;
+		resource.Name = name;
+		resource.Type = ResourceType::Texture;
+		resource.Desc = desc;
+
+		m_Resources.push_back(resource);
+		return { static_cast<uint32_t>(m_Resources.size() - 1) };
+	}
+
+	RenderGraphPass& RenderGraph::AddPass(const char* name, RenderGraphPass::ExecuteFunc execute)
+	{
+		RenderGraphPass& pass = m_Passes.emplace_back();
+		pass.m_Name = name;
+		pass.m_Execute = std::move(execute);
+
+		return pass;
+	}
+
+	bool RenderGraph::Compile()
+	{
+		for (const RenderGraphPass& pass : m_Passes)
+		{
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (access.Resource >= m_Resources.size())
+				{
+					TPS_CORE_ERROR("Render graph pass {0} uses an invalid resource handle!", pass.m_Name);
+					return false;
+				}
+			}
+		}
+
+		CullPasses();
+		ComputeLifetimes();
+
+		if (!RealizeTransients())
+		{
+			return false;
+		}
+
+		BuildBarriers();
+
+		return true;
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// Walk backwards from the exported resources. A pass survives if it writes something a later surviving pass
+		// (or the outside world) still needs, and everything it reads becomes needed in turn
+		std::vector<bool> needed(m_Resources.size(), false);
+		for (size_t i = 0; i < m_Resources.size(); i++)
+		{
+			needed[i] = m_Resources[i].bExported;
+		}
+
+		for (size_t i = m_Passes.size(); i-- > 0;)
+		{
+			RenderGraphPass& pass = m_Passes[i];
+			pass.m_bCulled = !pass.m_bSideEffect;
+
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (access.bWrite && needed[access.Resource])
+				{
+					pass.m_bCulled = false;
+				}
+			}
+
+			if (pass.m_bCulled)
+			{
+				continue;
+			}
+
+			// Earlier writes of fully overwritten attachments are dead, unless this pass also reads them
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (access.bOverwrite)
+				{
+					needed[access.Resource] = false;
+				}
+			}
+
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				if (access.bRead)
+				{
+					needed[access.Resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (uint32_t passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			const RenderGraphPass& pass = m_Passes[passIndex];
+			if (pass.m_bCulled)
+			{
+				continue;
+			}
+
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				resource.FirstPass = std::min(resource.FirstPass, passIndex);
+				resource.LastPass = std::max(resource.LastPass, passIndex);
+				resource.Usage |= GetImageUsageFlags(access.Usage);
+			}
+		}
+	}
+
+	bool RenderGraph::RealizeTransients()
+	{
+		std::vector<uint32_t> transients;
+		size_t hash = 0;
+
+		for (uint32_t i = 0; i < m_Resources.size(); i++)
+		{
+			Resource& resource = m_Resources[i];
+			if (resource.bImported || resource.FirstPass == UINT32_MAX)
+			{
+				continue;
+			}
+
+			resource.Usage |= resource.Desc.ExtraUsage;
+			transients.push_back(i);
+
+			HashCombine(hash, (static_cast<uint64_t>(resource.Desc.Width) << 32) | resource.Desc.Height);
+			HashCombine(hash, (static_cast<uint64_t>(resource.Desc.Format) << 32) | resource.Usage);
+			HashCombine(hash, (static_cast<uint64_t>(resource.FirstPass) << 32) | resource.LastPass);
+		}
+
+		// Same transient layout as last frame, keep the images and their placement
+		if (hash != m_TransientHash || transients.size() != m_PhysicalTextures.size())
+		{
+			if (!m_PhysicalTextures.empty())
+			{
+				// Previous frames may still be using the old images. Without a deletion queue the only option is to
+				// wait for them. Layout changes are rare (resize, graph edits)
+				if (m_DeletionQueue == nullptr)
+				{
+					vkDeviceWaitIdle(m_Device);
+				}
+
+				DestroyTransients(m_DeletionQueue != nullptr);
+			}
+
+			m_PhysicalTextures.resize(transients.size());
+
+			for (size_t i = 0; i < transients.size(); i++)
+			{
+				const Resource& resource = m_Resources[transients[i]];
+				PhysicalTexture& physical = m_PhysicalTextures[i];
+
+				VkImageCreateInfo imageInfo{};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = resource.Desc.Format;
+				imageInfo.extent = { resource.Desc.Width, resource.Desc.Height, 1 };
+				imageInfo.mipLevels = 1;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage = resource.Usage;
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+				if (vkCreateImage(m_Device, &imageInfo, nullptr, &physical.Image) != VK_SUCCESS)
+				{
+					TPS_CORE_ERROR("Failed to create transient texture {0}!", resource.Name);
+					DestroyTransients();
+					return false;
+				}
+
+				vkGetImageMemoryRequirements(m_Device, physical.Image, &physical.Requirements);
+			}
+
+			// Greedy placement in order of first use. A slot can be reused once its last occupant's final pass
+			// lies before the new texture's first pass. Prefer the tightest slot that already fits
+			std::vector<uint32_t> order(transients.size());
+			for (uint32_t i = 0; i < order.size(); i++)
+			{
+				order[i] = i;
+			}
+
+			std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+				{
+					return m_Resources[transients[a]].FirstPass < m_Resources[transients[b]].FirstPass;
+				});
+
+			std::vector<uint32_t> slotOccupant;
+			VkDeviceSize unaliasedBytes = 0;
+
+			for (uint32_t physicalIndex : order)
+			{
+				const Resource& resource = m_Resources[transients[physicalIndex]];
+				PhysicalTexture& physical = m_PhysicalTextures[physicalIndex];
+				const VkMemoryRequirements& requirements = physical.Requirements;
+				unaliasedBytes += requirements.size;
+
+				uint32_t bestSlot = UINT32_MAX;
+				for (uint32_t slotIndex = 0; slotIndex < m_MemorySlots.size(); slotIndex++)
+				{
+					const MemorySlot& slot = m_MemorySlots[slotIndex];
+					if (slot.LastPass >= resource.FirstPass || (slot.MemoryTypeBits & requirements.memoryTypeBits) == 0)
+					{
+						continue;
+					}
+
+					if (bestSlot == UINT32_MAX)
+					{
+						bestSlot = slotIndex;
+						continue;
+					}
+
+					const MemorySlot& best = m_MemorySlots[bestSlot];
+					bool bFits = slot.Size >= requirements.size;
+					bool bBestFits = best.Size >= requirements.size;
+
+					if ((bFits && (!bBestFits || slot.Size < best.Size)) || (!bFits && !bBestFits && slot.Size > best.Size))
+					{
+						bestSlot = slotIndex;
+					}
+				}
+
+				if (bestSlot == UINT32_MAX)
+				{
+					bestSlot = static_cast<uint32_t>(m_MemorySlots.size());
+					m_MemorySlots.emplace_back();
+					slotOccupant.push_back(UINT32_MAX);
+				}
+
+				MemorySlot& slot = m_MemorySlots[bestSlot];
+				slot.Size = std::max(slot.Size, requirements.size);
+				slot.Alignment = std::max(slot.Alignment, requirements.alignment);
+				slot.MemoryTypeBits &= requirements.memoryTypeBits;
+				slot.LastPass = resource.LastPass;
+
+				physical.Slot = bestSlot;
+				physical.PreviousOccupant = slotOccupant[bestSlot];
+				slotOccupant[bestSlot] = physicalIndex;
+			}
+
+			VkDeviceSize aliasedBytes = 0;
+			for (MemorySlot& slot : m_MemorySlots)
+			{
+				VkMemoryRequirements requirements{};
+				requirements.size = slot.Size;
+				requirements.alignment = slot.Alignment;
+				requirements.memoryTypeBits = slot.MemoryTypeBits;
+
+				if (!m_Allocator->Allocate(requirements, MemoryUsage::GPUOnly, false, slot.Allocation))
+				{
+					TPS_CORE_ERROR("Failed to allocate {0} bytes of transient render graph memory!", slot.Size);
+					DestroyTransients();
+					return false;
+				}
+
+				aliasedBytes += slot.Size;
+			}
+
+			for (size_t i = 0; i < transients.size(); i++)
+			{
+				const Resource& resource = m_Resources[transients[i]];
+				PhysicalTexture& physical = m_PhysicalTextures[i];
+				const MemorySlot& slot = m_MemorySlots[physical.Slot];
+
+				if (vkBindImageMemory(m_Device, physical.Image, slot.Allocation.Memory, slot.Allocation.Offset) != VK_SUCCESS)
+				{
+					TPS_CORE_ERROR("Failed to bind memory of transient texture {0}!", resource.Name);
+					DestroyTransients();
+					return false;
+				}
+
+				VkImageViewCreateInfo viewInfo{};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = physical.Image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = resource.Desc.Format;
+				viewInfo.subresourceRange.aspectMask = GetAspectMask(resource.Desc.Format);
+				viewInfo.subresourceRange.levelCount = 1;
+				viewInfo.subresourceRange.layerCount = 1;
+
+				if (vkCreateImageView(m_Device, &viewInfo, nullptr, &physical.View) != VK_SUCCESS)
+				{
+					TPS_CORE_ERROR("Failed to create view of transient texture {0}!", resource.Name);
+					DestroyTransients();
+					return false;
+				}
+			}
+
+			m_TransientHash = hash;
+
+			if (!transients.empty())
+			{
+				TPS_CORE_INFO("Render graph placed {0} transient textures in {1} memory slots, {2} KB ({3} KB without aliasing)",
+					transients.size(), m_MemorySlots.size(), aliasedBytes / 1024, unaliasedBytes / 1024);
+			}
+		}
+
+		for (size_t i = 0; i < transients.size(); i++)
+		{
+			Resource& resource = m_Resources[transients[i]];
+			const PhysicalTexture& physical = m_PhysicalTextures[i];
+
+			resource.Physical = static_cast<uint32_t>(i);
+			resource.Image = physical.Image;
+			resource.View = physical.View;
+			resource.AliasPredecessor = physical.PreviousOccupant != UINT32_MAX ? transients[physical.PreviousOccupant] : UINT32_MAX;
+		}
+
+		return true;
+	}
+
+	void RenderGraph::DestroyTransients(bool bDeferred)
+	{
+		// Views and images are queued ahead of the memory they're bound to, so the queue destroys them first
+		for (PhysicalTexture& physical : m_PhysicalTextures)
+		{
+			if (physical.View != VK_NULL_HANDLE)
+			{
+				if (bDeferred)
+				{
+					m_DeletionQueue->DestroyImageView(physical.View);
+				}
+				else
+				{
+					vkDestroyImageView(m_Device, physical.View, nullptr);
+				}
+			}
+
+			if (physical.Image != VK_NULL_HANDLE)
+			{
+				// Aliased images are bound to slot memory, so there's no allocation of their own to free
+				if (bDeferred)
+				{
+					m_DeletionQueue->DestroyImage(physical.Image, GPUAllocation());
+				}
+				else
+				{
+					vkDestroyImage(m_Device, physical.Image, nullptr);
+				}
+			}
+		}
+
+		for (MemorySlot& slot : m_MemorySlots)
+		{
+			if (slot.Allocation.IsValid())
+			{
+				if (bDeferred)
+				{
+					m_DeletionQueue->FreeMemory(slot.Allocation);
+				}
+				else
+				{
+					m_Allocator->Free(slot.Allocation);
+				}
+			}
+		}
+
+		m_PhysicalTextures.clear();
+		m_MemorySlots.clear();
+		m_TransientHash = 0;
+	}
+
+	void RenderGraph::BuildBarriers()
+	{
+		m_ImageBarriers.clear();
+		m_BufferBarriers.clear();
+		m_FinalBarriers.clear();
+
+		for (Resource& resource : m_Resources)
+		{
+			if (!resource.bImported && resource.AliasPredecessor == UINT32_MAX)
+			{
+				// The previous frame may still be touching this memory on the same queue
+				resource.State.Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+				resource.State.WriteStages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				resource.State.WriteAccess = VK_ACCESS_2_MEMORY_WRITE_BIT;
+			}
+		}
+
+		for (uint32_t passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			RenderGraphPass& pass = m_Passes[passIndex];
+			if (pass.m_bCulled)
+			{
+				continue;
+			}
+
+			// Aliased textures start where their predecessor in the same memory left off, with undefined contents
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				Resource& resource = m_Resources[access.Resource];
+				if (resource.AliasPredecessor != UINT32_MAX && resource.FirstPass == passIndex)
+				{
+					const ResourceState& previous = m_Resources[resource.AliasPredecessor].State;
+					resource.State.Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+					resource.State.WriteStages = previous.WriteStages | previous.ReadStages;
+					resource.State.WriteAccess = previous.WriteAccess;
+					resource.State.ReadStages = VK_PIPELINE_STAGE_2_NONE;
+				}
+			}
+
+			pass.m_FirstImageBarrier = static_cast<uint32_t>(m_ImageBarriers.size());
+			pass.m_FirstBufferBarrier = static_cast<uint32_t>(m_BufferBarriers.size());
+
+			for (const RenderGraphPass::Access& access : pass.m_Accesses)
+			{
+				AddBarrier(access.Resource, GetUsageInfo(access.Usage), access.bWrite);
+			}
+
+			pass.m_ImageBarrierCount = static_cast<uint32_t>(m_ImageBarriers.size()) - pass.m_FirstImageBarrier;
+			pass.m_BufferBarrierCount = static_cast<uint32_t>(m_BufferBarriers.size()) - pass.m_FirstBufferBarrier;
+		}
+
+		for (const Resource& resource : m_Resources)
+		{
+			if (resource.Type != ResourceType::Texture || !resource.bExported || resource.FirstPass == UINT32_MAX)
+			{
+				continue;
+			}
+
+			if (resource.State.Layout != resource.FinalLayout || resource.State.WriteAccess != VK_ACCESS_2_NONE)
+			{
+				PushBarrier(resource, resource.State.WriteStages | resource.State.ReadStages, resource.State.WriteAccess,
+					resource.FinalLayout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, m_FinalBarriers);
+			}
+		}
+	}
+
+	void RenderGraph::AddBarrier(uint32_t resourceIndex, const UsageInfo& usage, bool bWrite)
+	{
+		Resource& resource = m_Resources[resourceIndex];
+		ResourceState& state = resource.State;
+
+		bool bTexture = resource.Type == ResourceType::Texture;
+		bool bLayoutChange = bTexture && state.Layout != usage.Layout;
+
+		if (bWrite)
+		{
+			// Write after read only needs the readers to finish, write after write also needs the writes made available
+			if (state.ReadStages != VK_PIPELINE_STAGE_2_NONE)
+			{
+				PushBarrier(resource, state.ReadStages, VK_ACCESS_2_NONE, usage.Layout, usage.Stages, usage.Access, m_ImageBarriers);
+			}
+			else if (state.WriteStages != VK_PIPELINE_STAGE_2_NONE || bLayoutChange)
+			{
+				PushBarrier(resource, state.WriteStages, state.WriteAccess, usage.Layout, usage.Stages, usage.Access, m_ImageBarriers);
+			}
+
+			state.WriteStages = usage.Stages;
+			state.WriteAccess = usage.Access;
+			state.ReadStages = VK_PIPELINE_STAGE_2_NONE;
+		}
+		else if (bLayoutChange)
+		{
+			PushBarrier(resource, state.WriteStages | state.ReadStages, state.WriteAccess, usage.Layout, usage.Stages, usage.Access, m_ImageBarriers);
+			state.ReadStages = usage.Stages;
+		}
+		else if ((usage.Stages & ~state.ReadStages) != 0 && state.WriteAccess != VK_ACCESS_2_NONE)
+		{
+			// A new stage reads the last write. Reads in stages that already see it need nothing
+			PushBarrier(resource, state.WriteStages, state.WriteAccess, usage.Layout, usage.Stages, usage.Access, m_ImageBarriers);
+			state.ReadStages |= usage.Stages;
+		}
+		else
+		{
+			state.ReadStages |= usage.Stages;
+		}
+
+		if (bTexture)
+		{
+			state.Layout = usage.Layout;
+		}
+	}
+
+	void RenderGraph::PushBarrier(const Resource& resource, VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+		VkImageLayout newLayout, VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess, std::vector<VkImageMemoryBarrier2>& imageBarriers)
+	{
+		if (resource.Type == ResourceType::Buffer)
+		{
+			VkBufferMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+			barrier.srcStageMask = srcStages;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstStageMask = dstStages;
+			barrier.dstAccessMask = dstAccess;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = resource.Buffer;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+
+			m_BufferBarriers.push_back(barrier);
+			return;
+		}
+
+		VkImageMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = srcStages;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStages;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = resource.State.Layout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resource.Image;
+		barrier.subresourceRange.aspectMask = GetAspectMask(resource.Desc.Format);
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+		imageBarriers.push_back(barrier);
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+	{
+		std::vector<VkRenderingAttachmentInfo> colorAttachments;
+
+		for (uint32_t passIndex = 0; passIndex < m_Passes.size(); passIndex++)
+		{
+			const RenderGraphPass& pass = m_Passes[passIndex];
+			if (pass.m_bCulled)
+			{
+				continue;
+			}
+
+			// Barriers are timed as part of the pass that waits on them
+			uint32_t scope = m_Profiler ? m_Profiler->BeginScope(commandBuffer, pass.m_Name) : GPUProfiler::INVALID_SCOPE;
+
+			if (pass.m_ImageBarrierCount > 0 || pass.m_BufferBarrierCount > 0)
+			{
+				VkDependencyInfo dependencyInfo{};
+				dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+				dependencyInfo.imageMemoryBarrierCount = pass.m_ImageBarrierCount;
+				dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data() + pass.m_FirstImageBarrier;
+				dependencyInfo.bufferMemoryBarrierCount = pass.m_BufferBarrierCount;
+				dependencyInfo.pBufferMemoryBarriers = m_BufferBarriers.data() + pass.m_FirstBufferBarrier;
+
+				vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+			}
+
+			bool bRendering = !pass.m_ColorAttachments.empty() || pass.m_bHasDepth;
+			if (!bRendering)
+			{
+				pass.m_Execute(commandBuffer);
+
+				if (m_Profiler)
+				{
+					m_Profiler->EndScope(commandBuffer, scope);
+				}
+
+				continue;
+			}
+
+			// Contents of transients that nothing reads afterwards don't have to leave tile memory
+			auto getStoreOp = [&](uint32_t resourceIndex)
+				{
+					const Resource& resource = m_Resources[resourceIndex];
+					bool bDiscard = !resource.bImported && resource.LastPass == passIndex;
+					return bDiscard ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+				};
+
+			VkExtent2D renderExtent{ UINT32_MAX, UINT32_MAX };
+
+			colorAttachments.clear();
+			for (const RenderGraphPass::Attachment& attachment : pass.m_ColorAttachments)
+			{
+				const Resource& resource = m_Resources[attachment.Resource];
+
+				VkRenderingAttachmentInfo info{};
+				info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+				info.imageView = resource.View;
+				info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				info.loadOp = attachment.LoadOp;
+				info.storeOp = getStoreOp(attachment.Resource);
+				info.clearValue = attachment.Clear;
+				colorAttachments.push_back(info);
+
+				renderExtent.width = std::min(renderExtent.width, resource.Desc.Width);
+				renderExtent.height = std::min(renderExtent.height, resource.Desc.Height);
+			}
+
+			VkRenderingAttachmentInfo depthAttachment{};
+			if (pass.m_bHasDepth)
+			{
+				const Resource& resource = m_Resources[pass.m_DepthAttachment.Resource];
+
+				depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+				depthAttachment.imageView = resource.View;
+				depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				depthAttachment.loadOp = pass.m_DepthAttachment.LoadOp;
+				depthAttachment.storeOp = getStoreOp(pass.m_DepthAttachment.Resource);
+				depthAttachment.clearValue = pass.m_DepthAttachment.Clear;
+
+				renderExtent.width = std::min(renderExtent.width, resource.Desc.Width);
+				renderExtent.height = std::min(renderExtent.height, resource.Desc.Height);
+			}
+
+			VkRenderingInfo renderingInfo{};
+			renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+			renderingInfo.flags = pass.m_bSecondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+			renderingInfo.renderArea.offset = { 0, 0 };
+			renderingInfo.renderArea.extent = renderExtent;
+			renderingInfo.layerCount = 1;
+			renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+			renderingInfo.pColorAttachments = colorAttachments.data();
+			renderingInfo.pDepthAttachment = pass.m_bHasDepth ? &depthAttachment : nullptr;
+
+			vkCmdBeginRendering(commandBuffer, &renderingInfo);
+			pass.m_Execute(commandBuffer);
+			vkCmdEndRendering(commandBuffer);
+
+			if (m_Profiler)
+			{
+				m_Profiler->EndScope(commandBuffer, scope);
+			}
+		}
+
+		if (!m_FinalBarriers.empty())
+		{
+			VkDependencyInfo dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(m_FinalBarriers.size());
+			dependencyInfo.pImageMemoryBarriers = m_FinalBarriers.data();
+
+			vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+		}
+	}
+
+	VkImage RenderGraph::GetImage(RGHandle texture) const
+	{
+		return texture.Index < m_Resources.size() ? m_Resources[texture.Index].Image : VK_NULL_HANDLE;
+	}
+
+	VkImageView RenderGraph::GetImageView(RGHandle texture) const
+	{
+		return texture.Index < m_Resources.size() ? m_Resources[texture.Index].View : VK_NULL_HANDLE;
+	}
+
+	VkBuffer RenderGraph::GetBuffer(RGHandle buffer) const
+	{
+		return buffer.Index < m_Resources.size() ? m_Resources[buffer.Index].Buffer : VK_NULL_HANDLE;
+	}
+
+	RenderGraph::UsageInfo RenderGraph::GetUsageInfo(RGUsage usage)
+	{
+		switch (usage)
+		{
+		case RGUsage::ColorAttachment:
+			return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT };
+		case RGUsage::DepthAttachment:
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+		case RGUsage::SampledRead:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, SHADER_STAGES, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT };
+		case RGUsage::StorageRead:
+			return { VK_IMAGE_LAYOUT_GENERAL, SHADER_STAGES, VK_ACCESS_2_SHADER_STORAGE_READ_BIT };
+		case RGUsage::StorageWrite:
+			return { VK_IMAGE_LAYOUT_GENERAL, SHADER_STAGES, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT };
+		case RGUsage::TransferSrc:
+			return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT };
+		case RGUsage::TransferDst:
+			return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT };
+		case RGUsage::VertexRead:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT };
+		case RGUsage::IndexRead:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT };
+		case RGUsage::IndirectRead:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT };
+		case RGUsage::UniformRead:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, SHADER_STAGES, VK_ACCESS_2_UNIFORM_READ_BIT };
+		}
+
+		return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT };
+	}
+
+	VkImageUsageFlags RenderGraph::GetImageUsageFlags(RGUsage usage)
+	{
+		switch (usage)
+		{
+		case RGUsage::ColorAttachment:	return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case RGUsage::DepthAttachment:	return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case RGUsage::SampledRead:		return VK_IMAGE_USAGE_SAMPLED_BIT;
+		case RGUsage::StorageRead:
+		case RGUsage::StorageWrite:		return VK_IMAGE_USAGE_STORAGE_BIT;
+		case RGUsage::TransferSrc:		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		case RGUsage::TransferDst:		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		default:						return 0;
+		}
+	}
+
+}
@@ -0,0 +1,250 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+#include "GPUProfiler.h"
+#include "DeletionQueue.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+
+namespace Tempus {
+
+	struct RGHandle
+	{
+		uint32_t Index = UINT32_MAX;
+
+		bool IsValid() const { return Index != UINT32_MAX; }
+	};
+
+	// How a pass uses a resource. Determines layout, pipeline stages and access masks of the generated barriers
+	enum class RGUsage
+	{
+		ColorAttachment,
+		DepthAttachment,
+		SampledRead,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		// Buffer only
+		VertexRead,
+		IndexRead,
+		IndirectRead,
+		UniformRead
+	};
+
+	struct RGTextureDesc
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		// Added on top of the usage flags derived from the passes
+		VkImageUsageFlags ExtraUsage = 0;
+	};
+
+	class RenderGraph;
+
+	class TEMPUS_API RenderGraphPass
+	{
+	public:
+
+		using ExecuteFunc = std::function<void(VkCommandBuffer)>;
+
+		RenderGraphPass& AddColorAttachment(RGHandle texture, VkAttachmentLoadOp loadOp, VkClearColorValue clearColour = {});
+		RenderGraphPass& SetDepthAttachment(RGHandle texture, VkAttachmentLoadOp loadOp, float clearDepth = 1.0f);
+		RenderGraphPass& Read(RGHandle resource, RGUsage usage);
+		RenderGraphPass& Write(RGHandle resource, RGUsage usage);
+		// Passes with side effects (eg. readback) are never culled
+		RenderGraphPass& SetSideEffect() { m_bSideEffect = true; return *this; }
+		// The execute callback only issues vkCmdExecuteCommands with secondary buffers recorded for this pass
+		RenderGraphPass& SetSecondaryCommandBuffers(bool bSecondary = true) { m_bSecondaryCommandBuffers = bSecondary; return *this; }
+
+	private:
+
+		friend class RenderGraph;
+
+		struct Access
+		{
+			uint32_t Resource = 0;
+			RGUsage Usage = RGUsage::SampledRead;
+			bool bRead = false;
+			bool bWrite = false;
+			// Attachments that are cleared or don't care about their previous contents end the previous writers' relevance
+			bool bOverwrite = false;
+		};
+
+		struct Attachment
+		{
+			uint32_t Resource = 0;
+			VkAttachmentLoadOp LoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			VkClearValue Clear{};
+		};
+
+		std::string m_Name;
+		ExecuteFunc m_Execute;
+		std::vector<Access> m_Accesses;
+		std::vector<Attachment> m_ColorAttachments;
+		Attachment m_DepthAttachment;
+		bool m_bHasDepth = false;
+		bool m_bSideEffect = false;
+		bool m_bSecondaryCommandBuffers = false;
+
+		// Compile results
+		bool m_bCulled = false;
+		uint32_t m_FirstImageBarrier = 0;
+		uint32_t m_ImageBarrierCount = 0;
+		uint32_t m_FirstBufferBarrier = 0;
+		uint32_t m_BufferBarrierCount = 0;
+
+	};
+
+	// Frame graph rebuilt every frame. Passes declare what they read and write, Compile() culls passes that don't
+	// contribute to an exported resource, derives the barriers and layout transitions between passes and places
+	// transient textures with non-overlapping lifetimes in the same memory
+	class TEMPUS_API RenderGraph
+	{
+	public:
+
+		RenderGraph() = default;
+		~RenderGraph();
+
+		// With a deletion queue, transient textures replaced by a layout change are destroyed once the frames using
+		// them complete. Without one the device is waited on
+		bool Init(VkDevice device, GPUAllocator* allocator, DeletionQueue* deletionQueue = nullptr);
+		void Shutdown();
+
+		// Clears all passes and resources of the previous frame. Physical transient resources are kept for reuse
+		void Reset();
+
+		// Imported textures live outside the graph. A final layout other than undefined exports the texture, which keeps
+		// the passes writing it alive. initialStage is the stage the incoming layout/contents become available in
+		RGHandle ImportTexture(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+			VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags2 initialStage = VK_PIPELINE_STAGE_2_NONE);
+		// previousStages are the stages in which earlier submissions on this queue may still access the buffer.
+		// The first write of the frame waits for them, which keeps buffers reused every frame free of WAR hazards
+		RGHandle ImportBuffer(const char* name, VkBuffer buffer, VkDeviceSize size, bool bExported = false,
+			VkPipelineStageFlags2 previousStages = VK_PIPELINE_STAGE_2_NONE);
+		RGHandle CreateTexture(const char* name, const RGTextureDesc& desc);
+
+		RenderGraphPass& AddPass(const char* name, RenderGraphPass::ExecuteFunc execute);
+
+		bool Compile();
+		void Execute(VkCommandBuffer commandBuffer);
+
+		// Wraps every executed pass in a GPU timing scope named after the pass. nullptr disables it
+		void SetProfiler(GPUProfiler* profiler) { m_Profiler = profiler; }
+
+		VkImage GetImage(RGHandle texture) const;
+		VkImageView GetImageView(RGHandle texture) const;
+		VkBuffer GetBuffer(RGHandle buffer) const;
+
+	private:
+
+		enum class ResourceType { Texture, Buffer };
+
+		struct ResourceState
+		{
+			VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			// Last write, which later reads and writes have to wait for
+			VkPipelineStageFlags2 WriteStages = VK_PIPELINE_STAGE_2_NONE;
+			VkAccessFlags2 WriteAccess = VK_ACCESS_2_NONE;
+			// Stages that read since the last write and already see it. Later writes have to wait for them
+			VkPipelineStageFlags2 ReadStages = VK_PIPELINE_STAGE_2_NONE;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			ResourceType Type = ResourceType::Texture;
+			bool bImported = false;
+			bool bExported = false;
+
+			RGTextureDesc Desc;
+			VkImageUsageFlags Usage = 0;
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			VkDeviceSize BufferSize = 0;
+
+			ResourceState State;
+
+			// Compile results
+			uint32_t FirstPass = UINT32_MAX;
+			uint32_t LastPass = 0;
+			uint32_t Physical = UINT32_MAX;
+			// Transient that occupied the same memory before this one during the frame
+			uint32_t AliasPredecessor = UINT32_MAX;
+		};
+
+		// Transient image backed by a memory slot that may be shared with other images
+		struct PhysicalTexture
+		{
+			VkImage Image = VK_NULL_HANDLE;
+			VkImageView View = VK_NULL_HANDLE;
+			VkMemoryRequirements Requirements{};
+			uint32_t Slot = UINT32_MAX;
+			// Physical texture placed in the same slot before this one, whose last use the aliasing barrier waits for
+			uint32_t PreviousOccupant = UINT32_MAX;
+		};
+
+		struct MemorySlot
+		{
+			VkDeviceSize Size = 0;
+			VkDeviceSize Alignment = 1;
+			uint32_t MemoryTypeBits = ~0u;
+			uint32_t LastPass = 0;
+			GPUAllocation Allocation;
+		};
+
+		struct UsageInfo
+		{
+			VkImageLayout Layout;
+			VkPipelineStageFlags2 Stages;
+			VkAccessFlags2 Access;
+		};
+
+		static UsageInfo GetUsageInfo(RGUsage usage);
+		static VkImageUsageFlags GetImageUsageFlags(RGUsage usage);
+
+		void CullPasses();
+		void ComputeLifetimes();
+		bool RealizeTransients();
+		// bDeferred hands the textures and their memory to the deletion queue instead of destroying them now
+		void DestroyTransients(bool bDeferred = false);
+		void BuildBarriers();
+		void AddBarrier(uint32_t resource, const UsageInfo& usage, bool bWrite);
+		void PushBarrier(const Resource& resource, VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+			VkImageLayout newLayout, VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess, std::vector<VkImageMemoryBarrier2>& imageBarriers);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+		DeletionQueue* m_DeletionQueue = nullptr;
+		GPUProfiler* m_Profiler = nullptr;
+
+		std::vector<Resource> m_Resources;
+		// Deque so the references returned by AddPass stay valid while more passes are added
+		std::deque<RenderGraphPass> m_Passes;
+
+		std::vector<VkImageMemoryBarrier2> m_ImageBarriers;
+		std::vector<VkBufferMemoryBarrier2> m_BufferBarriers;
+		// Transitions of exported resources into their final layout, recorded after the last pass
+		std::vector<VkImageMemoryBarrier2> m_FinalBarriers;
+
+		// Transient resources survive between frames as long as the graph's transient layout doesn't change
+		size_t m_TransientHash = 0;
+		std::vector<PhysicalTexture> m_PhysicalTextures;
+		std::vector<MemorySlot> m_MemorySlots;
+
+	};
+
+}
@@ -0,0 +1,298 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "RenderQueue.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace Tempus {
+
+	uint64_t RenderKey::Encode(uint32_t pass, bool bTranslucent, uint32_t pipeline, uint32_t material, uint32_t depthBucket)
+	{
+		uint64_t passBits = static_cast<uint64_t>(pass & (MAX_PASSES - 1)) << 60;
+		uint64_t pipelineBits = pipeline & (MAX_PIPELINES - 1);
+		uint64_t materialBits = material & (MAX_MATERIALS - 1);
+		uint64_t depthBits = depthBucket & MAX_DEPTH_BUCKET;
+
+		if (!bTranslucent)
+		{
+			return passBits | pipelineBits << 45 | materialBits << 24 | depthBits;
+		}
+
+		// Far draws first, so blending composites them in the right order
+		uint64_t invertedDepth = MAX_DEPTH_BUCKET - depthBits;
+		return passBits | 1ull << 59 | invertedDepth << 35 | pipelineBits << 21 | materialBits;
+	}
+
+	uint32_t RenderKey::GetDepthBucket(float viewDepth, float zNear, float zFar)
+	{
+		float t = (viewDepth - zNear) / (zFar - zNear);
+		t = std::clamp(t, 0.0f, 1.0f);
+
+		return static_cast<uint32_t>(t * MAX_DEPTH_BUCKET);
+	}
+
+	uint32_t RenderQueue::RegisterPipeline(const PipelineKey& key)
+	{
+		auto it = std::find(m_Pipelines.begin(), m_Pipelines.end(), key);
+		if (it != m_Pipelines.end())
+		{
+			return static_cast<uint32_t>(it - m_Pipelines.begin());
+		}
+
+		if (m_Pipelines.size() >= RenderKey::MAX_PIPELINES)
+		{
+			TPS_CORE_ERROR("Render queue is out of pipeline IDs!");
+			return INVALID_ID;
+		}
+
+		m_Pipelines.push_back(key);
+		return static_cast<uint32_t>(m_Pipelines.size() - 1);
+	}
+
+	uint32_t RenderQueue::RegisterMaterial(const RenderMaterial& material)
+	{
+		if (m_Materials.size() >= RenderKey::MAX_MATERIALS)
+		{
+			TPS_CORE_ERROR("Render queue is out of material IDs!");
+			return INVALID_ID;
+		}
+
+		m_Materials.push_back(material);
+		return static_cast<uint32_t>(m_Materials.size() - 1);
+	}
+
+	void RenderQueue::UpdateMaterial(uint32_t material, const RenderMaterial& data)
+	{
+		if (material < m_Materials.size())
+		{
+			m_Materials[material] = data;
+		}
+	}
+
+	void RenderQueue::SetAttachmentFormats(VkFormat colorFormat, VkFormat depthFormat)
+	{
+		m_ColorFormat = colorFormat;
+		m_DepthFormat = depthFormat;
+	}
+
+	void RenderQueue::Reset()
+	{
+		m_Draws.clear();
+		m_Entries.clear();
+		m_Stats = RenderQueueStats();
+	}
+
+	void RenderQueue::Submit(uint64_t key, const QueuedDraw& draw)
+	{
+		m_Entries.push_back({ key, static_cast<uint32_t>(m_Draws.size()) });
+		m_Draws.push_back(draw);
+	}
+
+	void RenderQueue::Submit(uint32_t pass, bool bTranslucent, uint32_t depthBucket, const QueuedDraw& draw)
+	{
+		Submit(RenderKey::Encode(pass, bTranslucent, draw.Pipeline, draw.Material, depthBucket), draw);
+	}
+
+	void RenderQueue::Sort()
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+
+		RadixSort(m_Entries, m_Scratch);
+
+		m_Stats.SortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void RenderQueue::Record(VkCommandBuffer commandBuffer, PipelineStateCache& pipelineStates)
+	{
+		uint32_t boundPipeline = INVALID_ID;
+		uint32_t boundMaterial = INVALID_ID;
+		VkPipelineLayout boundLayout = VK_NULL_HANDLE;
+		VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+		VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+		for (const SortEntry& entry : m_Entries)
+		{
+			const QueuedDraw& draw = m_Draws[entry.Index];
+
+			if (draw.Pipeline != boundPipeline)
+			{
+				PipelineKey key = m_Pipelines[draw.Pipeline];
+				key.ColorFormat = m_ColorFormat;
+				key.DepthFormat = m_DepthFormat;
+
+				pipelineStates.Bind(commandBuffer, key);
+				boundPipeline = draw.Pipeline;
+				m_Stats.PipelineBinds++;
+
+				// Sets and push constants survive a pipeline change only while the layouts stay compatible
+				VkPipelineLayout layout = pipelineStates.GetLayout(key.Program);
+				if (layout != boundLayout)
+				{
+					boundLayout = layout;
+					boundMaterial = INVALID_ID;
+				}
+			}
+			else
+			{
+				m_Stats.PipelineBindsAvoided++;
+			}
+
+			if (draw.Material != boundMaterial)
+			{
+				const RenderMaterial& material = m_Materials[draw.Material];
+
+				if (material.DescriptorSet != VK_NULL_HANDLE)
+				{
+					vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, material.Layout, material.FirstSet, 1,
+						&material.DescriptorSet, 0, nullptr);
+				}
+
+				if (material.PushConstantSize > 0)
+				{
+					vkCmdPushConstants(commandBuffer, material.Layout, material.PushConstantStages, material.PushConstantOffset,
+						material.PushConstantSize, material.PushConstants);
+				}
+
+				boundMaterial = draw.Material;
+				m_Stats.MaterialBinds++;
+			}
+			else
+			{
+				m_Stats.MaterialBindsAvoided++;
+			}
+
+			if (draw.VertexBuffer != boundVertexBuffer || draw.IndexBuffer != boundIndexBuffer)
+			{
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.VertexBuffer, &offset);
+				vkCmdBindIndexBuffer(commandBuffer, draw.IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+				boundVertexBuffer = draw.VertexBuffer;
+				boundIndexBuffer = draw.IndexBuffer;
+				m_Stats.BufferBinds++;
+			}
+			else
+			{
+				m_Stats.BufferBindsAvoided++;
+			}
+
+			vkCmdDrawIndexed(commandBuffer, draw.IndexCount, draw.InstanceCount, draw.FirstIndex, draw.VertexOffset, draw.FirstInstance);
+			m_Stats.DrawCount++;
+		}
+	}
+
+	void RenderQueue::RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+	{
+		constexpr uint32_t DIGIT_COUNT = sizeof(uint64_t);
+		constexpr uint32_t RADIX = 256;
+
+		size_t count = entries.size();
+		if (count < 2)
+		{
+			return;
+		}
+
+		scratch.resize(count);
+
+		// Every digit's histogram in a single read of the keys
+		uint32_t histograms[DIGIT_COUNT][RADIX] = {};
+
+		for (const SortEntry& entry : entries)
+		{
+			for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++)
+			{
+				histograms[digit][(entry.Key >> (digit * 8)) & 0xFF]++;
+			}
+		}
+
+		SortEntry* source = entries.data();
+		SortEntry* destination = scratch.data();
+
+		for (uint32_t digit = 0; digit < DIGIT_COUNT; digit++)
+		{
+			uint32_t* histogram = histograms[digit];
+
+			// All keys share this byte, the pass wouldn't move anything
+			if (histogram[(source[0].Key >> (digit * 8)) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < RADIX; bucket++)
+			{
+				uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				const SortEntry& entry = source[i];
+				destination[histogram[(entry.Key >> (digit * 8)) & 0xFF]++] = entry;
+			}
+
+			std::swap(source, destination);
+		}
+
+		if (source != entries.data())
+		{
+			entries.swap(scratch);
+		}
+	}
+
+	void RenderQueue::RunSortBenchmark(uint32_t keyCount)
+	{
+		constexpr uint32_t ITERATIONS = 10;
+
+		// A frame's worth of draws: a few passes and pipelines, many materials, depth all over the place
+		std::mt19937_64 gen(1234);
+		std::uniform_int_distribution<uint32_t> pass(0, 3);
+		std::uniform_int_distribution<uint32_t> pipeline(0, 63);
+		std::uniform_int_distribution<uint32_t> material(0, 4095);
+		std::uniform_int_distribution<uint32_t> depth(0, RenderKey::MAX_DEPTH_BUCKET);
+		std::uniform_int_distribution<uint32_t> translucent(0, 9);
+
+		std::vector<SortEntry> keys(keyCount);
+		for (uint32_t i = 0; i < keyCount; i++)
+		{
+			keys[i].Key = RenderKey::Encode(pass(gen), translucent(gen) == 0, pipeline(gen), material(gen), depth(gen));
+			keys[i].Index = i;
+		}
+
+		std::vector<SortEntry> entries;
+		std::vector<SortEntry> scratch;
+		double radixTime = 0.0;
+		double stdTime = 0.0;
+
+		for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++)
+		{
+			entries = keys;
+			auto start = std::chrono::high_resolution_clock::now();
+			RadixSort(entries, scratch);
+			radixTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		bool bSorted = std::is_sorted(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) { return a.Key < b.Key; });
+
+		for (uint32_t iteration = 0; iteration < ITERATIONS; iteration++)
+		{
+			entries = keys;
+			auto start = std::chrono::high_resolution_clock::now();
+			std::sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b) { return a.Key < b.Key; });
+			stdTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		radixTime /= ITERATIONS;
+		stdTime /= ITERATIONS;
+
+		TPS_CORE_INFO("Sort benchmark, {0} keys averaged over {1} runs:", keyCount, ITERATIONS);
+		TPS_CORE_INFO("\tRadix sort: {0:.3f} ms ({1:.1f} M keys/s){2}", radixTime, keyCount / (radixTime * 1000.0),
+			bSorted ? "" : " NOT SORTED");
+		TPS_CORE_INFO("\tstd::sort:  {0:.3f} ms ({1:.1f} M keys/s)", stdTime, keyCount / (stdTime * 1000.0));
+	}
+
+}
@@ -0,0 +1,140 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "PipelineStateCache.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+
+namespace Tempus {
+
+	// Packs the state a draw needs into 64 bits so that sorting the keys groups draws by their state, most expensive
+	// change first. Opaque draws sort front to back within a material, translucent ones back to front above everything
+	// else of their pass
+	//
+	//   Opaque:      pass:4 | 0 | pipeline:14 | material:21 | depth:24
+	//   Translucent: pass:4 | 1 | inverted depth:24 | pipeline:14 | material:21
+	struct RenderKey
+	{
+		static constexpr uint32_t PASS_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 14;
+		static constexpr uint32_t MATERIAL_BITS = 21;
+		static constexpr uint32_t DEPTH_BITS = 24;
+
+		static constexpr uint32_t MAX_PASSES = 1u << PASS_BITS;
+		static constexpr uint32_t MAX_PIPELINES = 1u << PIPELINE_BITS;
+		static constexpr uint32_t MAX_MATERIALS = 1u << MATERIAL_BITS;
+		static constexpr uint32_t MAX_DEPTH_BUCKET = (1u << DEPTH_BITS) - 1;
+
+		// Fields past their bit count are masked
+		static uint64_t Encode(uint32_t pass, bool bTranslucent, uint32_t pipeline, uint32_t material, uint32_t depthBucket);
+
+		// Linear in view depth between the clip planes, clamped
+		static uint32_t GetDepthBucket(float viewDepth, float zNear, float zFar);
+	};
+
+	// Descriptor sets and push constants bound together, identified by a material ID
+	struct RenderMaterial
+	{
+		static constexpr uint32_t MAX_PUSH_CONSTANTS = 64;
+
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		// Bound at FirstSet when not null
+		VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+		uint32_t FirstSet = 0;
+
+		VkShaderStageFlags PushConstantStages = 0;
+		uint32_t PushConstantOffset = 0;
+		uint32_t PushConstantSize = 0;
+		uint8_t PushConstants[MAX_PUSH_CONSTANTS] = {};
+	};
+
+	// One indexed draw. Pipeline and Material are IDs returned by the queue's Register functions
+	struct QueuedDraw
+	{
+		uint32_t Pipeline = 0;
+		uint32_t Material = 0;
+
+		VkBuffer VertexBuffer = VK_NULL_HANDLE;
+		VkBuffer IndexBuffer = VK_NULL_HANDLE;
+		uint32_t IndexCount = 0;
+		uint32_t InstanceCount = 1;
+		uint32_t FirstIndex = 0;
+		int32_t VertexOffset = 0;
+		uint32_t FirstInstance = 0;
+	};
+
+	struct RenderQueueStats
+	{
+		uint32_t DrawCount = 0;
+		uint32_t PipelineBinds = 0;
+		uint32_t PipelineBindsAvoided = 0;
+		uint32_t MaterialBinds = 0;
+		uint32_t MaterialBindsAvoided = 0;
+		uint32_t BufferBinds = 0;
+		uint32_t BufferBindsAvoided = 0;
+		double SortMilliseconds = 0.0;
+	};
+
+	// Draws of one pass, sorted by RenderKey before recording. Recording walks the sorted draws and only binds the
+	// pipeline, material and geometry buffers when they differ from the previous draw's
+	class TEMPUS_API RenderQueue
+	{
+	public:
+
+		struct SortEntry
+		{
+			uint64_t Key = 0;
+			uint32_t Index = 0;
+		};
+
+		static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+		// Pipelines are bound through the pipeline state cache. The key's attachment formats are replaced by the
+		// queue's, see SetAttachmentFormats(). Registering an equal key again returns the same ID
+		uint32_t RegisterPipeline(const PipelineKey& key);
+		uint32_t RegisterMaterial(const RenderMaterial& material);
+		void UpdateMaterial(uint32_t material, const RenderMaterial& data);
+
+		// The formats of the pass the queue is recorded into
+		void SetAttachmentFormats(VkFormat colorFormat, VkFormat depthFormat);
+
+		// Clears the draws and the stats, registered pipelines and materials are kept
+		void Reset();
+
+		void Submit(uint64_t key, const QueuedDraw& draw);
+		// Builds the key from the draw's pipeline and material
+		void Submit(uint32_t pass, bool bTranslucent, uint32_t depthBucket, const QueuedDraw& draw);
+
+		void Sort();
+		// Records the sorted draws. Viewport, scissor and anything shared by all draws are left to the caller
+		void Record(VkCommandBuffer commandBuffer, PipelineStateCache& pipelineStates);
+
+		uint32_t GetDrawCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+		const RenderQueueStats& GetStats() const { return m_Stats; }
+
+		// Stable LSD radix sort by key, one byte per pass. Passes over bytes that every key shares are skipped, which
+		// is most of them when the upper fields only take a few values. Leaves the result in entries
+		static void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+		// Sorts keyCount keys shaped like a frame's draws with RadixSort and std::sort and logs both times
+		static void RunSortBenchmark(uint32_t keyCount);
+
+	private:
+
+		std::vector<PipelineKey> m_Pipelines;
+		std::vector<RenderMaterial> m_Materials;
+		VkFormat m_ColorFormat = VK_FORMAT_UNDEFINED;
+		VkFormat m_DepthFormat = VK_FORMAT_UNDEFINED;
+
+		std::vector<QueuedDraw> m_Draws;
+		std::vector<SortEntry> m_Entries;
+		std::vector<SortEntry> m_Scratch;
+
+		RenderQueueStats m_Stats;
+
+	};
+
+}
@@ -0,0 +1,765 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "ShaderReflection.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <map>
+
+namespace Tempus {
+
+	namespace {
+
+		// The subset of the SPIR-V specification the reflection needs
+		enum SpvOp : uint32_t
+		{
+			SpvOpEntryPoint = 15,
+			SpvOpTypeBool = 20,
+			SpvOpTypeInt = 21,
+			SpvOpTypeFloat = 22,
+			SpvOpTypeVector = 23,
+			SpvOpTypeMatrix = 24,
+			SpvOpTypeImage = 25,
+			SpvOpTypeSampler = 26,
+			SpvOpTypeSampledImage = 27,
+			SpvOpTypeArray = 28,
+			SpvOpTypeRuntimeArray = 29,
+			SpvOpTypeStruct = 30,
+			SpvOpTypePointer = 32,
+			SpvOpTypeForwardPointer = 39,
+			SpvOpConstant = 43,
+			SpvOpVariable = 59,
+			SpvOpDecorate = 71,
+			SpvOpMemberDecorate = 72,
+			SpvOpTypeAccelerationStructure = 5341
+		};
+
+		enum SpvDecoration : uint32_t
+		{
+			SpvDecorationBlock = 2,
+			SpvDecorationBufferBlock = 3,
+			SpvDecorationArrayStride = 6,
+			SpvDecorationMatrixStride = 7,
+			SpvDecorationBuiltIn = 11,
+			SpvDecorationLocation = 30,
+			SpvDecorationBinding = 33,
+			SpvDecorationDescriptorSet = 34,
+			SpvDecorationOffset = 35
+		};
+
+		enum SpvStorageClass : uint32_t
+		{
+			SpvStorageClassUniformConstant = 0,
+			SpvStorageClassInput = 1,
+			SpvStorageClassUniform = 2,
+			SpvStorageClassPushConstant = 9,
+			SpvStorageClassStorageBuffer = 12,
+			SpvStorageClassPhysicalStorageBuffer = 5349
+		};
+
+		enum SpvDim : uint32_t
+		{
+			SpvDimBuffer = 5,
+			SpvDimSubpassData = 6
+		};
+
+		constexpr uint32_t INVALID = UINT32_MAX;
+		constexpr uint32_t HEADER_WORDS = 5;
+		// Guards against malformed modules with cyclic types
+		constexpr uint32_t MAX_TYPE_DEPTH = 32;
+
+		struct SpvId
+		{
+			uint32_t Opcode = 0;
+			// Word index of the defining instruction
+			uint32_t Instruction = 0;
+			uint32_t StorageClass = INVALID;
+			uint64_t Constant = 0;
+
+			uint32_t Set = INVALID;
+			uint32_t Binding = INVALID;
+			uint32_t Location = INVALID;
+			uint32_t ArrayStride = 0;
+			bool bBuiltIn = false;
+			bool bBlock = false;
+			bool bBufferBlock = false;
+
+			std::vector<uint32_t> MemberOffsets;
+			std::vector<uint32_t> MemberMatrixStrides;
+		};
+
+		class SpvModule
+		{
+		public:
+
+			bool Parse(ShaderCode code)
+			{
+				m_Words = code.Words;
+
+				uint32_t bound = m_Words[3];
+				m_Ids.resize(bound);
+
+				for (size_t i = HEADER_WORDS; i < code.WordCount;)
+				{
+					uint32_t wordCount = m_Words[i] >> 16;
+					uint32_t opcode = m_Words[i] & 0xFFFF;
+
+					if (wordCount == 0 || i + wordCount > code.WordCount)
+					{
+						return false;
+					}
+
+					const uint32_t* operands = &m_Words[i + 1];
+
+					switch (opcode)
+					{
+					case SpvOpEntryPoint:
+						if (m_ExecutionModel != INVALID)
+						{
+							TPS_CORE_ERROR("Shader reflection only supports modules with one entry point");
+							return false;
+						}
+						m_ExecutionModel = operands[0];
+						break;
+
+					case SpvOpDecorate:
+						if (!IsValidId(operands[0]))
+						{
+							return false;
+						}
+						Decorate(m_Ids[operands[0]], operands[1], wordCount > 3 ? operands[2] : 0);
+						break;
+
+					case SpvOpMemberDecorate:
+						if (!IsValidId(operands[0]) || wordCount < 5)
+						{
+							break;
+						}
+						MemberDecorate(m_Ids[operands[0]], operands[1], operands[2], operands[3]);
+						break;
+
+					case SpvOpTypeBool:
+					case SpvOpTypeInt:
+					case SpvOpTypeFloat:
+					case SpvOpTypeVector:
+					case SpvOpTypeMatrix:
+					case SpvOpTypeImage:
+					case SpvOpTypeSampler:
+					case SpvOpTypeSampledImage:
+					case SpvOpTypeArray:
+					case SpvOpTypeRuntimeArray:
+					case SpvOpTypeStruct:
+					case SpvOpTypeAccelerationStructure:
+						if (!Define(operands[0], opcode, i))
+						{
+							return false;
+						}
+						break;
+
+					case SpvOpTypePointer:
+						if (!Define(operands[0], opcode, i))
+						{
+							return false;
+						}
+						m_Ids[operands[0]].StorageClass = operands[1];
+						break;
+
+					case SpvOpTypeForwardPointer:
+						// The pointer itself is defined later, only its storage class is needed for sizing
+						if (!IsValidId(operands[0]))
+						{
+							return false;
+						}
+						m_Ids[operands[0]].StorageClass = operands[1];
+						break;
+
+					case SpvOpConstant:
+						if (!Define(operands[1], opcode, i))
+						{
+							return false;
+						}
+						m_Ids[operands[1]].Constant = operands[2] | (wordCount > 4 ? static_cast<uint64_t>(operands[3]) << 32 : 0);
+						break;
+
+					case SpvOpVariable:
+						if (!Define(operands[1], opcode, i))
+						{
+							return false;
+						}
+						m_Ids[operands[1]].StorageClass = operands[2];
+						m_Variables.push_back(operands[1]);
+						break;
+					}
+
+					i += wordCount;
+				}
+
+				return m_ExecutionModel != INVALID;
+			}
+
+			uint32_t GetExecutionModel() const { return m_ExecutionModel; }
+			const std::vector<uint32_t>& GetVariables() const { return m_Variables; }
+
+			const SpvId& Get(uint32_t id) const
+			{
+				static const SpvId invalid;
+				return IsValidId(id) ? m_Ids[id] : invalid;
+			}
+
+			// Operand index counts from the first word after the opcode
+			uint32_t Operand(uint32_t id, uint32_t index) const
+			{
+				const SpvId& spvId = Get(id);
+				if (spvId.Opcode == 0 || index + 1 >= (m_Words[spvId.Instruction] >> 16))
+				{
+					return INVALID;
+				}
+
+				return m_Words[spvId.Instruction + 1 + index];
+			}
+
+			uint32_t OperandCount(uint32_t id) const
+			{
+				const SpvId& spvId = Get(id);
+				return spvId.Opcode == 0 ? 0 : (m_Words[spvId.Instruction] >> 16) - 1;
+			}
+
+			// Pointee of a variable's pointer type
+			uint32_t GetVariableType(uint32_t variable) const
+			{
+				return Operand(Operand(variable, 0), 2);
+			}
+
+			uint32_t GetTypeSize(uint32_t type, uint32_t matrixStride = 0, uint32_t depth = 0) const
+			{
+				const SpvId& spvId = Get(type);
+				if (depth > MAX_TYPE_DEPTH)
+				{
+					return 0;
+				}
+
+				switch (spvId.Opcode)
+				{
+				case SpvOpTypeBool:
+					return 4;
+				case SpvOpTypeInt:
+				case SpvOpTypeFloat:
+					return Operand(type, 1) / 8;
+				case SpvOpTypeVector:
+					return Operand(type, 2) * GetTypeSize(Operand(type, 1), 0, depth + 1);
+				case SpvOpTypeMatrix:
+				{
+					uint32_t columns = Operand(type, 2);
+					return columns * (matrixStride > 0 ? matrixStride : GetTypeSize(Operand(type, 1), 0, depth + 1));
+				}
+				case SpvOpTypeArray:
+				{
+					uint32_t length = static_cast<uint32_t>(Get(Operand(type, 2)).Constant);
+					uint32_t stride = spvId.ArrayStride > 0 ? spvId.ArrayStride : GetTypeSize(Operand(type, 1), matrixStride, depth + 1);
+					return length * stride;
+				}
+				case SpvOpTypeStruct:
+				{
+					uint32_t size = 0;
+					for (uint32_t member = 0; member + 1 < OperandCount(type); member++)
+					{
+						uint32_t offset = member < spvId.MemberOffsets.size() ? spvId.MemberOffsets[member] : size;
+						uint32_t memberStride = member < spvId.MemberMatrixStrides.size() ? spvId.MemberMatrixStrides[member] : 0;
+						size = std::max(size, offset + GetTypeSize(Operand(type, member + 1), memberStride, depth + 1));
+					}
+					return size;
+				}
+				case SpvOpTypePointer:
+					// Buffer device addresses, everything else has no size
+					return spvId.StorageClass == SpvStorageClassPhysicalStorageBuffer ? 8 : 0;
+				default:
+					return 0;
+				}
+			}
+
+			// Largest scalar in the type
+			uint32_t GetScalarAlignment(uint32_t type, uint32_t depth = 0) const
+			{
+				const SpvId& spvId = Get(type);
+				if (depth > MAX_TYPE_DEPTH)
+				{
+					return 1;
+				}
+
+				switch (spvId.Opcode)
+				{
+				case SpvOpTypeBool:
+					return 4;
+				case SpvOpTypeInt:
+				case SpvOpTypeFloat:
+					return Operand(type, 1) / 8;
+				case SpvOpTypeVector:
+				case SpvOpTypeMatrix:
+				case SpvOpTypeArray:
+				case SpvOpTypeRuntimeArray:
+					return GetScalarAlignment(Operand(type, 1), depth + 1);
+				case SpvOpTypeStruct:
+				{
+					uint32_t alignment = 1;
+					for (uint32_t member = 0; member + 1 < OperandCount(type); member++)
+					{
+						alignment = std::max(alignment, GetScalarAlignment(Operand(type, member + 1), depth + 1));
+					}
+					return alignment;
+				}
+				case SpvOpTypePointer:
+					return 8;
+				default:
+					return 1;
+				}
+			}
+
+		private:
+
+			bool IsValidId(uint32_t id) const { return id < m_Ids.size(); }
+
+			bool Define(uint32_t id, uint32_t opcode, size_t instruction)
+			{
+				if (!IsValidId(id))
+				{
+					return false;
+				}
+
+				m_Ids[id].Opcode = opcode;
+				m_Ids[id].Instruction = static_cast<uint32_t>(instruction);
+				return true;
+			}
+
+			static void Decorate(SpvId& id, uint32_t decoration, uint32_t value)
+			{
+				switch (decoration)
+				{
+				case SpvDecorationBlock: id.bBlock = true; break;
+				case SpvDecorationBufferBlock: id.bBufferBlock = true; break;
+				case SpvDecorationArrayStride: id.ArrayStride = value; break;
+				case SpvDecorationBuiltIn: id.bBuiltIn = true; break;
+				case SpvDecorationLocation: id.Location = value; break;
+				case SpvDecorationBinding: id.Binding = value; break;
+				case SpvDecorationDescriptorSet: id.Set = value; break;
+				}
+			}
+
+			static void MemberDecorate(SpvId& id, uint32_t member, uint32_t decoration, uint32_t value)
+			{
+				std::vector<uint32_t>* target = nullptr;
+
+				switch (decoration)
+				{
+				case SpvDecorationOffset: target = &id.MemberOffsets; break;
+				case SpvDecorationMatrixStride: target = &id.MemberMatrixStrides; break;
+				default: return;
+				}
+
+				if (target->size() <= member)
+				{
+					target->resize(member + 1, 0);
+				}
+
+				(*target)[member] = value;
+			}
+
+		private:
+
+			const uint32_t* m_Words = nullptr;
+			std::vector<SpvId> m_Ids;
+			std::vector<uint32_t> m_Variables;
+			uint32_t m_ExecutionModel = INVALID;
+
+		};
+
+		VkShaderStageFlagBits ToShaderStage(uint32_t executionModel)
+		{
+			switch (executionModel)
+			{
+			case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+			default: return VK_SHADER_STAGE_ALL;
+			}
+		}
+
+		VkDescriptorType ToDescriptorType(const SpvModule& module, uint32_t type, uint32_t storageClass)
+		{
+			const SpvId& spvId = module.Get(type);
+
+			switch (spvId.Opcode)
+			{
+			case SpvOpTypeSampler:
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+			case SpvOpTypeSampledImage:
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			case SpvOpTypeImage:
+			{
+				uint32_t dim = module.Operand(type, 2);
+				bool bStorage = module.Operand(type, 6) == 2;
+
+				if (dim == SpvDimSubpassData)
+				{
+					return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+
+				if (dim == SpvDimBuffer)
+				{
+					return bStorage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+
+				return bStorage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			}
+			case SpvOpTypeAccelerationStructure:
+				return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			case SpvOpTypeStruct:
+				if (storageClass == SpvStorageClassStorageBuffer || spvId.bBufferBlock)
+				{
+					return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				}
+				// Uniform data comes from the UniformAllocator, which binds it with dynamic offsets
+				return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			default:
+				return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			}
+		}
+
+		// 32 bit scalars and vectors only, which covers every vertex input the engine uses
+		VkFormat ToVertexFormat(const SpvModule& module, uint32_t type, uint32_t& outSize)
+		{
+			static constexpr VkFormat floatFormats[4] =
+				{ VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+			static constexpr VkFormat intFormats[4] =
+				{ VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+			static constexpr VkFormat uintFormats[4] =
+				{ VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+			uint32_t components = 1;
+			uint32_t scalar = type;
+
+			if (module.Get(type).Opcode == SpvOpTypeVector)
+			{
+				scalar = module.Operand(type, 1);
+				components = module.Operand(type, 2);
+			}
+
+			const SpvId& scalarId = module.Get(scalar);
+			if (components < 1 || components > 4 || module.Operand(scalar, 1) != 32)
+			{
+				return VK_FORMAT_UNDEFINED;
+			}
+
+			outSize = components * 4;
+
+			if (scalarId.Opcode == SpvOpTypeFloat)
+			{
+				return floatFormats[components - 1];
+			}
+
+			if (scalarId.Opcode == SpvOpTypeInt)
+			{
+				return module.Operand(scalar, 2) != 0 ? intFormats[components - 1] : uintFormats[components - 1];
+			}
+
+			return VK_FORMAT_UNDEFINED;
+		}
+
+	}
+
+	VkPipelineVertexInputStateCreateInfo ReflectedVertexLayout::GetCreateInfo() const
+	{
+		VkPipelineVertexInputStateCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+		if (!Attributes.empty())
+		{
+			createInfo.vertexBindingDescriptionCount = 1;
+			createInfo.pVertexBindingDescriptions = &Binding;
+			createInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(Attributes.size());
+			createInfo.pVertexAttributeDescriptions = Attributes.data();
+		}
+
+		return createInfo;
+	}
+
+	void ReflectedPipelineLayout::Destroy(VkDevice device)
+	{
+		if (Layout != VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineLayout(device, Layout, nullptr);
+		}
+
+		for (VkDescriptorSetLayout setLayout : SetLayouts)
+		{
+			if (!bSharedSetLayouts)
+			{
+				vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+			}
+		}
+
+		Layout = VK_NULL_HANDLE;
+		SetLayouts.clear();
+		bSharedSetLayouts = false;
+		PushConstantStages = 0;
+		PushConstantSize = 0;
+	}
+
+	bool ShaderReflection::Reflect(ShaderCode code)
+	{
+		m_Bindings.clear();
+		m_VertexInputs.clear();
+		m_PushConstantSize = 0;
+
+		SpvModule module;
+		if (!code.IsValid() || !module.Parse(code))
+		{
+			TPS_CORE_ERROR("Failed to parse SPIR-V module for reflection!");
+			return false;
+		}
+
+		m_Stage = ToShaderStage(module.GetExecutionModel());
+		if (m_Stage == VK_SHADER_STAGE_ALL)
+		{
+			TPS_CORE_ERROR("Unsupported shader execution model {0}", module.GetExecutionModel());
+			return false;
+		}
+
+		for (uint32_t variable : module.GetVariables())
+		{
+			const SpvId& spvId = module.Get(variable);
+			uint32_t type = module.GetVariableType(variable);
+
+			switch (spvId.StorageClass)
+			{
+			case SpvStorageClassPushConstant:
+			{
+				uint32_t alignment = module.GetScalarAlignment(type);
+				uint32_t size = module.GetTypeSize(type);
+				m_PushConstantSize = std::max(m_PushConstantSize, (size + alignment - 1) / alignment * alignment);
+				break;
+			}
+
+			case SpvStorageClassInput:
+			{
+				if (m_Stage != VK_SHADER_STAGE_VERTEX_BIT || spvId.bBuiltIn || spvId.Location == INVALID)
+				{
+					break;
+				}
+
+				ReflectedVertexInput input;
+				input.Location = spvId.Location;
+				input.Format = ToVertexFormat(module, type, input.Size);
+
+				if (input.Format == VK_FORMAT_UNDEFINED)
+				{
+					TPS_CORE_ERROR("Unsupported vertex input type at location {0}", spvId.Location);
+					return false;
+				}
+
+				m_VertexInputs.push_back(input);
+				break;
+			}
+
+			case SpvStorageClassUniformConstant:
+			case SpvStorageClassUniform:
+			case SpvStorageClassStorageBuffer:
+			{
+				if (spvId.Set == INVALID || spvId.Binding == INVALID)
+				{
+					break;
+				}
+
+				ReflectedBinding binding;
+				binding.Set = spvId.Set;
+				binding.Binding = spvId.Binding;
+				binding.Stages = m_Stage;
+
+				uint32_t opcode = module.Get(type).Opcode;
+				if (opcode == SpvOpTypeArray)
+				{
+					binding.Count = static_cast<uint32_t>(module.Get(module.Operand(type, 2)).Constant);
+					type = module.Operand(type, 1);
+				}
+				else if (opcode == SpvOpTypeRuntimeArray)
+				{
+					binding.Count = 0;
+					type = module.Operand(type, 1);
+				}
+
+				binding.Type = ToDescriptorType(module, type, spvId.StorageClass);
+
+				if (binding.Type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+				{
+					TPS_CORE_ERROR("Unsupported descriptor type at set {0} binding {1}", binding.Set, binding.Binding);
+					return false;
+				}
+
+				m_Bindings.push_back(binding);
+				break;
+			}
+			}
+		}
+
+		std::sort(m_Bindings.begin(), m_Bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b)
+		{
+			return a.Set != b.Set ? a.Set < b.Set : a.Binding < b.Binding;
+		});
+
+		std::sort(m_VertexInputs.begin(), m_VertexInputs.end(), [](const ReflectedVertexInput& a, const ReflectedVertexInput& b)
+		{
+			return a.Location < b.Location;
+		});
+
+		return true;
+	}
+
+	void ShaderReflection::GetVertexLayout(ReflectedVertexLayout& outLayout) const
+	{
+		outLayout.Attributes.clear();
+		outLayout.Binding = {};
+		outLayout.Binding.binding = 0;
+		outLayout.Binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		uint32_t offset = 0;
+
+		for (const ReflectedVertexInput& input : m_VertexInputs)
+		{
+			VkVertexInputAttributeDescription attribute{};
+			attribute.location = input.Location;
+			attribute.binding = 0;
+			attribute.format = input.Format;
+			attribute.offset = offset;
+
+			outLayout.Attributes.push_back(attribute);
+			offset += input.Size;
+		}
+
+		outLayout.Binding.stride = offset;
+	}
+
+	bool ShaderReflection::CreatePipelineLayout(VkDevice device, const std::vector<const ShaderReflection*>& stages,
+		ReflectedPipelineLayout& outLayout, DescriptorLayoutCache* layoutCache)
+	{
+		outLayout.bSharedSetLayouts = layoutCache != nullptr;
+
+		// Keyed by set, then binding
+		std::map<uint32_t, std::map<uint32_t, ReflectedBinding>> sets;
+
+		for (const ShaderReflection* stage : stages)
+		{
+			for (const ReflectedBinding& binding : stage->m_Bindings)
+			{
+				auto [it, bInserted] = sets[binding.Set].try_emplace(binding.Binding, binding);
+				if (bInserted)
+				{
+					continue;
+				}
+
+				ReflectedBinding& merged = it->second;
+				if (merged.Type != binding.Type)
+				{
+					TPS_CORE_ERROR("Shader stages disagree on the type of set {0} binding {1}", binding.Set, binding.Binding);
+					return false;
+				}
+
+				merged.Count = std::max(merged.Count, binding.Count);
+				merged.Stages |= binding.Stages;
+			}
+
+			if (stage->m_PushConstantSize > 0)
+			{
+				outLayout.PushConstantSize = std::max(outLayout.PushConstantSize, stage->m_PushConstantSize);
+				outLayout.PushConstantStages |= stage->m_Stage;
+			}
+		}
+
+		// Set layouts are positional, so unused sets below the highest one get empty layouts
+		uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+		DescriptorSetLayoutDesc setDesc;
+		std::vector<VkDescriptorSetLayoutBinding>& layoutBindings = setDesc.Bindings;
+
+		for (uint32_t set = 0; set < setCount; set++)
+		{
+			// Sets owned by the engine, eg. the bindless set, use its layout whatever the shader declares
+			VkDescriptorSetLayout reservedLayout = layoutCache ? layoutCache->GetReservedSet(set) : VK_NULL_HANDLE;
+			if (reservedLayout != VK_NULL_HANDLE)
+			{
+				outLayout.SetLayouts.push_back(reservedLayout);
+				continue;
+			}
+
+			layoutBindings.clear();
+
+			auto setIt = sets.find(set);
+			if (setIt != sets.end())
+			{
+				for (const auto& [index, binding] : setIt->second)
+				{
+					if (binding.Count == 0)
+					{
+						TPS_CORE_ERROR("Runtime sized descriptor arrays are only supported in the bindless set (set {0} binding {1})",
+							set, index);
+						outLayout.Destroy(device);
+						return false;
+					}
+
+					VkDescriptorSetLayoutBinding layoutBinding{};
+					layoutBinding.binding = index;
+					layoutBinding.descriptorType = binding.Type;
+					layoutBinding.descriptorCount = binding.Count;
+					layoutBinding.stageFlags = binding.Stages;
+					layoutBindings.push_back(layoutBinding);
+				}
+			}
+
+			VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+
+			if (layoutCache)
+			{
+				setLayout = layoutCache->GetLayout(setDesc);
+			}
+			else
+			{
+				VkDescriptorSetLayoutCreateInfo setInfo{};
+				setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+				setInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+				setInfo.pBindings = layoutBindings.data();
+
+				vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &setLayout);
+			}
+
+			if (setLayout == VK_NULL_HANDLE)
+			{
+				TPS_CORE_ERROR("Failed to create descriptor set layout for set {0}!", set);
+				outLayout.Destroy(device);
+				return false;
+			}
+
+			outLayout.SetLayouts.push_back(setLayout);
+		}
+
+		VkPushConstantRange pushRange{};
+		pushRange.stageFlags = outLayout.PushConstantStages;
+		pushRange.size = outLayout.PushConstantSize;
+
+		VkPipelineLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = static_cast<uint32_t>(outLayout.SetLayouts.size());
+		layoutInfo.pSetLayouts = outLayout.SetLayouts.data();
+		layoutInfo.pushConstantRangeCount = pushRange.size > 0 ? 1 : 0;
+		layoutInfo.pPushConstantRanges = pushRange.size > 0 ? &pushRange : nullptr;
+
+		if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &outLayout.Layout) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to create reflected pipeline layout!");
+			outLayout.Destroy(device);
+			return false;
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,107 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "DescriptorLayoutCache.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <cstddef>
+
+namespace Tempus {
+
+	// SPIR-V words, either embedded in the binary or loaded by the pipeline reloader. Doesn't own the words
+	struct ShaderCode
+	{
+		static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+		const uint32_t* Words = nullptr;
+		size_t WordCount = 0;
+
+		// A hot reload can catch a binary that is still being written
+		bool IsValid() const { return Words != nullptr && WordCount >= 5 && Words[0] == SPIRV_MAGIC; }
+		size_t GetSize() const { return WordCount * sizeof(uint32_t); }
+	};
+
+	template<size_t N>
+	constexpr ShaderCode MakeShaderCode(const uint32_t (&words)[N])
+	{
+		return { words, N };
+	}
+
+	struct ReflectedBinding
+	{
+		uint32_t Set = 0;
+		uint32_t Binding = 0;
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		// 0 for runtime sized arrays
+		uint32_t Count = 1;
+		VkShaderStageFlags Stages = 0;
+	};
+
+	struct ReflectedVertexInput
+	{
+		uint32_t Location = 0;
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		uint32_t Size = 0;
+	};
+
+	// One interleaved vertex buffer on binding 0, attributes packed in location order
+	struct ReflectedVertexLayout
+	{
+		VkVertexInputBindingDescription Binding{};
+		std::vector<VkVertexInputAttributeDescription> Attributes;
+
+		// Points into this struct, so it must outlive the pipeline creation
+		VkPipelineVertexInputStateCreateInfo GetCreateInfo() const;
+	};
+
+	// Pipeline layout merged from every stage of a pipeline. Owns the set layouts
+	struct ReflectedPipelineLayout
+	{
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		std::vector<VkDescriptorSetLayout> SetLayouts;
+		// The set layouts belong to a DescriptorLayoutCache and are left alone by Destroy()
+		bool bSharedSetLayouts = false;
+		VkShaderStageFlags PushConstantStages = 0;
+		uint32_t PushConstantSize = 0;
+
+		void Destroy(VkDevice device);
+	};
+
+	// Reads the resource interface of a single entry point SPIR-V module: descriptor bindings, the push constant block
+	// and, for vertex shaders, the vertex inputs. Replaces hand written layouts that had to be kept in sync with the GLSL
+	class TEMPUS_API ShaderReflection
+	{
+	public:
+
+		bool Reflect(ShaderCode code);
+
+		VkShaderStageFlagBits GetStage() const { return m_Stage; }
+		// Sorted by set, then binding
+		const std::vector<ReflectedBinding>& GetBindings() const { return m_Bindings; }
+		// Sorted by location, vertex shaders only
+		const std::vector<ReflectedVertexInput>& GetVertexInputs() const { return m_VertexInputs; }
+		// Rounded up to the block's largest scalar, matching sizeof of the mirroring C++ struct
+		uint32_t GetPushConstantSize() const { return m_PushConstantSize; }
+
+		void GetVertexLayout(ReflectedVertexLayout& outLayout) const;
+
+		// Bindings declared by several stages are merged. Fails when stages disagree on a binding's type. Uniform blocks
+		// become dynamic uniform buffers, see UniformAllocator. With a layout cache, identical sets of different
+		// programs share their VkDescriptorSetLayout, and sets reserved in it (see DescriptorLayoutCache::ReserveSet) use
+		// the reserved layout
+		static bool CreatePipelineLayout(VkDevice device, const std::vector<const ShaderReflection*>& stages,
+			ReflectedPipelineLayout& outLayout, DescriptorLayoutCache* layoutCache = nullptr);
+
+	private:
+
+		VkShaderStageFlagBits m_Stage = VK_SHADER_STAGE_ALL;
+		std::vector<ReflectedBinding> m_Bindings;
+		std::vector<ReflectedVertexInput> m_VertexInputs;
+		uint32_t m_PushConstantSize = 0;
+
+	};
+
+}
@@ -0,0 +1,47 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include <cstdint>
+
+// SPIR-V of every shader in Tempus/res/shaders, compiled into the binary so startup never reads shader files.
+// The Generated/*.inc word lists are written by CompileShaders.bat / CompileShadersMac.sh, which run before each build
+// and are not checked in
+namespace Tempus::EmbeddedShaders {
+
+	inline constexpr uint32_t ShaderVert[] =
+	{
+#include "Generated/vert.spv.inc"
+	};
+
+	inline constexpr uint32_t ShaderFrag[] =
+	{
+#include "Generated/frag.spv.inc"
+	};
+
+	inline constexpr uint32_t SceneVert[] =
+	{
+#include "Generated/scene_vert.spv.inc"
+	};
+
+	inline constexpr uint32_t SceneFrag[] =
+	{
+#include "Generated/scene_frag.spv.inc"
+	};
+
+	inline constexpr uint32_t CullComp[] =
+	{
+#include "Generated/cull_comp.spv.inc"
+	};
+
+	inline constexpr uint32_t BatchVert[] =
+	{
+#include "Generated/batch_vert.spv.inc"
+	};
+
+	inline constexpr uint32_t BatchFrag[] =
+	{
+#include "Generated/batch_frag.spv.inc"
+	};
+
+}
@@ -0,0 +1,125 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "SubmitBatch.h"
+
+#include "Log.h"
+
+namespace Tempus {
+
+	SubmitBatch& SubmitBatch::Begin(VkQueue queue)
+	{
+		Submission submission;
+		submission.Queue = queue;
+		submission.FirstWait = static_cast<uint32_t>(m_Waits.size());
+		submission.FirstCommandBuffer = static_cast<uint32_t>(m_CommandBuffers.size());
+		submission.FirstSignal = static_cast<uint32_t>(m_Signals.size());
+
+		m_Submissions.push_back(submission);
+		return *this;
+	}
+
+	SubmitBatch& SubmitBatch::AddWait(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stages)
+	{
+		VkSemaphoreSubmitInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		info.semaphore = semaphore;
+		info.value = value;
+		info.stageMask = stages;
+
+		m_Waits.push_back(info);
+		m_Submissions.back().WaitCount++;
+		return *this;
+	}
+
+	SubmitBatch& SubmitBatch::AddCommandBuffer(VkCommandBuffer commandBuffer)
+	{
+		VkCommandBufferSubmitInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+		info.commandBuffer = commandBuffer;
+
+		m_CommandBuffers.push_back(info);
+		m_Submissions.back().CommandBufferCount++;
+		return *this;
+	}
+
+	SubmitBatch& SubmitBatch::AddSignal(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stages)
+	{
+		VkSemaphoreSubmitInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		info.semaphore = semaphore;
+		info.value = value;
+		info.stageMask = stages;
+
+		m_Signals.push_back(info);
+		m_Submissions.back().SignalCount++;
+		return *this;
+	}
+
+	bool SubmitBatch::Flush()
+	{
+		m_LastSubmitCallCount = 0;
+
+		if (m_Submissions.empty())
+		{
+			return true;
+		}
+
+		m_Submitted.assign(m_Submissions.size(), false);
+		bool bSuccess = true;
+
+		// Every queue is submitted once, in the order it first appears, with all of its submissions in one call
+		for (size_t first = 0; first < m_Submissions.size(); first++)
+		{
+			if (m_Submitted[first])
+			{
+				continue;
+			}
+
+			VkQueue queue = m_Submissions[first].Queue;
+			m_SubmitInfos.clear();
+
+			for (size_t i = first; i < m_Submissions.size(); i++)
+			{
+				const Submission& submission = m_Submissions[i];
+				if (submission.Queue != queue)
+				{
+					continue;
+				}
+
+				m_Submitted[i] = true;
+
+				VkSubmitInfo2 info{};
+				info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+				info.waitSemaphoreInfoCount = submission.WaitCount;
+				info.pWaitSemaphoreInfos = submission.WaitCount > 0 ? &m_Waits[submission.FirstWait] : nullptr;
+				info.commandBufferInfoCount = submission.CommandBufferCount;
+				info.pCommandBufferInfos = submission.CommandBufferCount > 0 ? &m_CommandBuffers[submission.FirstCommandBuffer] : nullptr;
+				info.signalSemaphoreInfoCount = submission.SignalCount;
+				info.pSignalSemaphoreInfos = submission.SignalCount > 0 ? &m_Signals[submission.FirstSignal] : nullptr;
+				m_SubmitInfos.push_back(info);
+			}
+
+			if (vkQueueSubmit2(queue, static_cast<uint32_t>(m_SubmitInfos.size()), m_SubmitInfos.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				TPS_CORE_ERROR("Failed to submit {0} batched submissions!", m_SubmitInfos.size());
+				bSuccess = false;
+			}
+
+			m_LastSubmitCallCount++;
+		}
+
+		Clear();
+		m_FlushCount.fetch_add(1, std::memory_order_release);
+
+		return bSuccess;
+	}
+
+	void SubmitBatch::Clear()
+	{
+		m_Submissions.clear();
+		m_Waits.clear();
+		m_CommandBuffers.clear();
+		m_Signals.clear();
+	}
+
+}
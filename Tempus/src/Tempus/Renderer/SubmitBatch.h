@@ -0,0 +1,73 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <atomic>
+
+namespace Tempus {
+
+	// Collects a frame's queue submissions from every subsystem and hands them to the driver with as few
+	// vkQueueSubmit2 calls as possible, one per queue. Submissions to the same queue keep their relative order.
+	// Ordering between queues is expressed with timeline semaphores, which may be waited on before they are signalled.
+	// Binary semaphores must be signalled by an earlier flush or operation
+	class TEMPUS_API SubmitBatch
+	{
+	public:
+
+		SubmitBatch() = default;
+		SubmitBatch(const SubmitBatch&) = delete;
+		SubmitBatch& operator=(const SubmitBatch&) = delete;
+
+		// Starts a new submission. The Add* calls that follow apply to it
+		SubmitBatch& Begin(VkQueue queue);
+		SubmitBatch& AddWait(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stages);
+		SubmitBatch& AddCommandBuffer(VkCommandBuffer commandBuffer);
+		SubmitBatch& AddSignal(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+		// Submits everything queued since the last flush. Binary semaphores ignore their value
+		bool Flush();
+
+		bool IsEmpty() const { return m_Submissions.empty(); }
+		// Number of completed flushes. Safe to read from any thread, work queued before a flush has been submitted
+		// once the count has moved past the value read when it was queued
+		uint64_t GetFlushCount() const { return m_FlushCount.load(std::memory_order_acquire); }
+		// vkQueueSubmit2 calls made by the last Flush()
+		uint32_t GetLastSubmitCallCount() const { return m_LastSubmitCallCount; }
+
+	private:
+
+		// Ranges into the shared arrays, which may still grow while the submission is being built
+		struct Submission
+		{
+			VkQueue Queue = VK_NULL_HANDLE;
+			uint32_t FirstWait = 0;
+			uint32_t WaitCount = 0;
+			uint32_t FirstCommandBuffer = 0;
+			uint32_t CommandBufferCount = 0;
+			uint32_t FirstSignal = 0;
+			uint32_t SignalCount = 0;
+		};
+
+		void Clear();
+
+	private:
+
+		std::vector<Submission> m_Submissions;
+		std::vector<VkSemaphoreSubmitInfo> m_Waits;
+		std::vector<VkCommandBufferSubmitInfo> m_CommandBuffers;
+		std::vector<VkSemaphoreSubmitInfo> m_Signals;
+
+		// Scratch for Flush(), kept to avoid reallocating every frame
+		std::vector<VkSubmitInfo2> m_SubmitInfos;
+		std::vector<bool> m_Submitted;
+
+		uint32_t m_LastSubmitCallCount = 0;
+		std::atomic<uint64_t> m_FlushCount = 0;
+
+	};
+
+}
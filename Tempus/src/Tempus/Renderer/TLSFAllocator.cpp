@@ -0,0 +1,352 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "TLSFAllocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace Tempus {
+
+	TLSFAllocator::TLSFAllocator(uint64_t capacity)
+	{
+		Reset(capacity);
+	}
+
+	void TLSFAllocator::Reset(uint64_t capacity)
+	{
+		m_Capacity = capacity;
+		m_UsedSize = 0;
+		m_AllocationCount = 0;
+
+		m_FlBitmap = 0;
+
+		for (uint32_t fl = 0; fl < FL_INDEX_COUNT; fl++)
+		{
+			m_SlBitmap[fl] = 0;
+
+			for (uint32_t sl = 0; sl < SL_INDEX_COUNT; sl++)
+			{
+				m_FreeLists[fl][sl] = INVALID_NODE;
+			}
+		}
+
+		m_Nodes.clear();
+		m_UnusedNodes.clear();
+
+		if (capacity == 0)
+		{
+			return;
+		}
+
+		// The whole range starts out as a single free node
+		uint32_t node = NewNode();
+		m_Nodes[node].Offset = 0;
+		m_Nodes[node].Size = capacity;
+		InsertFreeNode(node);
+	}
+
+	TLSFAllocator::Allocation TLSFAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		if (size == 0 || size > m_Capacity)
+		{
+			return {};
+		}
+
+		if (alignment == 0)
+		{
+			alignment = 1;
+		}
+
+		// Searching for size + alignment - 1 guarantees the aligned range fits inside whatever node is found
+		uint64_t searchSize = size + alignment - 1;
+		uint32_t node = FindSuitableNode(searchSize);
+
+		if (node == INVALID_NODE)
+		{
+			return {};
+		}
+
+		RemoveFreeNode(node);
+
+		uint64_t alignedOffset = (m_Nodes[node].Offset + alignment - 1) & ~(alignment - 1);
+		uint64_t padding = alignedOffset - m_Nodes[node].Offset;
+
+		// Alignment padding at the front becomes its own free node.
+		// The previous physical node is never free (free neighbours are always merged) so no coalescing is required
+		if (padding > 0)
+		{
+			uint32_t head = NewNode();
+
+			m_Nodes[head].Offset = m_Nodes[node].Offset;
+			m_Nodes[head].Size = padding;
+			m_Nodes[head].PrevPhysical = m_Nodes[node].PrevPhysical;
+			m_Nodes[head].NextPhysical = node;
+
+			if (m_Nodes[head].PrevPhysical != INVALID_NODE)
+			{
+				m_Nodes[m_Nodes[head].PrevPhysical].NextPhysical = head;
+			}
+
+			m_Nodes[node].PrevPhysical = head;
+			m_Nodes[node].Offset += padding;
+			m_Nodes[node].Size -= padding;
+
+			InsertFreeNode(head);
+		}
+
+		if (m_Nodes[node].Size > size)
+		{
+			SplitTail(node, size);
+		}
+
+		m_Nodes[node].bFree = false;
+
+		m_UsedSize += m_Nodes[node].Size;
+		m_AllocationCount++;
+
+		Allocation allocation;
+		allocation.Offset = m_Nodes[node].Offset;
+		allocation.Size = m_Nodes[node].Size;
+		allocation.Node = node;
+
+		return allocation;
+	}
+
+	void TLSFAllocator::Free(const Allocation& allocation)
+	{
+		if (!allocation.IsValid())
+		{
+			return;
+		}
+
+		uint32_t node = allocation.Node;
+
+		m_UsedSize -= m_Nodes[node].Size;
+		m_AllocationCount--;
+
+		// Merge with the previous physical node
+		uint32_t prev = m_Nodes[node].PrevPhysical;
+
+		if (prev != INVALID_NODE && m_Nodes[prev].bFree)
+		{
+			RemoveFreeNode(prev);
+
+			m_Nodes[prev].Size += m_Nodes[node].Size;
+			m_Nodes[prev].NextPhysical = m_Nodes[node].NextPhysical;
+
+			if (m_Nodes[prev].NextPhysical != INVALID_NODE)
+			{
+				m_Nodes[m_Nodes[prev].NextPhysical].PrevPhysical = prev;
+			}
+
+			ReleaseNode(node);
+			node = prev;
+		}
+
+		// Merge with the next physical node
+		uint32_t next = m_Nodes[node].NextPhysical;
+
+		if (next != INVALID_NODE && m_Nodes[next].bFree)
+		{
+			RemoveFreeNode(next);
+
+			m_Nodes[node].Size += m_Nodes[next].Size;
+			m_Nodes[node].NextPhysical = m_Nodes[next].NextPhysical;
+
+			if (m_Nodes[node].NextPhysical != INVALID_NODE)
+			{
+				m_Nodes[m_Nodes[node].NextPhysical].PrevPhysical = node;
+			}
+
+			ReleaseNode(next);
+		}
+
+		InsertFreeNode(node);
+	}
+
+	uint64_t TLSFAllocator::GetLargestFreeRange() const
+	{
+		if (m_FlBitmap == 0)
+		{
+			return 0;
+		}
+
+		// The largest free node lives somewhere in the highest non-empty bucket
+		uint32_t fl = 63 - std::countl_zero(m_FlBitmap);
+		uint32_t sl = 31 - std::countl_zero(m_SlBitmap[fl]);
+
+		uint64_t largest = 0;
+
+		for (uint32_t node = m_FreeLists[fl][sl]; node != INVALID_NODE; node = m_Nodes[node].NextFree)
+		{
+			largest = (std::max)(largest, m_Nodes[node].Size);
+		}
+
+		return largest;
+	}
+
+	void TLSFAllocator::Mapping(uint64_t size, uint32_t& fl, uint32_t& sl) const
+	{
+		// Small sizes are linearly spaced in the first list
+		if (size < SMALL_BLOCK_SIZE)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size);
+			return;
+		}
+
+		uint32_t msb = 63 - std::countl_zero(size);
+		sl = static_cast<uint32_t>(size >> (msb - SL_INDEX_COUNT_LOG2)) ^ SL_INDEX_COUNT;
+		fl = msb - (FL_INDEX_SHIFT - 1);
+	}
+
+	uint32_t TLSFAllocator::FindSuitableNode(uint64_t size)
+	{
+		uint32_t fl, sl;
+		Mapping(size, fl, sl);
+
+		// Round the request up to the next size class so that any node in the found bucket is large enough
+		uint64_t roundedSize = size;
+
+		if (size >= SMALL_BLOCK_SIZE)
+		{
+			uint32_t msb = 63 - std::countl_zero(size);
+			roundedSize += (1ull << (msb - SL_INDEX_COUNT_LOG2)) - 1;
+		}
+
+		uint32_t searchFl, searchSl;
+		Mapping(roundedSize, searchFl, searchSl);
+
+		if (searchFl < FL_INDEX_COUNT)
+		{
+			uint32_t slMap = m_SlBitmap[searchFl] & (~0u << searchSl);
+
+			if (slMap == 0)
+			{
+				uint64_t flMap = searchFl + 1 < 64 ? m_FlBitmap & (~0ull << (searchFl + 1)) : 0;
+
+				if (flMap != 0)
+				{
+					searchFl = std::countr_zero(flMap);
+					slMap = m_SlBitmap[searchFl];
+				}
+			}
+
+			if (slMap != 0)
+			{
+				return m_FreeLists[searchFl][std::countr_zero(slMap)];
+			}
+		}
+
+		// Rounding up can skip a bucket that still holds a large enough node, which matters for requests close
+		// to the capacity. Fall back to walking the exact bucket
+		for (uint32_t node = m_FreeLists[fl][sl]; node != INVALID_NODE; node = m_Nodes[node].NextFree)
+		{
+			if (m_Nodes[node].Size >= size)
+			{
+				return node;
+			}
+		}
+
+		return INVALID_NODE;
+	}
+
+	void TLSFAllocator::InsertFreeNode(uint32_t node)
+	{
+		uint32_t fl, sl;
+		Mapping(m_Nodes[node].Size, fl, sl);
+
+		uint32_t head = m_FreeLists[fl][sl];
+
+		m_Nodes[node].bFree = true;
+		m_Nodes[node].PrevFree = INVALID_NODE;
+		m_Nodes[node].NextFree = head;
+
+		if (head != INVALID_NODE)
+		{
+			m_Nodes[head].PrevFree = node;
+		}
+
+		m_FreeLists[fl][sl] = node;
+		m_FlBitmap |= 1ull << fl;
+		m_SlBitmap[fl] |= 1u << sl;
+	}
+
+	void TLSFAllocator::RemoveFreeNode(uint32_t node)
+	{
+		uint32_t fl, sl;
+		Mapping(m_Nodes[node].Size, fl, sl);
+
+		uint32_t prev = m_Nodes[node].PrevFree;
+		uint32_t next = m_Nodes[node].NextFree;
+
+		if (prev != INVALID_NODE)
+		{
+			m_Nodes[prev].NextFree = next;
+		}
+		else
+		{
+			m_FreeLists[fl][sl] = next;
+		}
+
+		if (next != INVALID_NODE)
+		{
+			m_Nodes[next].PrevFree = prev;
+		}
+
+		// Clear bitmap bits once the bucket runs empty
+		if (m_FreeLists[fl][sl] == INVALID_NODE)
+		{
+			m_SlBitmap[fl] &= ~(1u << sl);
+
+			if (m_SlBitmap[fl] == 0)
+			{
+				m_FlBitmap &= ~(1ull << fl);
+			}
+		}
+
+		m_Nodes[node].bFree = false;
+		m_Nodes[node].PrevFree = INVALID_NODE;
+		m_Nodes[node].NextFree = INVALID_NODE;
+	}
+
+	void TLSFAllocator::SplitTail(uint32_t node, uint64_t size)
+	{
+		uint32_t tail = NewNode();
+
+		m_Nodes[tail].Offset = m_Nodes[node].Offset + size;
+		m_Nodes[tail].Size = m_Nodes[node].Size - size;
+		m_Nodes[tail].PrevPhysical = node;
+		m_Nodes[tail].NextPhysical = m_Nodes[node].NextPhysical;
+
+		if (m_Nodes[tail].NextPhysical != INVALID_NODE)
+		{
+			m_Nodes[m_Nodes[tail].NextPhysical].PrevPhysical = tail;
+		}
+
+		m_Nodes[node].NextPhysical = tail;
+		m_Nodes[node].Size = size;
+
+		InsertFreeNode(tail);
+	}
+
+	uint32_t TLSFAllocator::NewNode()
+	{
+		if (!m_UnusedNodes.empty())
+		{
+			uint32_t node = m_UnusedNodes.back();
+			m_UnusedNodes.pop_back();
+			m_Nodes[node] = Node();
+			return node;
+		}
+
+		m_Nodes.emplace_back();
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+
+	void TLSFAllocator::ReleaseNode(uint32_t node)
+	{
+		m_UnusedNodes.push_back(node);
+	}
+
+}
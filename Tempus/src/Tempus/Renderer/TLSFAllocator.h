@@ -0,0 +1,94 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tempus {
+
+	// Two level segregated fit allocator over an abstract range [0, capacity).
+	// It only hands out offsets, which makes it usable for any sub-allocated resource (device memory, buffers, rings).
+	// Allocation and free are O(1): free ranges are bucketed by size class and found through two bitmaps
+	class TEMPUS_API TLSFAllocator
+	{
+	public:
+
+		static constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			uint32_t Node = INVALID_NODE;
+
+			bool IsValid() const { return Node != INVALID_NODE; }
+		};
+
+		TLSFAllocator() = default;
+		explicit TLSFAllocator(uint64_t capacity);
+
+		void Reset(uint64_t capacity);
+
+		// Alignment must be a power of two
+		Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(const Allocation& allocation);
+
+		uint64_t GetCapacity() const { return m_Capacity; }
+		uint64_t GetUsedSize() const { return m_UsedSize; }
+		uint64_t GetFreeSize() const { return m_Capacity - m_UsedSize; }
+		uint64_t GetLargestFreeRange() const;
+		uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		bool IsEmpty() const { return m_AllocationCount == 0; }
+
+	private:
+
+		// 32 second level subdivisions per power of two
+		static constexpr uint32_t SL_INDEX_COUNT_LOG2 = 5;
+		static constexpr uint32_t SL_INDEX_COUNT = 1 << SL_INDEX_COUNT_LOG2;
+		static constexpr uint32_t FL_INDEX_SHIFT = SL_INDEX_COUNT_LOG2;
+		static constexpr uint64_t SMALL_BLOCK_SIZE = 1ull << FL_INDEX_SHIFT;
+		static constexpr uint32_t FL_INDEX_COUNT = 64 - FL_INDEX_SHIFT + 1;
+
+		struct Node
+		{
+			uint64_t Offset = 0;
+			uint64_t Size = 0;
+			// Physical neighbours in address order
+			uint32_t PrevPhysical = INVALID_NODE;
+			uint32_t NextPhysical = INVALID_NODE;
+			// Links within a free list bucket
+			uint32_t PrevFree = INVALID_NODE;
+			uint32_t NextFree = INVALID_NODE;
+			bool bFree = false;
+		};
+
+		void Mapping(uint64_t size, uint32_t& fl, uint32_t& sl) const;
+		uint32_t FindSuitableNode(uint64_t size);
+
+		void InsertFreeNode(uint32_t node);
+		void RemoveFreeNode(uint32_t node);
+		// Splits the tail of node off into a new free node
+		void SplitTail(uint32_t node, uint64_t size);
+
+		uint32_t NewNode();
+		void ReleaseNode(uint32_t node);
+
+	private:
+
+		uint64_t m_Capacity = 0;
+		uint64_t m_UsedSize = 0;
+		uint32_t m_AllocationCount = 0;
+
+		uint64_t m_FlBitmap = 0;
+		uint32_t m_SlBitmap[FL_INDEX_COUNT] = {};
+		uint32_t m_FreeLists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_UnusedNodes;
+
+	};
+
+}
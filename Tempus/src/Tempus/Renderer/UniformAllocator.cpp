@@ -0,0 +1,161 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "UniformAllocator.h"
+
+#include "Log.h"
+#include <algorithm>
+
+namespace Tempus {
+
+	UniformAllocator::~UniformAllocator()
+	{
+		Shutdown();
+	}
+
+	bool UniformAllocator::Init(VkPhysicalDevice physicalDevice, VkDevice device, GPUAllocator* allocator, uint32_t framesInFlight,
+		VkDeviceSize frameSize)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+		// Both are powers of two, the spec caps the alignment at 256 and guarantees a range of at least 16 KB
+		m_Alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+		m_Range = std::min<uint32_t>(properties.limits.maxUniformBufferRange, 64 * 1024);
+		m_FrameSize = AlignUp(std::max<VkDeviceSize>(frameSize, m_Range));
+
+		// The tail is padded by one range, so the descriptor of an allocation at the end of the last region stays in the buffer
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_FrameSize * framesInFlight + m_Range;
+		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::CPUToGPU, m_Buffer, m_Allocation))
+		{
+			TPS_CORE_CRITICAL("Failed to create uniform buffer!");
+			return false;
+		}
+
+		// Only ever holds sets with a single dynamic uniform buffer
+		if (!m_Descriptors.Init(m_Device, 16, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f } }))
+		{
+			TPS_CORE_CRITICAL("Failed to initialize uniform descriptor allocator!");
+			return false;
+		}
+
+		m_FrameBegin = 0;
+		m_FrameEnd = m_FrameSize;
+		m_Head = 0;
+
+		TPS_CORE_INFO("Uniform allocator initialized ({0} KB per frame, {1} byte alignment)", m_FrameSize / 1024, m_Alignment);
+
+		return true;
+	}
+
+	void UniformAllocator::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		m_Descriptors.Shutdown();
+
+		if (m_Buffer != VK_NULL_HANDLE)
+		{
+			m_Allocator->DestroyBuffer(m_Buffer, m_Allocation);
+			m_Buffer = VK_NULL_HANDLE;
+		}
+
+		m_Sets.clear();
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	void UniformAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		m_PeakUsage = std::max(m_PeakUsage, GetFrameUsage());
+
+		uint32_t failedCount = m_FailedCount.exchange(0, std::memory_order_relaxed);
+		if (failedCount > 0)
+		{
+			TPS_CORE_WARN("{0} uniform allocations failed last frame, the frame is limited to {1} KB", failedCount, m_FrameSize / 1024);
+		}
+
+		m_FrameBegin = m_FrameSize * frameIndex;
+		m_FrameEnd = m_FrameBegin + m_FrameSize;
+		m_Head.store(m_FrameBegin, std::memory_order_relaxed);
+	}
+
+	UniformAllocation UniformAllocator::Allocate(uint32_t size)
+	{
+		if (size == 0 || size > m_Range)
+		{
+			TPS_CORE_ERROR("Uniform allocation of {0} bytes is outside the descriptor range of {1} bytes", size, m_Range);
+			return {};
+		}
+
+		VkDeviceSize alignedSize = AlignUp(size);
+		VkDeviceSize offset = m_Head.fetch_add(alignedSize, std::memory_order_relaxed);
+
+		// Failed allocations leave the head past the end, which only fails the ones after them too
+		if (offset + alignedSize > m_FrameEnd)
+		{
+			m_FailedCount.fetch_add(1, std::memory_order_relaxed);
+			return {};
+		}
+
+		UniformAllocation allocation;
+		allocation.Data = static_cast<uint8_t*>(m_Allocation.MappedData) + offset;
+		allocation.Offset = static_cast<uint32_t>(offset);
+
+		return allocation;
+	}
+
+	VkDescriptorSet UniformAllocator::GetDescriptorSet(VkDescriptorSetLayout setLayout)
+	{
+		for (const CachedSet& cached : m_Sets)
+		{
+			if (cached.Layout == setLayout)
+			{
+				return cached.Set;
+			}
+		}
+
+		CachedSet cached;
+		cached.Layout = setLayout;
+		cached.Set = m_Descriptors.Allocate(setLayout);
+
+		if (cached.Set == VK_NULL_HANDLE)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		// Offset 0, the dynamic offset picks the allocation
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = m_Buffer;
+		bufferInfo.offset = 0;
+		bufferInfo.range = m_Range;
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = cached.Set;
+		write.dstBinding = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		write.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(m_Device, 1, &write, 0, nullptr);
+
+		m_Sets.push_back(cached);
+		return cached.Set;
+	}
+
+	VkDeviceSize UniformAllocator::GetFrameUsage() const
+	{
+		return std::min(m_Head.load(std::memory_order_relaxed), m_FrameEnd) - m_FrameBegin;
+	}
+
+}
@@ -0,0 +1,115 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+#include "DescriptorAllocator.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <atomic>
+#include <cstring>
+
+namespace Tempus {
+
+	struct UniformAllocation
+	{
+		// Persistently mapped, write the uniform data here before the frame is submitted
+		void* Data = nullptr;
+		// Dynamic offset to bind the allocator's descriptor set with
+		uint32_t Offset = 0;
+
+		bool IsValid() const { return Data != nullptr; }
+	};
+
+	// Linear allocator for per-frame constants and per-draw data. One persistently mapped buffer holds a region per frame
+	// in flight. Allocations bump a pointer through the current frame's region, aligned to minUniformBufferOffsetAlignment,
+	// and BeginFrame() rewinds the region once the frame slot's previous submission has completed. Nothing is mapped,
+	// unmapped or allocated per frame.
+	//
+	// Uniform blocks are reflected as dynamic uniform buffers. Every allocation is bound through the same descriptor set
+	// with its offset passed as the dynamic offset, so there's no descriptor update per draw either
+	class TEMPUS_API UniformAllocator
+	{
+	public:
+
+		static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 4ull * 1024 * 1024;
+		static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+		UniformAllocator() = default;
+		~UniformAllocator();
+
+		// frameSize is rounded up to the offset alignment
+		bool Init(VkPhysicalDevice physicalDevice, VkDevice device, GPUAllocator* allocator, uint32_t framesInFlight,
+			VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+		void Shutdown();
+
+		// The frame slot's previous submission must have completed. Rewinds the slot's region
+		void BeginFrame(uint32_t frameIndex);
+
+		// Thread safe, so recording threads can allocate per-draw data. Fails when size is above GetRange() or the
+		// frame's region is full
+		UniformAllocation Allocate(uint32_t size);
+
+		// Copies data into a new allocation. Returns its dynamic offset, or INVALID_OFFSET on failure
+		template<typename T>
+		uint32_t Push(const T& data)
+		{
+			UniformAllocation allocation = Allocate(static_cast<uint32_t>(sizeof(T)));
+			if (!allocation.IsValid())
+			{
+				return INVALID_OFFSET;
+			}
+
+			std::memcpy(allocation.Data, &data, sizeof(T));
+			return allocation.Offset;
+		}
+
+		// A set for setLayout with binding 0 pointing at the uniform buffer, valid for every frame. setLayout must have a
+		// single dynamic uniform buffer at binding 0, eg. a shader's `layout(set = N, binding = 0) uniform` block.
+		// Created on first use, not thread safe
+		VkDescriptorSet GetDescriptorSet(VkDescriptorSetLayout setLayout);
+
+		// Bytes each descriptor covers, the largest uniform block a shader may declare
+		uint32_t GetRange() const { return m_Range; }
+		VkDeviceSize GetAlignment() const { return m_Alignment; }
+		// Bytes allocated so far in the current frame
+		VkDeviceSize GetFrameUsage() const;
+		// Most bytes any frame has allocated
+		VkDeviceSize GetPeakUsage() const { return m_PeakUsage; }
+
+	private:
+
+		struct CachedSet
+		{
+			VkDescriptorSetLayout Layout = VK_NULL_HANDLE;
+			VkDescriptorSet Set = VK_NULL_HANDLE;
+		};
+
+		VkDeviceSize AlignUp(VkDeviceSize value) const { return (value + m_Alignment - 1) & ~(m_Alignment - 1); }
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+
+		VkBuffer m_Buffer = VK_NULL_HANDLE;
+		GPUAllocation m_Allocation;
+		VkDeviceSize m_FrameSize = 0;
+		VkDeviceSize m_Alignment = 256;
+		uint32_t m_Range = 0;
+
+		// Offset into the buffer of the next allocation and the end of the current frame's region
+		std::atomic<VkDeviceSize> m_Head = 0;
+		VkDeviceSize m_FrameBegin = 0;
+		VkDeviceSize m_FrameEnd = 0;
+		std::atomic<uint32_t> m_FailedCount = 0;
+		VkDeviceSize m_PeakUsage = 0;
+
+		DescriptorAllocator m_Descriptors;
+		std::vector<CachedSet> m_Sets;
+
+	};
+
+}
@@ -0,0 +1,677 @@
+// Copyright Levi Spevakow (C) 2025
+
+#include "UploadManager.h"
+
+#include "Log.h"
+#include <cstring>
+#include <algorithm>
+
+namespace Tempus {
+
+	UploadManager::~UploadManager()
+	{
+		Shutdown();
+	}
+
+	bool UploadManager::Init(VkDevice device, GPUAllocator* allocator, VkQueue transferQueue, uint32_t transferFamily, VkQueue graphicsQueue,
+		uint32_t graphicsFamily, VkDeviceSize stagingSize)
+	{
+		m_Device = device;
+		m_Allocator = allocator;
+		m_TransferQueue = transferQueue;
+		m_TransferFamily = transferFamily;
+		m_GraphicsQueue = graphicsQueue;
+		m_GraphicsFamily = graphicsFamily;
+		m_StagingSize = stagingSize;
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = m_TransferFamily;
+
+		if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to create upload command pool!");
+			return false;
+		}
+
+		VkSemaphoreTypeCreateInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		timelineInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &timelineInfo;
+
+		if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_TimelineSemaphore) != VK_SUCCESS)
+		{
+			TPS_CORE_CRITICAL("Failed to create upload timeline semaphore!");
+			return false;
+		}
+
+		if (HasDedicatedTransferQueue())
+		{
+			poolInfo.queueFamilyIndex = m_GraphicsFamily;
+
+			if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_GraphicsCommandPool) != VK_SUCCESS ||
+				vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &m_ReleaseSemaphore) != VK_SUCCESS)
+			{
+				TPS_CORE_CRITICAL("Failed to create upload ownership release objects!");
+				return false;
+			}
+		}
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_StagingSize;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::CPUToGPU, m_StagingBuffer, m_StagingAllocation))
+		{
+			TPS_CORE_CRITICAL("Failed to create staging ring buffer!");
+			return false;
+		}
+
+		TPS_CORE_INFO("Upload manager using {0} transfer queue (family {1}), {2} MB staging ring",
+			HasDedicatedTransferQueue() ? "dedicated" : "graphics", m_TransferFamily, m_StagingSize / (1024 * 1024));
+
+		return true;
+	}
+
+	void UploadManager::Shutdown()
+	{
+		if (m_Device == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		if (m_TimelineSemaphore != VK_NULL_HANDLE)
+		{
+			Wait(m_SubmittedValue);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			ReclaimCompletedBatches();
+
+			for (OversizedStaging& staging : m_PendingOversized)
+			{
+				m_Allocator->DestroyBuffer(staging.Buffer, staging.Allocation);
+			}
+
+			m_PendingOversized.clear();
+			m_PendingBufferCopies.clear();
+			m_PendingImageCopies.clear();
+		}
+
+		if (m_StagingBuffer != VK_NULL_HANDLE)
+		{
+			m_Allocator->DestroyBuffer(m_StagingBuffer, m_StagingAllocation);
+			m_StagingBuffer = VK_NULL_HANDLE;
+		}
+
+		vkDestroySemaphore(m_Device, m_TimelineSemaphore, nullptr);
+		vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
+		vkDestroySemaphore(m_Device, m_ReleaseSemaphore, nullptr);
+		vkDestroyCommandPool(m_Device, m_GraphicsCommandPool, nullptr);
+
+		m_ReleaseSemaphore = VK_NULL_HANDLE;
+		m_GraphicsCommandPool = VK_NULL_HANDLE;
+		m_GraphicsOwnedBuffers.clear();
+
+		m_Device = VK_NULL_HANDLE;
+	}
+
+	uint64_t UploadManager::UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		VkDeviceSize stagingOffset;
+		void* mapped;
+		VkBuffer staging = AllocateStaging(lock, size, stagingOffset, mapped);
+
+		if (staging == VK_NULL_HANDLE)
+		{
+			TPS_CORE_ERROR("Failed to allocate {0} bytes of staging memory!", size);
+			return 0;
+		}
+
+		std::memcpy(mapped, data, size);
+
+		PendingBufferCopy copy;
+		copy.Src = staging;
+		copy.Dst = dst;
+		copy.Region.srcOffset = stagingOffset;
+		copy.Region.dstOffset = dstOffset;
+		copy.Region.size = size;
+		m_PendingBufferCopies.push_back(copy);
+
+		// Completes with the next flush
+		return m_SubmittedValue + 1;
+	}
+
+	uint64_t UploadManager::UploadImage(VkImage dst, VkExtent3D extent, const void* data, VkDeviceSize size, VkImageLayout finalLayout)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		VkDeviceSize stagingOffset;
+		void* mapped;
+		VkBuffer staging = AllocateStaging(lock, size, stagingOffset, mapped);
+
+		if (staging == VK_NULL_HANDLE)
+		{
+			TPS_CORE_ERROR("Failed to allocate {0} bytes of staging memory!", size);
+			return 0;
+		}
+
+		std::memcpy(mapped, data, size);
+
+		PendingImageCopy copy;
+		copy.Src = staging;
+		copy.Dst = dst;
+		copy.Region.bufferOffset = stagingOffset;
+		// Tightly packed
+		copy.Region.bufferRowLength = 0;
+		copy.Region.bufferImageHeight = 0;
+		copy.Region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		copy.Region.imageSubresource.mipLevel = 0;
+		copy.Region.imageSubresource.baseArrayLayer = 0;
+		copy.Region.imageSubresource.layerCount = 1;
+		copy.Region.imageOffset = { 0, 0, 0 };
+		copy.Region.imageExtent = extent;
+		copy.FinalLayout = finalLayout;
+		m_PendingImageCopies.push_back(copy);
+
+		return m_SubmittedValue + 1;
+	}
+
+	uint64_t UploadManager::Flush(SubmitBatch& batch)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		ReclaimCompletedBatches();
+
+		if (m_PendingBufferCopies.empty() && m_PendingImageCopies.empty())
+		{
+			return 0;
+		}
+
+		VkCommandBuffer commandBuffer = AcquireCommandBuffer(m_CommandPool, m_FreeCommandBuffers);
+
+		if (commandBuffer == VK_NULL_HANDLE)
+		{
+			return 0;
+		}
+
+		bool bTransferOwnership = HasDedicatedTransferQueue();
+
+		// Goes on the batch ahead of the copies, which wait for it
+		VkCommandBuffer releaseCommandBuffer = VK_NULL_HANDLE;
+		std::vector<VkBufferMemoryBarrier2> bufferAcquires;
+
+		if (bTransferOwnership && !QueueGraphicsReleases(batch, releaseCommandBuffer, bufferAcquires))
+		{
+			m_FreeCommandBuffers.push_back(commandBuffer);
+			return 0;
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+		// Images start out undefined and have to be in transfer dst layout before the copy
+		std::vector<VkImageMemoryBarrier2> imageBarriers;
+		imageBarriers.reserve(m_PendingImageCopies.size());
+
+		for (const PendingImageCopy& copy : m_PendingImageCopies)
+		{
+			VkImageMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = copy.Dst;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			imageBarriers.push_back(barrier);
+		}
+
+		if (!imageBarriers.empty() || !bufferAcquires.empty())
+		{
+			VkDependencyInfo dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferAcquires.size());
+			dependencyInfo.pBufferMemoryBarriers = bufferAcquires.data();
+			dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+			dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+
+			vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+		}
+
+		// Consecutive copies between the same pair of buffers are merged into one command
+		std::vector<VkBufferCopy> regions;
+
+		for (size_t i = 0; i < m_PendingBufferCopies.size(); i++)
+		{
+			const PendingBufferCopy& copy = m_PendingBufferCopies[i];
+			regions.push_back(copy.Region);
+
+			bool bLastOfRun = i + 1 == m_PendingBufferCopies.size() ||
+				m_PendingBufferCopies[i + 1].Src != copy.Src || m_PendingBufferCopies[i + 1].Dst != copy.Dst;
+
+			if (bLastOfRun)
+			{
+				vkCmdCopyBuffer(commandBuffer, copy.Src, copy.Dst, static_cast<uint32_t>(regions.size()), regions.data());
+				regions.clear();
+			}
+		}
+
+		for (const PendingImageCopy& copy : m_PendingImageCopies)
+		{
+			vkCmdCopyBufferToImage(commandBuffer, copy.Src, copy.Dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.Region);
+		}
+
+		// Release barriers. With a dedicated transfer family these hand ownership over to the graphics family and the
+		// matching acquire is recorded by the next graphics command buffer. Otherwise they're plain barriers
+		std::vector<VkBufferMemoryBarrier2> bufferReleases;
+		imageBarriers.clear();
+
+		for (const PendingBufferCopy& copy : m_PendingBufferCopies)
+		{
+			if (!bTransferOwnership)
+			{
+				// Semaphore wait on the graphics queue already makes the transfer writes visible
+				break;
+			}
+
+			// The release only needs the source half and the acquire only the destination half
+			VkBufferMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.dstAccessMask = VK_ACCESS_2_NONE;
+			barrier.srcQueueFamilyIndex = m_TransferFamily;
+			barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+			barrier.buffer = copy.Dst;
+			barrier.offset = copy.Region.dstOffset;
+			barrier.size = copy.Region.size;
+			bufferReleases.push_back(barrier);
+
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+			m_PendingBufferAcquires.push_back(barrier);
+
+			m_GraphicsOwnedBuffers.insert(copy.Dst);
+		}
+
+		for (const PendingImageCopy& copy : m_PendingImageCopies)
+		{
+			VkImageMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			barrier.dstStageMask = bTransferOwnership ? VK_PIPELINE_STAGE_2_NONE : VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.dstAccessMask = bTransferOwnership ? VK_ACCESS_2_NONE : VK_ACCESS_2_MEMORY_READ_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = copy.FinalLayout;
+			barrier.srcQueueFamilyIndex = bTransferOwnership ? m_TransferFamily : VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = bTransferOwnership ? m_GraphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = copy.Dst;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			imageBarriers.push_back(barrier);
+
+			if (bTransferOwnership)
+			{
+				// The acquire has to repeat the exact layout transition of the release
+				barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+				barrier.srcAccessMask = VK_ACCESS_2_NONE;
+				barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+				barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+				m_PendingImageAcquires.push_back(barrier);
+			}
+		}
+
+		if (!bufferReleases.empty() || !imageBarriers.empty())
+		{
+			VkDependencyInfo dependencyInfo{};
+			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+			dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferReleases.size());
+			dependencyInfo.pBufferMemoryBarriers = bufferReleases.data();
+			dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+			dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+
+			vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+		}
+
+		vkEndCommandBuffer(commandBuffer);
+
+		uint64_t signalValue = m_SubmittedValue + 1;
+
+		batch.Begin(m_TransferQueue);
+
+		if (releaseCommandBuffer != VK_NULL_HANDLE)
+		{
+			batch.AddWait(m_ReleaseSemaphore, m_ReleaseValue, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT);
+		}
+
+		batch.AddCommandBuffer(commandBuffer)
+			.AddSignal(m_TimelineSemaphore, signalValue, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT);
+
+		m_SubmittedValue = signalValue;
+		m_SubmitBatch = &batch;
+
+		InFlightBatch inFlight;
+		inFlight.Value = signalValue;
+		inFlight.RingBytes = m_PendingRingBytes;
+		inFlight.CommandBuffer = commandBuffer;
+		inFlight.ReleaseCommandBuffer = releaseCommandBuffer;
+		inFlight.Oversized = std::move(m_PendingOversized);
+		inFlight.FlushCount = batch.GetFlushCount();
+		m_InFlightBatches.push_back(std::move(inFlight));
+
+		m_PendingRingBytes = 0;
+		m_PendingOversized.clear();
+		m_PendingBufferCopies.clear();
+		m_PendingImageCopies.clear();
+
+		return signalValue;
+	}
+
+	void UploadManager::RecordAcquireBarriers(VkCommandBuffer commandBuffer)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_PendingBufferAcquires.empty() && m_PendingImageAcquires.empty())
+		{
+			return;
+		}
+
+		VkDependencyInfo dependencyInfo{};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(m_PendingBufferAcquires.size());
+		dependencyInfo.pBufferMemoryBarriers = m_PendingBufferAcquires.data();
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(m_PendingImageAcquires.size());
+		dependencyInfo.pImageMemoryBarriers = m_PendingImageAcquires.data();
+
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+		m_PendingBufferAcquires.clear();
+		m_PendingImageAcquires.clear();
+	}
+
+	void UploadManager::Forget(VkBuffer buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_GraphicsOwnedBuffers.erase(buffer);
+	}
+
+	bool UploadManager::IsComplete(uint64_t value) const
+	{
+		uint64_t completed = 0;
+		vkGetSemaphoreCounterValue(m_Device, m_TimelineSemaphore, &completed);
+		return completed >= value;
+	}
+
+	void UploadManager::Wait(uint64_t value) const
+	{
+		if (value == 0)
+		{
+			return;
+		}
+
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_TimelineSemaphore;
+		waitInfo.pValues = &value;
+
+		vkWaitSemaphores(m_Device, &waitInfo, UINT64_MAX);
+	}
+
+	VkBuffer UploadManager::AllocateStaging(std::unique_lock<std::mutex>& lock, VkDeviceSize size, VkDeviceSize& outOffset, void*& outMapped)
+	{
+		// Large uploads would monopolize the ring, they get a one off staging buffer instead
+		bool bFitsRing = size <= m_StagingSize / 2;
+
+		if (bFitsRing)
+		{
+			while (!TryAllocateFromRing(size, outOffset))
+			{
+				// Ring is full. Block on the oldest batch still holding ring memory, unless it hasn't even been submitted
+				// yet, in which case waiting could deadlock against the render thread
+				if (m_InFlightBatches.empty() || m_SubmitBatch->GetFlushCount() <= m_InFlightBatches.front().FlushCount)
+				{
+					bFitsRing = false;
+					break;
+				}
+
+				// Unlocked, so other uploads and the render thread's Flush() and RecordAcquireBarriers() carry on meanwhile
+				uint64_t value = m_InFlightBatches.front().Value;
+				lock.unlock();
+				Wait(value);
+				lock.lock();
+
+				ReclaimCompletedBatches();
+			}
+		}
+
+		if (bFitsRing)
+		{
+			outMapped = static_cast<char*>(m_StagingAllocation.MappedData) + outOffset;
+			return m_StagingBuffer;
+		}
+
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		OversizedStaging staging;
+
+		if (!m_Allocator->CreateBuffer(bufferInfo, MemoryUsage::CPUToGPU, staging.Buffer, staging.Allocation))
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		m_PendingOversized.push_back(staging);
+
+		outOffset = 0;
+		outMapped = staging.Allocation.MappedData;
+		return staging.Buffer;
+	}
+
+	bool UploadManager::TryAllocateFromRing(VkDeviceSize size, VkDeviceSize& outOffset)
+	{
+		VkDeviceSize alignedHead = (m_RingHead + m_CopyAlignment - 1) & ~(m_CopyAlignment - 1);
+		VkDeviceSize start;
+		VkDeviceSize consumed;
+
+		if (alignedHead + size <= m_StagingSize)
+		{
+			start = alignedHead;
+			consumed = alignedHead + size - m_RingHead;
+		}
+		else
+		{
+			// Not enough room before the end, skip the remainder and wrap around
+			start = 0;
+			consumed = (m_StagingSize - m_RingHead) + size;
+		}
+
+		if (m_RingUsed + consumed > m_StagingSize)
+		{
+			return false;
+		}
+
+		m_RingHead = start + size;
+		m_RingUsed += consumed;
+		m_PendingRingBytes += consumed;
+
+		outOffset = start;
+		return true;
+	}
+
+	void UploadManager::ReclaimCompletedBatches()
+	{
+		if (m_InFlightBatches.empty())
+		{
+			return;
+		}
+
+		uint64_t completed = 0;
+		vkGetSemaphoreCounterValue(m_Device, m_TimelineSemaphore, &completed);
+
+		while (!m_InFlightBatches.empty() && m_InFlightBatches.front().Value <= completed)
+		{
+			InFlightBatch& batch = m_InFlightBatches.front();
+
+			m_RingUsed -= batch.RingBytes;
+
+			for (OversizedStaging& staging : batch.Oversized)
+			{
+				m_Allocator->DestroyBuffer(staging.Buffer, staging.Allocation);
+			}
+
+			m_FreeCommandBuffers.push_back(batch.CommandBuffer);
+
+			if (batch.ReleaseCommandBuffer != VK_NULL_HANDLE)
+			{
+				m_FreeGraphicsCommandBuffers.push_back(batch.ReleaseCommandBuffer);
+			}
+
+			m_InFlightBatches.pop_front();
+		}
+	}
+
+	VkCommandBuffer UploadManager::AcquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeCommandBuffers)
+	{
+		if (!freeCommandBuffers.empty())
+		{
+			VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+			freeCommandBuffers.pop_back();
+			vkResetCommandBuffer(commandBuffer, 0);
+			return commandBuffer;
+		}
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = pool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+
+		if (vkAllocateCommandBuffers(m_Device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			TPS_CORE_ERROR("Failed to allocate upload command buffer!");
+			return VK_NULL_HANDLE;
+		}
+
+		return commandBuffer;
+	}
+
+	bool UploadManager::QueueGraphicsReleases(SubmitBatch& batch, VkCommandBuffer& outReleaseCommandBuffer,
+		std::vector<VkBufferMemoryBarrier2>& outTransferAcquires)
+	{
+		std::vector<VkBuffer> buffers;
+
+		for (const PendingBufferCopy& copy : m_PendingBufferCopies)
+		{
+			if (m_GraphicsOwnedBuffers.count(copy.Dst) > 0 && std::find(buffers.begin(), buffers.end(), copy.Dst) == buffers.end())
+			{
+				buffers.push_back(copy.Dst);
+			}
+		}
+
+		if (buffers.empty())
+		{
+			return true;
+		}
+
+		VkCommandBuffer commandBuffer = AcquireCommandBuffer(m_GraphicsCommandPool, m_FreeGraphicsCommandBuffers);
+
+		if (commandBuffer == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		// Ownership belongs to the whole buffer, not the ranges graphics read. The release comes after every earlier
+		// graphics submission in queue order, so reads of the old contents are done before the copy overwrites them
+		std::vector<VkBufferMemoryBarrier2> releases;
+
+		for (VkBuffer buffer : buffers)
+		{
+			VkBufferMemoryBarrier2 barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+			barrier.srcAccessMask = VK_ACCESS_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.dstAccessMask = VK_ACCESS_2_NONE;
+			barrier.srcQueueFamilyIndex = m_GraphicsFamily;
+			barrier.dstQueueFamilyIndex = m_TransferFamily;
+			barrier.buffer = buffer;
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+			releases.push_back(barrier);
+
+			barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+			barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+			barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			outTransferAcquires.push_back(barrier);
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkDependencyInfo dependencyInfo{};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(releases.size());
+		dependencyInfo.pBufferMemoryBarriers = releases.data();
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			m_FreeGraphicsCommandBuffers.push_back(commandBuffer);
+			outTransferAcquires.clear();
+			return false;
+		}
+
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			m_FreeGraphicsCommandBuffers.push_back(commandBuffer);
+			outTransferAcquires.clear();
+			return false;
+		}
+
+		m_ReleaseValue++;
+
+		batch.Begin(m_GraphicsQueue)
+			.AddCommandBuffer(commandBuffer)
+			.AddSignal(m_ReleaseSemaphore, m_ReleaseValue);
+
+		// The transfer queue owns them again until the copy's own release
+		for (VkBuffer buffer : buffers)
+		{
+			m_GraphicsOwnedBuffers.erase(buffer);
+		}
+
+		outReleaseCommandBuffer = commandBuffer;
+		return true;
+	}
+
+}
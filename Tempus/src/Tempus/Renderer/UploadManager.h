@@ -0,0 +1,155 @@
+// Copyright Levi Spevakow (C) 2025
+
+#pragma once
+
+#include "Core.h"
+#include "GPUAllocator.h"
+#include "SubmitBatch.h"
+
+#include "vulkan/vulkan.h"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+namespace Tempus {
+
+	// Asynchronous uploads through a persistently mapped staging ring.
+	// Upload calls are thread safe and only copy into the ring. The render thread calls Flush() once per frame
+	// which records every pending copy into one command buffer and queues it for the transfer queue on the frame's batch.
+	// Completion is tracked with a timeline semaphore, so callers can fire and forget or poll the returned value.
+	//
+	// Destination resources must use VK_SHARING_MODE_EXCLUSIVE. When the transfer queue lives in its own family,
+	// ownership is released on the transfer queue and acquired by the next graphics command buffer. Buffers written
+	// again once graphics owns them are first released by a graphics queue submission and acquired back by the copy.
+	// Images are expected to be uploaded once, right after creation
+	class TEMPUS_API UploadManager
+	{
+	public:
+
+		static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+		UploadManager() = default;
+		~UploadManager();
+
+		bool Init(VkDevice device, GPUAllocator* allocator, VkQueue transferQueue, uint32_t transferFamily, VkQueue graphicsQueue,
+			uint32_t graphicsFamily, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+		void Shutdown();
+
+		// Returns the timeline value that signals once the copy has executed
+		uint64_t UploadBuffer(VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+		// Uploads mip 0 / layer 0 of a colour image, leaving it in finalLayout
+		uint64_t UploadImage(VkImage dst, VkExtent3D extent, const void* data, VkDeviceSize size,
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		// Queues all pending copies as one submission on batch, which the caller flushes. Returns the timeline value the
+		// next graphics submission has to wait on, or 0 when nothing was queued
+		uint64_t Flush(SubmitBatch& batch);
+
+		// Records the queue family acquire barriers matching the releases of the last Flush()
+		void RecordAcquireBarriers(VkCommandBuffer commandBuffer);
+		// Drops the buffer's ownership tracking. Call before destroying a buffer that was uploaded to
+		void Forget(VkBuffer buffer);
+
+		bool IsComplete(uint64_t value) const;
+		// The batch holding value must have been flushed, otherwise this never returns
+		void Wait(uint64_t value) const;
+
+		VkSemaphore GetTimelineSemaphore() const { return m_TimelineSemaphore; }
+		bool HasDedicatedTransferQueue() const { return m_TransferFamily != m_GraphicsFamily; }
+
+	private:
+
+		struct PendingBufferCopy
+		{
+			VkBuffer Src = VK_NULL_HANDLE;
+			VkBuffer Dst = VK_NULL_HANDLE;
+			VkBufferCopy Region{};
+		};
+
+		struct PendingImageCopy
+		{
+			VkBuffer Src = VK_NULL_HANDLE;
+			VkImage Dst = VK_NULL_HANDLE;
+			VkBufferImageCopy Region{};
+			VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		};
+
+		// Staging buffer for uploads that don't fit in the ring, freed once its batch completes
+		struct OversizedStaging
+		{
+			VkBuffer Buffer = VK_NULL_HANDLE;
+			GPUAllocation Allocation;
+		};
+
+		struct InFlightBatch
+		{
+			uint64_t Value = 0;
+			// Ring bytes (including alignment and wrap padding) consumed by this batch
+			VkDeviceSize RingBytes = 0;
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			// Graphics queue command buffer handing buffers back to the transfer queue, if any
+			VkCommandBuffer ReleaseCommandBuffer = VK_NULL_HANDLE;
+			std::vector<OversizedStaging> Oversized;
+			// Flush count of the submit batch when this was queued. Until the batch moves past it nothing can be waited on
+			uint64_t FlushCount = 0;
+		};
+
+		// Returns the buffer and offset to write into, or VK_NULL_HANDLE on failure. Callers of these hold m_Mutex.
+		// AllocateStaging() unlocks it while waiting for the GPU to free ring space
+		VkBuffer AllocateStaging(std::unique_lock<std::mutex>& lock, VkDeviceSize size, VkDeviceSize& outOffset, void*& outMapped);
+		bool TryAllocateFromRing(VkDeviceSize size, VkDeviceSize& outOffset);
+		void ReclaimCompletedBatches();
+		VkCommandBuffer AcquireCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeCommandBuffers);
+		// Records and queues on batch the graphics queue releases of buffers graphics owns that this flush writes again.
+		// Returns false on failure, leaves outReleaseCommandBuffer null when there was nothing to release
+		bool QueueGraphicsReleases(SubmitBatch& batch, VkCommandBuffer& outReleaseCommandBuffer,
+			std::vector<VkBufferMemoryBarrier2>& outTransferAcquires);
+
+	private:
+
+		VkDevice m_Device = VK_NULL_HANDLE;
+		GPUAllocator* m_Allocator = nullptr;
+
+		VkQueue m_TransferQueue = VK_NULL_HANDLE;
+		uint32_t m_TransferFamily = 0;
+		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
+		uint32_t m_GraphicsFamily = 0;
+
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+		// Dedicated transfer queue only, for the releases handing buffers back from graphics
+		VkCommandPool m_GraphicsCommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> m_FreeGraphicsCommandBuffers;
+		VkSemaphore m_ReleaseSemaphore = VK_NULL_HANDLE;
+		uint64_t m_ReleaseValue = 0;
+		// Buffers whose ownership the graphics queue has acquired, or will with the next RecordAcquireBarriers()
+		std::unordered_set<VkBuffer> m_GraphicsOwnedBuffers;
+
+		VkSemaphore m_TimelineSemaphore = VK_NULL_HANDLE;
+		uint64_t m_SubmittedValue = 0;
+		// Batch the last Flush() queued on
+		const SubmitBatch* m_SubmitBatch = nullptr;
+
+		// Staging ring. Head is where the next allocation goes, used counts the bytes the GPU may still read behind it
+		VkBuffer m_StagingBuffer = VK_NULL_HANDLE;
+		GPUAllocation m_StagingAllocation;
+		VkDeviceSize m_StagingSize = 0;
+		VkDeviceSize m_RingHead = 0;
+		VkDeviceSize m_RingUsed = 0;
+		VkDeviceSize m_PendingRingBytes = 0;
+		VkDeviceSize m_CopyAlignment = 16;
+
+		std::vector<PendingBufferCopy> m_PendingBufferCopies;
+		std::vector<PendingImageCopy> m_PendingImageCopies;
+		std::vector<OversizedStaging> m_PendingOversized;
+		std::deque<InFlightBatch> m_InFlightBatches;
+
+		std::vector<VkBufferMemoryBarrier2> m_PendingBufferAcquires;
+		std::vector<VkImageMemoryBarrier2> m_PendingImageAcquires;
+
+		mutable std::mutex m_Mutex;
+
+	};
+
+}
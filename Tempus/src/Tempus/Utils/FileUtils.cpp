@@ -39,6 +39,59 @@ std::vector<char> Tempus::FileUtils::ReadFile(const std::string& filename)
 
 }
 
+bool Tempus::FileUtils::FileExists(const std::string& filename)
+{
+    std::error_code error;
+    return std::filesystem::is_regular_file(filename, error);
+}
+
+bool Tempus::FileUtils::WriteFileAtomic(const std::string& filename, const void* data, size_t size)
+{
+    std::filesystem::path path(filename);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+
+    std::error_code error;
+
+    if (path.has_parent_path())
+    {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+        if (!file.is_open())
+        {
+            TPS_CORE_ERROR("Failed to open file {0}", tempPath.string());
+            return false;
+        }
+
+        file.write(static_cast<const char*>(data), size);
+        file.flush();
+
+        if (!file.good())
+        {
+            TPS_CORE_ERROR("Failed to write file {0}", tempPath.string());
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    // Rename replaces the target in a single step
+    std::filesystem::rename(tempPath, path, error);
+
+    if (error)
+    {
+        TPS_CORE_ERROR("Failed to replace file {0}: {1}", filename, error.message());
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    return true;
+}
+
 void Tempus::FileUtils::PrintAbsolutePath(const std::string &relativePath)
 {
     try 
@@ -14,6 +14,10 @@ namespace Tempus
     public:
 
         static std::vector<char> ReadFile(const std::string& filename);
+        static bool FileExists(const std::string& filename);
+        // Writes to a temporary file next to the target and renames it over the target,
+        // so a crash mid write never leaves a truncated file behind
+        static bool WriteFileAtomic(const std::string& filename, const void* data, size_t size);
         static void PrintAbsolutePath(const std::string& relativePath);
         static std::string GetExecutablePath();
         static void SetWorkingDirectory(const std::string& directory);
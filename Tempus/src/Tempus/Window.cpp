@@ -31,5 +31,10 @@ namespace Tempus {
 		return m_Window;
 	}
 
+	bool Window::IsMinimized() const
+	{
+		return m_Window && (SDL_GetWindowFlags(m_Window) & SDL_WINDOW_MINIMIZED);
+	}
+
 }
 
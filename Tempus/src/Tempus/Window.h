@@ -20,6 +20,8 @@ namespace Tempus {
 
 		SDL_Window* GetNativeWindow() const;
 
+		bool IsMinimized() const;
+
 	private:
 
 		SDL_Window* m_Window = nullptr;
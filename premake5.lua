@@ -63,6 +63,12 @@ project "Tempus"
             "/wd4251"
         }
 
+        -- Compiles the shaders and regenerates the embedded SPIR-V before the engine is built
+        prebuildcommands
+        {
+            "cd .. && call CompileShaders.bat nopause"
+        }
+
         postbuildcommands
         {
             "{RMDIR} ../bin/" .. outputdir .. "/Sandbox",
@@ -99,6 +105,11 @@ project "Tempus"
             "TPS_BUILD_DLL"
         }
 
+        prebuildcommands
+        {
+            "cd .. && sh CompileShadersMac.sh"
+        }
+
         postbuildcommands
         {
             "{RMDIR} ../bin/" .. outputdir .. "/Sandbox",
@@ -141,6 +152,7 @@ project "Sandbox"
     includedirs
     {
         "Tempus/src",
+        "Tempus/src/Tempus",
         path.join(os.getenv("VULKAN_SDK"), "Include"),
         "Tempus/vendor/include"
     }